@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Builds every finished project, runs its bench target and merges the reports into one JSON file.
+
+    python run_bench.py --cmake-args='-DCMAKE_PREFIX_PATH="C:/Program Files (x86)/GLFW/lib/cmake/glfw3" -DGLM_PATH=C:/glm'
+
+Each project is built in its own build folder, CMake compiles the shaders into the app and finds glslc by itself,
+--glslc only overrides the one it picks. Compare two runs with --baseline to see the change per project.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import shlex
+import subprocess
+
+PROJECTS = [
+    "sierpinski-triangle",
+    "rotating-cube",
+    "mesh-division",
+    "cube-builder",
+    "model-loading",
+    "mesh-shooter",
+]
+
+CODE_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PROJECTS_DIR = os.path.join(CODE_DIR, "finished-projects")
+
+
+def run(command, cwd=None):
+    print("> " + " ".join(command), flush=True)
+    subprocess.run(command, cwd=cwd, check=True)
+
+
+def bench_project(project, args):
+    project_dir = os.path.join(PROJECTS_DIR, project)
+    build_dir = os.path.join(project_dir, "build")
+
+    if not args.skip_build:
+        configure = ["cmake", "-S", project_dir, "-B", build_dir, "-DCMAKE_BUILD_TYPE=" + args.config]
+        if args.glslc:
+            configure.append("-DGLSLC_EXECUTABLE=" + args.glslc)
+        configure += shlex.split(args.cmake_args)
+        run(configure)
+
+    report_path = os.path.join(build_dir, "bench.json")
+    if os.path.exists(report_path):
+        os.remove(report_path)
+
+    run(["cmake", "--build", build_dir, "--config", args.config, "--target", "bench"])
+
+    with open(report_path) as report_file:
+        return json.load(report_file)
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "--short", "HEAD"], cwd=CODE_DIR, text=True).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def print_summary(results, baseline):
+    print()
+    print("{:<22}{:>10}{:>10}{:>10}{:>10}{:>14}".format("project", "mean ms", "p50 ms", "p99 ms", "max ms", "allocs/frame"))
+    for project, report in results["projects"].items():
+        frame_time = report["frame_time_ms"]
+        row = "{:<22}{:>10.3f}{:>10.3f}{:>10.3f}{:>10.3f}{:>14.1f}".format(
+            project, frame_time["mean"], frame_time["p50"], frame_time["p99"], frame_time["max"], report["allocations"]["per_frame"])
+        if baseline and project in baseline["projects"]:
+            baseline_mean = baseline["projects"][project]["frame_time_ms"]["mean"]
+            if baseline_mean > 0:
+                row += "  {:+.1f}% mean".format((frame_time["mean"] / baseline_mean - 1.0) * 100.0)
+        print(row)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--projects", nargs="+", choices=PROJECTS, default=PROJECTS)
+    parser.add_argument("--cmake-args", default="", help="extra configure arguments, split like a shell would")
+    parser.add_argument("--config", default="Release")
+    parser.add_argument("--glslc", help="path of glslc, passed to CMake as GLSLC_EXECUTABLE")
+    parser.add_argument("--skip-build", action="store_true", help="only run the bench targets of existing build folders")
+    parser.add_argument("--output", default="bench_results.json")
+    parser.add_argument("--baseline", help="an earlier output to compare against")
+    args = parser.parse_args()
+
+    results = {
+        "revision": git_revision(),
+        "date": datetime.datetime.now().isoformat(timespec="seconds"),
+        "config": args.config,
+        "projects": {},
+    }
+    for project in args.projects:
+        results["projects"][project] = bench_project(project, args)
+
+    with open(args.output, "w") as output_file:
+        json.dump(results, output_file, indent=2)
+
+    baseline = None
+    if args.baseline:
+        with open(args.baseline) as baseline_file:
+            baseline = json.load(baseline_file)
+    print_summary(results, baseline)
+    print("\nWrote " + os.path.abspath(args.output))
+
+
+if __name__ == "__main__":
+    main()
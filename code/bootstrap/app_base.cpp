@@ -10,7 +10,12 @@
 
 #include "app_base.hpp"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 
 #include "toolset.hpp"
 #include "initializers.hpp"
@@ -38,14 +43,195 @@ CameraCreateInfo cameraCI =
     200.0f                          // far
 };
 
-AppBase::AppBase() : camera(cameraCI)
+static constexpr uint32_t OFFSCREEN_IMAGE_COUNT = 3;
+static constexpr uint32_t PRESENT_TUNING_FRAME_COUNT = 120;
+static constexpr uint32_t BENCHMARK_FRAME_COUNT = 600;
+
+static VkPresentModeKHR ParsePresentMode(const std::string& name)
+{
+    if (name == "immediate")
+    {
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+    if (name == "mailbox")
+    {
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+    }
+    if (name == "relaxed")
+    {
+        return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    }
+    if (name != "fifo")
+    {
+        std::cerr << "Unknown present mode " << name << ", using fifo." << std::endl;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+static float MillisecondsSince(std::chrono::steady_clock::time_point start)
 {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+AppBaseCreateInfo ParseCommandLine(int argc, char* argv[])
+{
+    AppBaseCreateInfo createInfo{};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (argument == "--headless")
+        {
+            createInfo.isHeadless = true;
+        }
+        else if (argument == "--no-validation")
+        {
+            createInfo.isValidationEnabled = false;
+        }
+        else if (argument == "--frames-in-flight" && hasValue)
+        {
+            createInfo.framesInFlight = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (argument == "--threads" && hasValue)
+        {
+            createInfo.workerThreadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (argument == "--tick-rate" && hasValue)
+        {
+            createInfo.fixedTimeStep = 1.0f / std::stof(argv[++i]);
+        }
+        else if (argument == "--frames" && hasValue)
+        {
+            createInfo.frameLimit = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (argument == "--capture-interval" && hasValue)
+        {
+            createInfo.captureInterval = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (argument == "--capture-dir" && hasValue)
+        {
+            createInfo.captureDirectory = argv[++i];
+        }
+        else if (argument == "--gpu-profile" && hasValue)
+        {
+            createInfo.gpuProfilePath = argv[++i];
+        }
+        else if (argument == "--cpu-profile" && hasValue)
+        {
+            createInfo.cpuProfilePath = argv[++i];
+        }
+        else if (argument == "--present-mode" && hasValue)
+        {
+            std::string presentMode = argv[++i];
+            createInfo.isPresentPolicyEnabled = presentMode == "auto";
+            if (!createInfo.isPresentPolicyEnabled)
+            {
+                createInfo.presentMode = ParsePresentMode(presentMode);
+            }
+        }
+        else if (argument == "--max-latency" && hasValue)
+        {
+            createInfo.presentPolicy.maxLatencyMilliseconds = std::stof(argv[++i]);
+        }
+        else if (argument == "--min-fps" && hasValue)
+        {
+            createInfo.presentPolicy.minFramesPerSecond = std::stof(argv[++i]);
+        }
+        else if (argument == "--allow-tearing")
+        {
+            createInfo.presentPolicy.allowTearing = true;
+        }
+        else if (argument == "--pacing-report" && hasValue)
+        {
+            createInfo.pacingReportPath = argv[++i];
+        }
+        else if (argument == "--input-script" && hasValue)
+        {
+            createInfo.inputScriptPath = argv[++i];
+        }
+        else if (argument == "--bench" && hasValue)
+        {
+            createInfo.benchmarkReportPath = argv[++i];
+        }
+        else if (argument == "--bench-warmup" && hasValue)
+        {
+            createInfo.benchmarkWarmupFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (argument == "--memory-stats")
+        {
+            createInfo.isMemoryStatsEnabled = true;
+        }
+        else if (argument == "--pipeline-cache" && hasValue)
+        {
+            createInfo.pipelineCachePath = argv[++i];
+        }
+        else if (argument == "--no-pipeline-cache")
+        {
+            createInfo.pipelineCachePath.clear();
+        }
+        else
+        {
+            std::cerr << "Ignoring unknown argument: " << argument << std::endl;
+        }
+    }
+
+    return createInfo;
+}
+
+AppBase::AppBase() : AppBase(AppBaseCreateInfo{}) {}
+
+AppBase::AppBase(const AppBaseCreateInfo& createInfo) : camera(cameraCI), _createInfo(createInfo)
+{
+    if (!_createInfo.cpuProfilePath.empty() || !_createInfo.benchmarkReportPath.empty())
+    {
+        CpuProfiler::GetInstance()->SetThreadName("Main");
+        CpuProfiler::GetInstance()->Enable();
+    }
+
     Init();
 }
 
 AppBase::~AppBase()
 {
     vkDeviceWaitIdle(device);
+
+    if (!_createInfo.benchmarkReportPath.empty())
+    {
+        _benchmark.WriteReport(_createInfo.benchmarkReportPath, _createInfo.benchmarkWarmupFrames, gpuProfiler.GetTimings());
+    }
+
+    if (!_createInfo.gpuProfilePath.empty() && gpuProfiler.IsEnabled())
+    {
+        const std::string& path = _createInfo.gpuProfilePath;
+        if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0)
+        {
+            gpuProfiler.WriteJson(path);
+        }
+        else
+        {
+            gpuProfiler.WriteCsv(path);
+        }
+    }
+
+    if (!_createInfo.pacingReportPath.empty())
+    {
+        _framePacing.PrintSummary();
+        _framePacing.WriteReport(_createInfo.pacingReportPath);
+    }
+
+    if (!_createInfo.cpuProfilePath.empty())
+    {
+        CpuProfiler::GetInstance()->Disable();
+        CpuProfiler::GetInstance()->WriteChromeTrace(_createInfo.cpuProfilePath);
+    }
+
+    if (_createInfo.isMemoryStatsEnabled)
+    {
+        _gpuAllocator.PrintStats();
+    }
+
     _deletionQueue.Flush();
 }
 
@@ -53,13 +239,59 @@ void AppBase::Run()
 {
     isAppRunning = true;
 
-    while (!glfwWindowShouldClose(window) && isAppRunning)
+    while (isAppRunning && (IsHeadless() || !glfwWindowShouldClose(window)))
     {
-        glfwPollEvents();
+        CPU_PROFILE_SCOPE("AppBase::Run");
+
+        // Started ahead of the frame rather than after the previous one, so a warmup of 0 measures from the first.
+        if (!_benchmark.IsRunning() && !_createInfo.benchmarkReportPath.empty() && _frameCount == _createInfo.benchmarkWarmupFrames)
+        {
+            _benchmark.Begin();
+        }
+
+        if (!IsHeadless())
+        {
+            glfwPollEvents();
+        }
+        _inputScript.Apply(_frameCount, *inputManager);
+        if (inputManager->GetInputEventCount() != _lastInputEventCount)
+        {
+            _lastInputEventCount = inputManager->GetInputEventCount();
+            _framePacing.MarkInput();
+        }
         inputManager->Update();
         timer.Update();
-        
-        Update();
+        uploadManager.Retire();
+
+        _fixedTimeAccumulator += timer.GetDeltaTime();
+        uint32_t stepCount = 0;
+        while (_fixedTimeAccumulator >= _createInfo.fixedTimeStep && stepCount < _createInfo.maxFixedStepsPerFrame)
+        {
+            CPU_PROFILE_SCOPE("FixedUpdate");
+            FixedUpdate(_createInfo.fixedTimeStep);
+            _fixedTimeAccumulator -= _createInfo.fixedTimeStep;
+            ++stepCount;
+        }
+        if (_fixedTimeAccumulator >= _createInfo.fixedTimeStep)
+        {
+            _fixedTimeAccumulator = std::fmod(_fixedTimeAccumulator, _createInfo.fixedTimeStep);
+        }
+
+        {
+            CPU_PROFILE_SCOPE("Update");
+            Update();
+        }
+
+        ++_frameCount;
+        if (_benchmark.IsRunning())
+        {
+            _benchmark.MarkFrame();
+        }
+
+        if (_createInfo.frameLimit > 0 && _frameCount >= _createInfo.frameLimit)
+        {
+            ExitApp();
+        }
     }
 }
 
@@ -68,12 +300,98 @@ void AppBase::ExitApp()
     isAppRunning = false;
 }
 
+float AppBase::GetFixedTimeStep() const
+{
+    return _createInfo.fixedTimeStep;
+}
+
+float AppBase::GetInterpolationAlpha() const
+{
+    return _fixedTimeAccumulator / _createInfo.fixedTimeStep;
+}
+
+bool AppBase::IsHeadless() const
+{
+    return _createInfo.isHeadless;
+}
+
+uint32_t AppBase::AcquireNextImage(VkSemaphore imageAvailableSemaphore)
+{
+    uint32_t imageIndex;
+
+    if (!IsHeadless())
+    {
+        CPU_PROFILE_SCOPE("vkAcquireNextImageKHR");
+        auto acquireStart = std::chrono::steady_clock::now();
+        vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+        _framePacing.AddBlockedTime(MillisecondsSince(acquireStart));
+        return imageIndex;
+    }
+
+    // There is no presentation engine handing out images, so we signal the semaphore ourselves
+    // and the caller can wait on it exactly as it would on a swapchain image.
+    imageIndex = _offscreen.nextImage;
+    _offscreen.nextImage = (_offscreen.nextImage + 1) % swapchain.imageCount;
+
+    VkSubmitInfo submitInfo = init::SubmitInfo(0, nullptr, nullptr, 0, nullptr, 1, &imageAvailableSemaphore);
+    VK_CHECK_RESULT(vkQueueSubmit(device.queues.graphics, 1, &submitInfo, VK_NULL_HANDLE));
+
+    return imageIndex;
+}
+
+void AppBase::PresentImage(VkSemaphore renderFinishedSemaphore, uint32_t imageIndex)
+{
+    _framePacing.AddBlockedTime(frameContext.GetLastFenceWaitMilliseconds());
+
+    if (!IsHeadless())
+    {
+        VkPresentInfoKHR presentInfo = init::PresentInfoKHR(1, &renderFinishedSemaphore, &swapchain.swapchain, &imageIndex);
+        {
+            CPU_PROFILE_SCOPE("vkQueuePresentKHR");
+            auto presentStart = std::chrono::steady_clock::now();
+            vkQueuePresentKHR(device.queues.present, &presentInfo);
+            _framePacing.AddBlockedTime(MillisecondsSince(presentStart));
+        }
+        _framePacing.MarkPresent();
+        TunePresentMode();
+        return;
+    }
+
+    _framePacing.MarkPresent();
+
+    bool isCaptureFrame = _createInfo.captureInterval > 0 && _frameCount % _createInfo.captureInterval == 0;
+    if (isCaptureFrame)
+    {
+        char fileName[32];
+        std::snprintf(fileName, sizeof(fileName), "frame_%06u.ppm", _frameCount);
+        SaveImage(imageIndex, renderFinishedSemaphore, _createInfo.captureDirectory + "/" + fileName);
+        return;
+    }
+
+    // Nothing to present, but the semaphore still has to be waited on before it can be signaled again.
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    VkSubmitInfo submitInfo = init::SubmitInfo(1, &renderFinishedSemaphore, &waitStage, 0, nullptr, 0, nullptr);
+    VK_CHECK_RESULT(vkQueueSubmit(device.queues.graphics, 1, &submitInfo, VK_NULL_HANDLE));
+}
+
 void AppBase::Init()
 {
     InitGLFW();
     InitVulkan();
-    InitSwapchain();
+    if (IsHeadless())
+    {
+        InitOffscreenTargets();
+    }
+    else
+    {
+        InitSwapchain();
+    }
+    InitFrameContext();
+    InitGpuProfiler();
+    InitUploadManager();
+    InitUniformRing();
     InitInputManager();
+    InitBenchmark();
     InitDepthBuffer();
     InitRenderPass();
     InitFramebuffers();
@@ -81,6 +399,12 @@ void AppBase::Init()
 
 void AppBase::InitGLFW()
 {
+    if (IsHeadless())
+    {
+        window = nullptr;
+        return;
+    }
+
     glfwInit();
     ENQUEUE_OBJ_DEL(( []() { glfwTerminate(); } ));
 
@@ -93,49 +417,270 @@ void AppBase::InitGLFW()
 void AppBase::InitVulkan()
 {
     InstanceBuilder builder;
-    Instance instances = builder.SetApplicationName("Vulkan app")
-                                .SetApplicationVersion(VK_MAKE_VERSION(1, 0,0 ))
-                                .SetEngineName("No engine")
-                                .SetEngineVersion(VK_MAKE_VERSION(1, 0, 0))
-                                .SetApiVersion(VK_MAKE_VERSION(1, 1, 0))
-                                .RequestDefaultLayers()
-                                .RequestDefaultExtensions()
-                                .UseDebugMessenger()
-                                .Build();
+    builder.SetApplicationName("Vulkan app")
+           .SetApplicationVersion(VK_MAKE_VERSION(1, 0,0 ))
+           .SetEngineName("No engine")
+           .SetEngineVersion(VK_MAKE_VERSION(1, 0, 0))
+           .SetApiVersion(VK_MAKE_VERSION(1, 1, 0))
+           .RequestDefaultExtensions();
+    if (_createInfo.isValidationEnabled)
+    {
+        builder.RequestDefaultLayers()
+               .UseDebugMessenger();
+    }
+    if (IsHeadless())
+    {
+        builder.EnableHeadless();
+    }
+    Instance instances = builder.Build();
     instance = instances.instance;
     ENQUEUE_OBJ_DEL(( [this]() { vkDestroyInstance(instance, nullptr); } ));
 
     debugMessenger = instances.debugMessenger;
     ENQUEUE_OBJ_DEL(( [this]() { DestroyDebugMessenger(instance, debugMessenger); } ));
 
-    VK_CHECK_RESULT(glfwCreateWindowSurface(instance, window, nullptr, &surface));
-    ENQUEUE_OBJ_DEL(( [this]() { vkDestroySurfaceKHR(instance, surface, nullptr); } ));
+    surface = VK_NULL_HANDLE;
+    if (!IsHeadless())
+    {
+        VK_CHECK_RESULT(glfwCreateWindowSurface(instance, window, nullptr, &surface));
+        ENQUEUE_OBJ_DEL(( [this]() { vkDestroySurfaceKHR(instance, surface, nullptr); } ));
+    }
 
+    // Headless runs typically land on software rasterizers like lavapipe, so any device type will do.
     PhysicalDeviceSelector physicalDeviceSelector{instance, surface};
-    physicalDevice = physicalDeviceSelector.EnableDedicatedGPU()
-                                           .Select();
+    if (IsHeadless())
+    {
+        physicalDeviceSelector.EnableHeadless();
+    }
+    else
+    {
+        physicalDeviceSelector.EnableDedicatedGPU();
+    }
+    physicalDevice = physicalDeviceSelector.Select();
     
     DeviceBuilder deviceBuilder{physicalDevice};
-    device = deviceBuilder.EnableValidationLayers()
-                          .Build();
+    if (_createInfo.isValidationEnabled)
+    {
+        deviceBuilder.EnableValidationLayers();
+    }
+    device = deviceBuilder.Build();
     ENQUEUE_OBJ_DEL(( [this]() { vkDestroyDevice(device, nullptr); } ));
+
+    _gpuAllocator.Init(device, physicalDevice);
+    device.allocator = &_gpuAllocator;
+    ENQUEUE_OBJ_DEL(( [this]() { _gpuAllocator.Destroy(); } ));
+
+    // Saved on the way out, after the apps destroyed their pipelines but while the device is still alive.
+    pipelineCache.Init(device, physicalDevice, _createInfo.pipelineCachePath);
+    ENQUEUE_OBJ_DEL(( [this]() { pipelineCache.Save(); pipelineCache.Destroy(); } ));
+
+    shaderModuleCache.Init(device);
+    ENQUEUE_OBJ_DEL(( [this]() { shaderModuleCache.Destroy(); } ));
+
+    // Leaves the main thread a core, compiles are short but there can be a burst of them at startup.
+    uint32_t compileThreadCount = std::max(1u, ThreadPool::GetHardwareThreadCount() - 1);
+    pipelines.Init(device, pipelineCache, std::min(compileThreadCount, 4u));
+    ENQUEUE_OBJ_DEL(( [this]() { pipelines.Destroy(); } ));
 }
 
 void AppBase::InitSwapchain()
+{
+    CreateSwapchain(_createInfo.presentPolicy, VK_NULL_HANDLE);
+    ENQUEUE_OBJ_DEL(( [this]() { DestroySwapchain(swapchain); } ));
+}
+
+void AppBase::CreateSwapchain(const PresentPolicy& presentPolicy, VkSwapchainKHR oldSwapchain)
 {
     SwapchainBuilder builder(window, surface, physicalDevice, device);
-    swapchain = builder.SetDesiredFormat(VK_FORMAT_B8G8R8A8_SRGB)
-                       .SetDesiredColorSpace(VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
-                       .SetDesiredPresentMode(VK_PRESENT_MODE_MAILBOX_KHR)
-                       .SetDesiredExtent(WINDOW_WIDTH, WINDOW_HEIGHT)
-                       .SetDesiredImageCount(physicalDevice.swapchainSupportDetails.capabilities.minImageCount + 1)
-                       .SetDesiredArrayLayerCount(1)
-                       .SetImageFlags(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
-                       .Build();
-    ENQUEUE_OBJ_DEL(( [this]() { vkDestroySwapchainKHR(device, swapchain, nullptr); } ));
-    for (auto& imageView : swapchain.imageViews)
+    builder.SetDesiredFormat(VK_FORMAT_B8G8R8A8_SRGB)
+           .SetDesiredColorSpace(VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+           .SetDesiredExtent(WINDOW_WIDTH, WINDOW_HEIGHT)
+           .SetDesiredArrayLayerCount(1)
+           .SetImageFlags(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+           .SetOldSwapchain(oldSwapchain);
+
+    if (_createInfo.isPresentPolicyEnabled)
+    {
+        builder.SetPresentPolicy(presentPolicy);
+        _presentConfig = builder.SelectPresentConfig();
+    }
+    else
+    {
+        builder.SetDesiredPresentMode(_createInfo.presentMode)
+               .SetDesiredImageCount(physicalDevice.swapchainSupportDetails.capabilities.minImageCount + 1);
+    }
+
+    swapchain = builder.Build();
+}
+
+void AppBase::DestroySwapchain(Swapchain& target)
+{
+    for (VkImageView imageView : target.imageViews)
     {
-        ENQUEUE_OBJ_DEL(( [&]() { vkDestroyImageView(device, imageView, nullptr); } ));
+        vkDestroyImageView(device, imageView, nullptr);
+    }
+    vkDestroySwapchainKHR(device, target.swapchain, nullptr);
+}
+
+void AppBase::RecreateSwapchain(const PresentPolicy& presentPolicy)
+{
+    vkDeviceWaitIdle(device);
+    DestroyFramebuffers();
+
+    Swapchain oldSwapchain = swapchain;
+    CreateSwapchain(presentPolicy, oldSwapchain.swapchain);
+    DestroySwapchain(oldSwapchain);
+
+    CreateFramebuffers();
+}
+
+void AppBase::TunePresentMode()
+{
+    if (!_createInfo.isPresentPolicyEnabled || _isPresentModeTuned || _framePacing.GetPresentCount() < PRESENT_TUNING_FRAME_COUNT)
+    {
+        return;
+    }
+    _isPresentModeTuned = true;
+
+    // The first pick had to guess the frame time, now that it is measured the policy may land somewhere else.
+    PresentPolicy presentPolicy = _createInfo.presentPolicy;
+    presentPolicy.frameTimeMilliseconds = _framePacing.GetAverageWorkMilliseconds();
+
+    SwapchainBuilder builder(window, surface, physicalDevice, device);
+    PresentConfig presentConfig = builder.SetPresentPolicy(presentPolicy).SelectPresentConfig();
+    if (presentConfig.presentMode != _presentConfig.presentMode || presentConfig.imageCount != _presentConfig.imageCount)
+    {
+        std::cout << "Measured " << presentPolicy.frameTimeMilliseconds << " ms of work per frame, switching present mode." << std::endl;
+        RecreateSwapchain(presentPolicy);
+        _framePacing.Reset();
+    }
+}
+
+void AppBase::InitFrameContext()
+{
+    frameContext.Init(device, device.queues.graphicsFamily, _createInfo.framesInFlight);
+    ENQUEUE_OBJ_DEL(( [this]() { frameContext.Destroy(); } ));
+}
+
+void AppBase::InitGpuProfiler()
+{
+    gpuProfiler.Init(device, _createInfo.framesInFlight);
+    ENQUEUE_OBJ_DEL(( [this]() { gpuProfiler.Destroy(); } ));
+}
+
+void AppBase::InitUploadManager()
+{
+    uploadManager.Init(device);
+    ENQUEUE_OBJ_DEL(( [this]() { uploadManager.Destroy(); } ));
+}
+
+void AppBase::InitUniformRing()
+{
+    uniformRing.Init(device, _createInfo.framesInFlight, _createInfo.uniformRingFrameSize);
+    ENQUEUE_OBJ_DEL(( [this]() { uniformRing.Destroy(); } ));
+}
+
+void AppBase::InitOffscreenTargets()
+{
+    // Owned images stand in for the swapchain, so apps record the same commands with or without a window.
+    swapchain.device = device;
+    swapchain.imageCount = std::max(OFFSCREEN_IMAGE_COUNT, _createInfo.framesInFlight);
+    swapchain.imageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+    swapchain.imageUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    swapchain.extent = {static_cast<uint32_t>(WINDOW_WIDTH), static_cast<uint32_t>(WINDOW_HEIGHT)};
+    swapchain.images.resize(swapchain.imageCount);
+    swapchain.imageViews.resize(swapchain.imageCount);
+    _offscreen.imageMemories.resize(swapchain.imageCount);
+
+    for (uint32_t i = 0; i < swapchain.imageCount; ++i)
+    {
+        CreateImage(swapchain.extent.width, swapchain.extent.height, swapchain.imageFormat, VK_IMAGE_TILING_OPTIMAL, swapchain.imageUsageFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapchain.images[i], _offscreen.imageMemories[i]);
+        swapchain.imageViews[i] = CreateImageView(swapchain.images[i], swapchain.imageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+        ENQUEUE_OBJ_DEL(( [this, i]() {
+            vkDestroyImageView(device, swapchain.imageViews[i], nullptr);
+            vkDestroyImage(device, swapchain.images[i], nullptr);
+            _gpuAllocator.Free(_offscreen.imageMemories[i]);
+        } ));
+    }
+
+    VkCommandPoolCreateInfo commandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    VK_CHECK_RESULT(vkCreateCommandPool(device, &commandPoolCI, nullptr, &_offscreen.commandPool));
+    ENQUEUE_OBJ_DEL(( [this]() { vkDestroyCommandPool(device, _offscreen.commandPool, nullptr); } ));
+
+    VkCommandBufferAllocateInfo commandBufferAI = init::CommandBufferAllocateInfo(_offscreen.commandPool, 1);
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &commandBufferAI, &_offscreen.commandBuffer));
+
+    VkFenceCreateInfo fenceCI = init::FenceCreateInfo();
+    VK_CHECK_RESULT(vkCreateFence(device, &fenceCI, nullptr, &_offscreen.readbackFence));
+    ENQUEUE_OBJ_DEL(( [this]() { vkDestroyFence(device, _offscreen.readbackFence, nullptr); } ));
+
+    VkDeviceSize readbackSize = static_cast<VkDeviceSize>(swapchain.extent.width) * swapchain.extent.height * 4;
+    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &_offscreen.readbackBuffer, readbackSize));
+    ENQUEUE_OBJ_DEL(( [this]() { _offscreen.readbackBuffer.Destroy(); } ));
+    VK_CHECK_RESULT(_offscreen.readbackBuffer.Map());
+}
+
+void AppBase::SaveImage(uint32_t imageIndex, VkSemaphore renderFinishedSemaphore, const std::string& path)
+{
+    CPU_PROFILE_SCOPE("SaveImage");
+
+    VkCommandBuffer cmd = _offscreen.commandBuffer;
+    vkResetCommandBuffer(cmd, 0);
+
+    VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+
+    // The headless render pass already leaves the color attachment in TRANSFER_SRC_OPTIMAL.
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {swapchain.extent.width, swapchain.extent.height, 1};
+    vkCmdCopyImageToBuffer(cmd, swapchain.images[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, _offscreen.readbackBuffer.buffer, 1, &region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = _offscreen.readbackBuffer.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkSubmitInfo submitInfo = init::SubmitInfo(1, &renderFinishedSemaphore, &waitStage, 1, &cmd, 0, nullptr);
+    VK_CHECK_RESULT(vkQueueSubmit(device.queues.graphics, 1, &submitInfo, _offscreen.readbackFence));
+    VK_CHECK_RESULT(vkWaitForFences(device, 1, &_offscreen.readbackFence, VK_TRUE, UINT64_MAX));
+    VK_CHECK_RESULT(vkResetFences(device, 1, &_offscreen.readbackFence));
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open capture file!");
+    }
+
+    // Binary PPM, the texels come back as B8G8R8A8 so they are swizzled row by row.
+    uint32_t width = swapchain.extent.width;
+    uint32_t height = swapchain.extent.height;
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    const unsigned char* texels = static_cast<const unsigned char*>(_offscreen.readbackBuffer.mapped);
+    std::vector<char> row(static_cast<size_t>(width) * 3);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const unsigned char* texel = texels + (static_cast<size_t>(y) * width + x) * 4;
+            row[x * 3 + 0] = static_cast<char>(texel[2]);
+            row[x * 3 + 1] = static_cast<char>(texel[1]);
+            row[x * 3 + 2] = static_cast<char>(texel[0]);
+        }
+        file.write(row.data(), row.size());
     }
 }
 
@@ -146,7 +691,7 @@ void AppBase::InitDepthBuffer()
     _depthBuffer.depthImageView = CreateImageView(_depthBuffer.depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
     ENQUEUE_OBJ_DEL(( [this]() {
         vkDestroyImage(device, _depthBuffer.depthImage, nullptr);
-        vkFreeMemory(device, _depthBuffer.depthImageMemory, nullptr);
+        _gpuAllocator.Free(_depthBuffer.depthImageMemory);
         vkDestroyImageView(device, _depthBuffer.depthImageView, nullptr);
     } ));
 }
@@ -184,7 +729,7 @@ VkFormat AppBase::FindSupportedFormat(const std::vector<VkFormat>& candidates, V
     throw std::runtime_error("failed to find supported format!");
 }
 
-void AppBase::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+void AppBase::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, GpuAllocation& imageMemory)
 {
     VkImageCreateInfo imageInfo = init::ImageCreateInfo();
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -205,13 +750,10 @@ void AppBase::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkIm
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo = init::MemoryAllocateInfo();
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = device.GetMemoryType(memRequirements.memoryTypeBits, properties);
+    GpuResourceKind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? GpuResourceKind::Image : GpuResourceKind::Buffer;
+    imageMemory = _gpuAllocator.Allocate(memRequirements, properties, kind);
 
-    VK_CHECK_RESULT(vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory));
-
-    vkBindImageMemory(device, image, imageMemory, 0);
+    VK_CHECK_RESULT(vkBindImageMemory(device, image, imageMemory.memory, imageMemory.offset));
 }
 
 VkImageView AppBase::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
@@ -242,7 +784,7 @@ void AppBase::InitRenderPass()
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = IsHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = FindDepthFormat();
@@ -290,6 +832,12 @@ void AppBase::InitRenderPass()
 }
 
 void AppBase::InitFramebuffers()
+{
+    CreateFramebuffers();
+    ENQUEUE_OBJ_DEL(( [this]() { DestroyFramebuffers(); } ));
+}
+
+void AppBase::CreateFramebuffers()
 {
     framebuffers.resize(swapchain.imageCount);
     for (int i = 0; i < framebuffers.size(); ++i)
@@ -309,14 +857,25 @@ void AppBase::InitFramebuffers()
         framebufferInfo.layers = 1;
         
         VK_CHECK_RESULT(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffers[i]));
-        ENQUEUE_OBJ_DEL(( [this, i]() { vkDestroyFramebuffer(device, framebuffers[i], nullptr); } ));
     }
 }
 
+void AppBase::DestroyFramebuffers()
+{
+    for (VkFramebuffer framebuffer : framebuffers)
+    {
+        vkDestroyFramebuffer(device, framebuffer, nullptr);
+    }
+    framebuffers.clear();
+}
+
 void AppBase::InitInputManager()
 {
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    InputManager::Init(window);
+    if (!IsHeadless())
+    {
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        InputManager::Init(window);
+    }
     inputManager = InputManager::GetInstance();
     
     inputManager->AddKeyPressListener(GLFW_KEY_ESCAPE, [&]() { ExitApp(); });
@@ -331,4 +890,33 @@ void AppBase::InitInputManager()
     inputManager->AddKeyHoldListener(GLFW_KEY_LEFT_SHIFT, [&]() { camera.MoveDown(timer.GetDeltaTime());     });
 }
 
+void AppBase::InitBenchmark()
+{
+    if (!_createInfo.inputScriptPath.empty())
+    {
+        _inputScript = InputScript::Load(_createInfo.inputScriptPath);
+    }
+
+    if (_createInfo.benchmarkReportPath.empty())
+    {
+        return;
+    }
+
+    // With wall clock deltas the camera path and the simulation would depend on how fast the machine is.
+    timer.SetFixedDeltaTime(_createInfo.fixedTimeStep);
+
+    if (_createInfo.frameLimit == 0)
+    {
+        _createInfo.frameLimit = _createInfo.benchmarkWarmupFrames + BENCHMARK_FRAME_COUNT;
+    }
+    if (_createInfo.benchmarkWarmupFrames >= _createInfo.frameLimit)
+    {
+        throw std::runtime_error("benchmark warmup has to be shorter than the frame limit!");
+    }
+    if (_inputScript.IsEmpty())
+    {
+        _inputScript = InputScript::CreateFlythrough(_createInfo.frameLimit);
+    }
+}
+
 } // namespace tlr
\ No newline at end of file
@@ -13,21 +13,62 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include <string>
+
 #include "physical_device.hpp"
 #include "device.hpp"
 #include "swapchain.hpp"
 #include "input_manager.hpp"
 #include "camera.hpp"
 #include "timer.hpp"
+#include "frame_context.hpp"
+#include "gpu_profiler.hpp"
+#include "upload_manager.hpp"
+#include "uniform_ring.hpp"
+#include "cpu_profiler.hpp"
+#include "frame_pacing.hpp"
+#include "input_script.hpp"
+#include "frame_benchmark.hpp"
 #include "deletion_queue.hpp"
+#include "pipeline_cache.hpp"
+#include "shader_module_cache.hpp"
+#include "pipeline_builder.hpp"
 
 namespace tlr
 {
 
+struct AppBaseCreateInfo
+{
+    bool             isHeadless = false;        // render into owned images instead of a window's swapchain
+    bool             isValidationEnabled = true;
+    uint32_t         framesInFlight = 2;
+    uint32_t         workerThreadCount = 0;     // 0 uses every hardware thread
+    float            fixedTimeStep = 1.0f / 60.0f;
+    uint32_t         maxFixedStepsPerFrame = 5; // the backlog beyond this is dropped so a slow frame can't snowball
+    uint32_t         frameLimit = 0;            // 0 runs until the window is closed or ExitApp() is called
+    uint32_t         captureInterval = 0;       // headless only, every n-th frame is written to disk, 0 disables it
+    std::string      captureDirectory = ".";
+    std::string      gpuProfilePath;            // written on exit, .json selects JSON, anything else CSV
+    std::string      cpuProfilePath;            // Chrome trace JSON written on exit, open it in chrome://tracing or Perfetto
+    bool             isPresentPolicyEnabled = true;
+    PresentPolicy    presentPolicy;             // retuned once with the measured frame time after a warm-up
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR; // only used with the policy disabled
+    std::string      pacingReportPath;          // latency and frame interval histograms as CSV, written on exit
+    std::string      inputScriptPath;           // replayed input, see InputScript for the format
+    std::string      benchmarkReportPath;       // runs with a fixed time step and scripted input, writes JSON on exit
+    uint32_t         benchmarkWarmupFrames = 60;
+    bool             isMemoryStatsEnabled = false;    // prints GPU allocator usage and fragmentation on exit
+    VkDeviceSize     uniformRingFrameSize = UniformRing::DEFAULT_FRAME_SIZE;
+    std::string      pipelineCachePath = "pipeline_cache.bin"; // empty keeps the cache in memory only
+};
+
+AppBaseCreateInfo ParseCommandLine(int argc, char* argv[]);
+
 class AppBase
 {
 public:
     AppBase();
+    AppBase(const AppBaseCreateInfo& createInfo);
     ~AppBase();
 
     void Run();
@@ -49,34 +90,83 @@ protected:
     InputManager               *inputManager;
     Camera                     camera;
     Timer                      timer;
+    FrameContext               frameContext;
+    GpuProfiler                gpuProfiler;
+    UploadManager              uploadManager;
+    UniformRing                uniformRing;
+    PipelineCache              pipelineCache;     // pass it to every vkCreate*Pipelines call
+    ShaderModuleCache          shaderModuleCache;
+    PipelineLibrary            pipelines;         // request pipelines here, they compile off the main thread
     bool                       isAppRunning = false;
 
+    virtual void FixedUpdate(float fixedTimeStep) {}
     virtual void Update() = 0;
 
+    float    GetFixedTimeStep() const;
+    float    GetInterpolationAlpha() const;
+
+    bool     IsHeadless() const;
+    uint32_t AcquireNextImage(VkSemaphore imageAvailableSemaphore);
+    void     PresentImage(VkSemaphore renderFinishedSemaphore, uint32_t imageIndex);
+
 private:
+    AppBaseCreateInfo _createInfo;
+    uint32_t          _frameCount = 0;
+    float             _fixedTimeAccumulator = 0.0f;
+    FramePacing       _framePacing;
+    uint32_t          _lastInputEventCount = 0;
+    PresentConfig     _presentConfig{};
+    bool              _isPresentModeTuned = false;
+    InputScript       _inputScript;
+    FrameBenchmark    _benchmark;
+    GpuAllocator      _gpuAllocator;
+
     struct DepthBuffer
     {
         VkImage        depthImage;
-        VkDeviceMemory depthImageMemory;
+        GpuAllocation  depthImageMemory;
         VkImageView    depthImageView;
     } _depthBuffer;
 
+    struct OffscreenTargets
+    {
+        std::vector<GpuAllocation>  imageMemories;
+        uint32_t                    nextImage = 0;
+        VkCommandPool               commandPool;
+        VkCommandBuffer             commandBuffer;
+        VkFence                     readbackFence;
+        Buffer                      readbackBuffer;
+    } _offscreen;
+
     DeletionQueue _deletionQueue;
 
     void Init();
     void InitGLFW();
     void InitVulkan();
     void InitSwapchain();
+    void CreateSwapchain(const PresentPolicy& presentPolicy, VkSwapchainKHR oldSwapchain);
+    void DestroySwapchain(Swapchain& target);
+    void RecreateSwapchain(const PresentPolicy& presentPolicy);
+    void TunePresentMode();
+    void InitFrameContext();
+    void InitGpuProfiler();
+    void InitUploadManager();
+    void InitUniformRing();
+    void InitOffscreenTargets();
+    void SaveImage(uint32_t imageIndex, VkSemaphore renderFinishedSemaphore, const std::string& path);
 
     void        InitDepthBuffer();
     VkFormat    FindDepthFormat();
     VkFormat    FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-    void        CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+    void        CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, GpuAllocation& imageMemory);
     VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
 
     void InitRenderPass();
     void InitFramebuffers();
+    void CreateFramebuffers();
+    void DestroyFramebuffers();
     void InitInputManager();
+    void InitBenchmark();
 };
 
 } // namespace tlr
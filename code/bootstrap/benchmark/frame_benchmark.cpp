@@ -0,0 +1,96 @@
+#include "frame_benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+#include "cpu_profiler.hpp"
+#include "allocation_counter.hpp"
+
+namespace tlr
+{
+
+static float Percentile(const std::vector<float>& sortedValues, float percentile)
+{
+    if (sortedValues.empty())
+    {
+        return 0.0f;
+    }
+
+    size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0f * sortedValues.size()));
+    return sortedValues[std::clamp<size_t>(rank, 1, sortedValues.size()) - 1];
+}
+
+void FrameBenchmark::Begin()
+{
+    AllocationStats allocationStats = GetAllocationStats();
+    _startAllocationCount = allocationStats.count;
+    _startAllocatedBytes = allocationStats.bytes;
+    _profilerStartNanoseconds = CpuProfiler::GetInstance()->Now();
+    _frameMilliseconds.clear();
+    _lastFrame = Clock::now();
+    _isRunning = true;
+}
+
+void FrameBenchmark::MarkFrame()
+{
+    Clock::time_point now = Clock::now();
+    _frameMilliseconds.push_back(std::chrono::duration<float, std::milli>(now - _lastFrame).count());
+    _lastFrame = now;
+
+    // Read on every frame rather than in the report, so the report's own allocations don't count.
+    AllocationStats allocationStats = GetAllocationStats();
+    _allocationCount = allocationStats.count - _startAllocationCount;
+    _allocatedBytes = allocationStats.bytes - _startAllocatedBytes;
+}
+
+bool FrameBenchmark::IsRunning() const
+{
+    return _isRunning;
+}
+
+void FrameBenchmark::WriteReport(const std::string& path, uint32_t warmupFrameCount, const std::vector<GpuScopeTiming>& gpuTimings) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open benchmark report!");
+    }
+
+    std::vector<float> sortedFrames = _frameMilliseconds;
+    std::sort(sortedFrames.begin(), sortedFrames.end());
+    size_t frameCount = sortedFrames.size();
+    float mean = frameCount > 0 ? std::accumulate(sortedFrames.begin(), sortedFrames.end(), 0.0f) / frameCount : 0.0f;
+    float perFrame = frameCount > 0 ? 1.0f / frameCount : 0.0f;
+
+    file << "{\n";
+    file << "  \"frames\": " << frameCount << ",\n";
+    file << "  \"warmup_frames\": " << warmupFrameCount << ",\n";
+    file << "  \"frame_time_ms\": {\"mean\": " << mean << ", \"p50\": " << Percentile(sortedFrames, 50.0f)
+         << ", \"p99\": " << Percentile(sortedFrames, 99.0f) << ", \"max\": " << (frameCount > 0 ? sortedFrames.back() : 0.0f) << "},\n";
+
+    file << "  \"cpu_phases_ms_per_frame\": {";
+    std::vector<CpuScopeSummary> summaries = CpuProfiler::GetInstance()->Summarize(_profilerStartNanoseconds);
+    for (size_t i = 0; i < summaries.size(); ++i)
+    {
+        file << (i == 0 ? "\n" : ",\n") << "    \"" << summaries[i].name << "\": {\"time\": " << summaries[i].totalMilliseconds * perFrame
+             << ", \"calls\": " << summaries[i].callCount * perFrame << "}";
+    }
+    file << "\n  },\n";
+
+    file << "  \"gpu_scopes_ms\": {";
+    for (size_t i = 0; i < gpuTimings.size(); ++i)
+    {
+        file << (i == 0 ? "\n" : ",\n") << "    \"" << gpuTimings[i].name << "\": {\"mean\": " << gpuTimings[i].averageMilliseconds
+             << ", \"max\": " << gpuTimings[i].maxMilliseconds << "}";
+    }
+    file << "\n  },\n";
+
+    file << "  \"allocations\": {\"count\": " << _allocationCount << ", \"bytes\": " << _allocatedBytes
+         << ", \"per_frame\": " << _allocationCount * perFrame << "}\n";
+    file << "}\n";
+}
+
+} // namespace tlr
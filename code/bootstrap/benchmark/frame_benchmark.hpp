@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gpu_profiler.hpp"
+
+namespace tlr
+{
+
+// Collects the measured window of a benchmark run: wall time per frame, CPU time per profiler scope and the
+// allocations made, and writes them as JSON.
+class FrameBenchmark
+{
+public:
+    void Begin();
+    void MarkFrame();
+    bool IsRunning() const;
+
+    void WriteReport(const std::string& path, uint32_t warmupFrameCount, const std::vector<GpuScopeTiming>& gpuTimings) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool               _isRunning = false;
+    Clock::time_point  _lastFrame;
+    std::vector<float> _frameMilliseconds;
+    int64_t            _profilerStartNanoseconds = 0;
+    uint64_t           _startAllocationCount = 0;
+    uint64_t           _startAllocatedBytes = 0;
+    uint64_t           _allocationCount = 0;
+    uint64_t           _allocatedBytes = 0;
+};
+
+} // namespace tlr
@@ -0,0 +1,178 @@
+#include "input_script.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace tlr
+{
+
+static int ParseKeyCode(const std::string& name)
+{
+    static const std::unordered_map<std::string, int> namedKeys = {
+        {"SPACE",        GLFW_KEY_SPACE},
+        {"ESCAPE",       GLFW_KEY_ESCAPE},
+        {"ENTER",        GLFW_KEY_ENTER},
+        {"TAB",          GLFW_KEY_TAB},
+        {"LEFT_SHIFT",   GLFW_KEY_LEFT_SHIFT},
+        {"LEFT_CONTROL", GLFW_KEY_LEFT_CONTROL},
+        {"UP",           GLFW_KEY_UP},
+        {"DOWN",         GLFW_KEY_DOWN},
+        {"LEFT",         GLFW_KEY_LEFT},
+        {"RIGHT",        GLFW_KEY_RIGHT},
+        {"MOUSE_LEFT",   GLFW_MOUSE_BUTTON_LEFT},
+        {"MOUSE_RIGHT",  GLFW_MOUSE_BUTTON_RIGHT},
+        {"MOUSE_MIDDLE", GLFW_MOUSE_BUTTON_MIDDLE}
+    };
+
+    // GLFW keeps letters and digits at their ASCII codes.
+    if (name.size() == 1 && std::isalnum(static_cast<unsigned char>(name[0])))
+    {
+        return std::toupper(static_cast<unsigned char>(name[0]));
+    }
+
+    auto it = namedKeys.find(name);
+    if (it != namedKeys.end())
+    {
+        return it->second;
+    }
+
+    return std::stoi(name);
+}
+
+InputScript InputScript::Load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open input script!");
+    }
+
+    InputScript script;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream stream(line);
+
+        std::string frames;
+        std::string event;
+        if (!(stream >> frames >> event))
+        {
+            continue;
+        }
+
+        size_t stepSeparator = frames.find('/');
+        uint32_t frameStep = stepSeparator == std::string::npos ? 1 : std::max(static_cast<uint32_t>(std::stoul(frames.substr(stepSeparator + 1))), 1u);
+        frames = frames.substr(0, stepSeparator);
+
+        size_t rangeSeparator = frames.find('-');
+        uint32_t firstFrame = static_cast<uint32_t>(std::stoul(frames.substr(0, rangeSeparator)));
+        uint32_t lastFrame = rangeSeparator == std::string::npos ? firstFrame : static_cast<uint32_t>(std::stoul(frames.substr(rangeSeparator + 1)));
+
+        if (event == "press" || event == "release")
+        {
+            std::string key;
+            stream >> key;
+            int keyCode = ParseKeyCode(key);
+            int action = event == "press" ? GLFW_PRESS : GLFW_RELEASE;
+            for (uint32_t frame = firstFrame; frame <= lastFrame; frame += frameStep)
+            {
+                script.AddButton(frame, keyCode, action);
+            }
+        }
+        else if (event == "cursor")
+        {
+            float xoffset = 0.0f;
+            float yoffset = 0.0f;
+            stream >> xoffset >> yoffset;
+            for (uint32_t frame = firstFrame; frame <= lastFrame; frame += frameStep)
+            {
+                script.AddCursorMovement(frame, xoffset, yoffset);
+            }
+        }
+        else
+        {
+            throw std::runtime_error("unknown input script event!");
+        }
+    }
+
+    return script;
+}
+
+InputScript InputScript::CreateFlythrough(uint32_t frameCount)
+{
+    // Forward, strafe, back and up, down and left, while slowly turning, so every app moves the camera through its scene.
+    const int legKeys[][2] = {
+        {GLFW_KEY_W, -1},
+        {GLFW_KEY_D, -1},
+        {GLFW_KEY_S, GLFW_KEY_SPACE},
+        {GLFW_KEY_A, GLFW_KEY_LEFT_SHIFT}
+    };
+    const uint32_t legCount = sizeof(legKeys) / sizeof(legKeys[0]);
+    uint32_t legLength = std::max(frameCount / legCount, 1u);
+
+    InputScript script;
+    for (uint32_t leg = 0; leg < legCount; ++leg)
+    {
+        for (int keyCode : legKeys[leg])
+        {
+            if (keyCode >= 0)
+            {
+                script.AddButton(leg * legLength, keyCode, GLFW_PRESS);
+                script.AddButton((leg + 1) * legLength - 1, keyCode, GLFW_RELEASE);
+            }
+        }
+    }
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        script.AddCursorMovement(frame, frame < frameCount / 2 ? 1.0f : -1.0f, 0.0f);
+    }
+
+    return script;
+}
+
+void InputScript::AddButton(uint32_t frame, int keyCode, int action)
+{
+    _isSorted = _isSorted && (_inputs.empty() || _inputs.back().frame <= frame);
+    _inputs.push_back({frame, false, keyCode, action, 0.0f, 0.0f});
+}
+
+void InputScript::AddCursorMovement(uint32_t frame, float xoffset, float yoffset)
+{
+    _isSorted = _isSorted && (_inputs.empty() || _inputs.back().frame <= frame);
+    _inputs.push_back({frame, true, 0, 0, xoffset, yoffset});
+}
+
+void InputScript::Apply(uint32_t frame, InputManager& inputManager)
+{
+    if (!_isSorted)
+    {
+        std::stable_sort(_inputs.begin() + _nextInput, _inputs.end(), [](const ScriptedInput& a, const ScriptedInput& b) { return a.frame < b.frame; });
+        _isSorted = true;
+    }
+
+    for (; _nextInput < _inputs.size() && _inputs[_nextInput].frame <= frame; ++_nextInput)
+    {
+        const ScriptedInput& input = _inputs[_nextInput];
+        if (input.isCursorMovement)
+        {
+            inputManager.InjectCursorMovement(input.xoffset, input.yoffset);
+        }
+        else
+        {
+            inputManager.InjectButton(input.keyCode, input.action);
+        }
+    }
+}
+
+bool InputScript::IsEmpty() const
+{
+    return _inputs.empty();
+}
+
+} // namespace tlr
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "input_manager.hpp"
+
+namespace tlr
+{
+
+struct ScriptedInput
+{
+    uint32_t frame;
+    bool     isCursorMovement;
+    int      keyCode;
+    int      action;
+    float    xoffset;
+    float    yoffset;
+};
+
+// Replays input on fixed frames so every run sees the same camera path and the same clicks. One event per line:
+//
+//   # frame      event    arguments
+//   0            press    W
+//   120          release  W
+//   0-239        cursor   1.5 0.0      (a frame range repeats the event on every frame of it)
+//   300-399/20   press    MOUSE_LEFT   (or on every n-th frame of it)
+//
+// Keys are single letters or digits, GLFW key names without the GLFW_KEY_ prefix, MOUSE_LEFT/RIGHT/MIDDLE or raw codes.
+class InputScript
+{
+public:
+    static InputScript Load(const std::string& path);
+    static InputScript CreateFlythrough(uint32_t frameCount);
+
+    void AddButton(uint32_t frame, int keyCode, int action);
+    void AddCursorMovement(uint32_t frame, float xoffset, float yoffset);
+
+    // Injects every event scheduled up to and including the frame, expects frames in increasing order.
+    void Apply(uint32_t frame, InputManager& inputManager);
+    bool IsEmpty() const;
+
+private:
+    std::vector<ScriptedInput> _inputs;
+    size_t                     _nextInput = 0;
+    bool                       _isSorted = true;
+};
+
+} // namespace tlr
@@ -45,19 +45,27 @@ VkResult Device::CreateBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFla
     VK_CHECK_RESULT(vkCreateBuffer(device, &bufferCreateInfo, nullptr, &buffer->buffer));
 
     VkMemoryRequirements memReqs;
-    VkMemoryAllocateInfo memAlloc = init::MemoryAllocateInfo();
     vkGetBufferMemoryRequirements(device, buffer->buffer, &memReqs);
-    memAlloc.allocationSize = memReqs.size;
-    memAlloc.memoryTypeIndex = GetMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-    
-    // If the buffer has VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT set we also need to enable the appropriate flag during allocation
-    VkMemoryAllocateFlagsInfoKHR allocFlagsInfo{};
-    if (usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
-        allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR;
-        allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
-        memAlloc.pNext = &allocFlagsInfo;
+    if (allocator != nullptr && !(usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT))
+    {
+        buffer->allocation = allocator->Allocate(memReqs, memoryPropertyFlags, GpuResourceKind::Buffer);
+        buffer->memory = buffer->allocation.memory;
+    }
+    else
+    {
+        VkMemoryAllocateInfo memAlloc = init::MemoryAllocateInfo();
+        memAlloc.allocationSize = memReqs.size;
+        memAlloc.memoryTypeIndex = GetMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
+
+        // If the buffer has VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT set we also need to enable the appropriate flag during allocation
+        VkMemoryAllocateFlagsInfoKHR allocFlagsInfo{};
+        if (usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+            allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR;
+            allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+            memAlloc.pNext = &allocFlagsInfo;
+        }
+        VK_CHECK_RESULT(vkAllocateMemory(device, &memAlloc, nullptr, &buffer->memory));
     }
-    VK_CHECK_RESULT(vkAllocateMemory(device, &memAlloc, nullptr, &buffer->memory));
 
     buffer->alignment = memReqs.alignment;
     buffer->size = size;
@@ -21,6 +21,7 @@
 
 #include "physical_device.hpp"
 #include "buffer.hpp"
+#include "gpu_allocator.hpp"
 
 namespace tlr
 {
@@ -30,6 +31,7 @@ struct Device
     VkDevice                             device;
     PhysicalDevice                       physicalDevice;
     std::vector<VkQueueFamilyProperties> queueFamilies;
+    GpuAllocator*                        allocator = nullptr; // CreateBuffer sub-allocates from it when set
 
     operator VkDevice() const
     {
@@ -42,6 +44,8 @@ struct Device
 		VkQueue graphics;
         uint32_t presentFamily;
 		VkQueue present;
+        uint32_t transferFamily; // same as graphicsFamily when the device has no separate transfer family
+		VkQueue transfer;
 	} queues;
 
     uint32_t GetMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
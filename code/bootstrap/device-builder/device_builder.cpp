@@ -23,7 +23,8 @@ Device DeviceBuilder::Build()
     device.physicalDevice = _physicalDevice;
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = { _physicalDevice.familyIndices.graphicsFamily.value(), _physicalDevice.familyIndices.presentFamily.value() };
+    uint32_t transferFamily = _physicalDevice.familyIndices.transferFamily.value_or(_physicalDevice.familyIndices.graphicsFamily.value());
+    std::set<uint32_t> uniqueQueueFamilies = { _physicalDevice.familyIndices.graphicsFamily.value(), _physicalDevice.familyIndices.presentFamily.value(), transferFamily };
 
     float queuePriority = 1.0f;
     for (const auto& queueFamily : uniqueQueueFamilies)
@@ -67,6 +68,8 @@ Device DeviceBuilder::Build()
     vkGetDeviceQueue(device, _physicalDevice.familyIndices.graphicsFamily.value(), 0, &device.queues.graphics);
     device.queues.presentFamily = _physicalDevice.familyIndices.presentFamily.value();
     vkGetDeviceQueue(device, _physicalDevice.familyIndices.presentFamily.value(), 0, &device.queues.present);
+    device.queues.transferFamily = transferFamily;
+    vkGetDeviceQueue(device, transferFamily, 0, &device.queues.transfer);
 
     return device;
 }
@@ -0,0 +1,100 @@
+#include "frame_context.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+#include "toolset.hpp"
+#include "initializers.hpp"
+#include "cpu_profiler.hpp"
+
+namespace tlr
+{
+
+void FrameContext::Init(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight)
+{
+    if (framesInFlight == 0)
+    {
+        throw std::runtime_error("at least one frame has to be in flight!");
+    }
+
+    _device = device;
+    _frames.resize(framesInFlight);
+    _currentIndex = 0;
+    _lastBegunIndex = 0;
+
+    VkCommandPoolCreateInfo commandPoolCI = init::CommandPoolCreateInfo(queueFamilyIndex, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    VkFenceCreateInfo fenceCI = init::FenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+    VkSemaphoreCreateInfo semaphoreCI = init::SemaphoreCreateInfo();
+
+    for (FrameData& frame : _frames)
+    {
+        VK_CHECK_RESULT(vkCreateCommandPool(_device, &commandPoolCI, nullptr, &frame.commandPool));
+        VkCommandBufferAllocateInfo commandBufferAI = init::CommandBufferAllocateInfo(frame.commandPool, 1);
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(_device, &commandBufferAI, &frame.commandBuffer));
+
+        VK_CHECK_RESULT(vkCreateFence(_device, &fenceCI, nullptr, &frame.renderFence));
+        VK_CHECK_RESULT(vkCreateSemaphore(_device, &semaphoreCI, nullptr, &frame.swapchainSemaphore));
+        VK_CHECK_RESULT(vkCreateSemaphore(_device, &semaphoreCI, nullptr, &frame.renderSemaphore));
+    }
+}
+
+void FrameContext::Destroy()
+{
+    for (FrameData& frame : _frames)
+    {
+        frame.deletionQueue.Flush();
+
+        vkDestroySemaphore(_device, frame.renderSemaphore, nullptr);
+        vkDestroySemaphore(_device, frame.swapchainSemaphore, nullptr);
+        vkDestroyFence(_device, frame.renderFence, nullptr);
+        vkDestroyCommandPool(_device, frame.commandPool, nullptr);
+    }
+
+    _frames.clear();
+}
+
+FrameData& FrameContext::BeginFrame()
+{
+    FrameData& frame = GetCurrentFrame();
+
+    {
+        CPU_PROFILE_SCOPE("vkWaitForFences");
+        auto waitStart = std::chrono::steady_clock::now();
+        VK_CHECK_RESULT(vkWaitForFences(_device, 1, &frame.renderFence, VK_TRUE, UINT64_MAX));
+        _lastFenceWaitMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+    }
+    VK_CHECK_RESULT(vkResetFences(_device, 1, &frame.renderFence));
+
+    frame.deletionQueue.Flush();
+    _lastBegunIndex = _currentIndex;
+    VK_CHECK_RESULT(vkResetCommandPool(_device, frame.commandPool, 0));
+
+    return frame;
+}
+
+void FrameContext::EndFrame()
+{
+    _currentIndex = (_currentIndex + 1) % GetFramesInFlight();
+}
+
+FrameData& FrameContext::GetCurrentFrame()
+{
+    return _frames[_currentIndex];
+}
+
+uint32_t FrameContext::GetCurrentIndex() const
+{
+    return _currentIndex;
+}
+
+uint32_t FrameContext::GetFramesInFlight() const
+{
+    return static_cast<uint32_t>(_frames.size());
+}
+
+float FrameContext::GetLastFenceWaitMilliseconds() const
+{
+    return _lastFenceWaitMilliseconds;
+}
+
+} // namespace tlr
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "deletion_queue.hpp"
+
+namespace tlr
+{
+
+struct FrameData
+{
+    VkCommandPool   commandPool;
+    VkCommandBuffer commandBuffer;
+    VkSemaphore     swapchainSemaphore, renderSemaphore;
+    VkFence         renderFence;
+
+    DeletionQueue   deletionQueue; // flushed once the fence signaled again, capture handles by value
+};
+
+class FrameContext
+{
+public:
+    void Init(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight);
+    void Destroy();
+
+    // Waits for the GPU to release the current slot, then hands it out ready for recording.
+    FrameData& BeginFrame();
+    void       EndFrame();
+
+    FrameData& GetCurrentFrame();
+    uint32_t   GetCurrentIndex()   const;
+    uint32_t   GetFramesInFlight() const;
+    float      GetLastFenceWaitMilliseconds() const;
+
+    // Destroys a resource once no submitted frame can use it anymore, without idling the device. The deleter goes
+    // to the last begun frame, whose fence covers every earlier submit on the queue.
+    template <typename F>
+    void DeferDeletion(F&& deleter)
+    {
+        _frames[_lastBegunIndex].deletionQueue.PushFunction(std::forward<F>(deleter));
+    }
+
+private:
+    VkDevice               _device = VK_NULL_HANDLE;
+    std::vector<FrameData> _frames;
+    uint32_t               _currentIndex = 0;
+    uint32_t               _lastBegunIndex = 0;
+    float                  _lastFenceWaitMilliseconds = 0.0f;
+};
+
+} // namespace tlr
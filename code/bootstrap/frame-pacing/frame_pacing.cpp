@@ -0,0 +1,178 @@
+#include "frame_pacing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace tlr
+{
+
+static float ToMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+Histogram::Histogram(float bucketWidth, uint32_t bucketCount) : _bucketWidth(bucketWidth), _buckets(bucketCount, 0) {}
+
+void Histogram::Add(float value)
+{
+    size_t bucket = std::min(static_cast<size_t>(std::max(value, 0.0f) / _bucketWidth), _buckets.size() - 1);
+    ++_buckets[bucket];
+    ++_sampleCount;
+    _sum += value;
+    _max = std::max(_max, value);
+}
+
+void Histogram::Clear()
+{
+    std::fill(_buckets.begin(), _buckets.end(), 0);
+    _sampleCount = 0;
+    _sum = 0.0;
+    _max = 0.0f;
+}
+
+float Histogram::GetPercentile(float percentile) const
+{
+    if (_sampleCount == 0)
+    {
+        return 0.0f;
+    }
+
+    uint32_t target = static_cast<uint32_t>(std::ceil(percentile / 100.0f * _sampleCount));
+    uint32_t count = 0;
+    for (size_t i = 0; i + 1 < _buckets.size(); ++i)
+    {
+        count += _buckets[i];
+        if (count >= target)
+        {
+            return std::min((i + 1) * _bucketWidth, _max);
+        }
+    }
+    return _max;
+}
+
+float Histogram::GetMean() const
+{
+    return _sampleCount > 0 ? static_cast<float>(_sum / _sampleCount) : 0.0f;
+}
+
+float Histogram::GetMax() const
+{
+    return _max;
+}
+
+uint32_t Histogram::GetSampleCount() const
+{
+    return _sampleCount;
+}
+
+float Histogram::GetBucketWidth() const
+{
+    return _bucketWidth;
+}
+
+const std::vector<uint32_t>& Histogram::GetBuckets() const
+{
+    return _buckets;
+}
+
+FramePacing::FramePacing() : _latency(BUCKET_WIDTH_MILLISECONDS, BUCKET_COUNT), _frameInterval(BUCKET_WIDTH_MILLISECONDS, BUCKET_COUNT) {}
+
+void FramePacing::MarkInput()
+{
+    // Only the oldest input of a frame counts, it is the one that waited the longest to be seen.
+    if (!_hasPendingInput)
+    {
+        _pendingInput = Clock::now();
+        _hasPendingInput = true;
+    }
+}
+
+void FramePacing::AddBlockedTime(float milliseconds)
+{
+    _blockedMilliseconds += milliseconds;
+}
+
+void FramePacing::MarkPresent()
+{
+    Clock::time_point now = Clock::now();
+
+    if (_hasPendingInput)
+    {
+        _latency.Add(ToMilliseconds(now - _pendingInput));
+        _hasPendingInput = false;
+    }
+
+    if (_hasPresented)
+    {
+        float interval = ToMilliseconds(now - _lastPresent);
+        _frameInterval.Add(interval);
+        _workMilliseconds += std::max(interval - _blockedMilliseconds, 0.0f);
+        ++_workSampleCount;
+    }
+
+    _lastPresent = now;
+    _hasPresented = true;
+    _blockedMilliseconds = 0.0f;
+}
+
+void FramePacing::Reset()
+{
+    _latency.Clear();
+    _frameInterval.Clear();
+    _hasPendingInput = false;
+    _blockedMilliseconds = 0.0f;
+    _workMilliseconds = 0.0;
+    _workSampleCount = 0;
+}
+
+const Histogram& FramePacing::GetLatencyHistogram() const
+{
+    return _latency;
+}
+
+const Histogram& FramePacing::GetFrameIntervalHistogram() const
+{
+    return _frameInterval;
+}
+
+float FramePacing::GetAverageWorkMilliseconds() const
+{
+    return _workSampleCount > 0 ? static_cast<float>(_workMilliseconds / _workSampleCount) : 0.0f;
+}
+
+uint32_t FramePacing::GetPresentCount() const
+{
+    return _frameInterval.GetSampleCount();
+}
+
+void FramePacing::PrintSummary() const
+{
+    auto printHistogram = [](const char* name, const Histogram& histogram) {
+        std::cout << name << ": " << histogram.GetSampleCount() << " samples, mean " << histogram.GetMean() << " ms, p50 "
+                  << histogram.GetPercentile(50.0f) << " ms, p99 " << histogram.GetPercentile(99.0f) << " ms, max " << histogram.GetMax() << " ms" << std::endl;
+    };
+
+    printHistogram("Input to present", _latency);
+    printHistogram("Frame interval", _frameInterval);
+    std::cout << "Average work per frame: " << GetAverageWorkMilliseconds() << " ms" << std::endl;
+}
+
+void FramePacing::WriteReport(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open frame pacing report!");
+    }
+
+    file << "bucket_start_ms,latency_count,frame_interval_count\n";
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        file << i * BUCKET_WIDTH_MILLISECONDS << ',' << _latency.GetBuckets()[i] << ',' << _frameInterval.GetBuckets()[i] << '\n';
+    }
+}
+
+} // namespace tlr
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tlr
+{
+
+class Histogram
+{
+public:
+    Histogram(float bucketWidth, uint32_t bucketCount);
+
+    void Add(float value);
+    void Clear();
+
+    // Upper edge of the bucket the percentile falls into, values past the last bucket report the maximum.
+    float    GetPercentile(float percentile) const;
+    float    GetMean() const;
+    float    GetMax() const;
+    uint32_t GetSampleCount() const;
+    float    GetBucketWidth() const;
+
+    const std::vector<uint32_t>& GetBuckets() const;
+
+private:
+    float                 _bucketWidth;
+    std::vector<uint32_t> _buckets;
+    uint32_t              _sampleCount = 0;
+    double                _sum = 0.0;
+    float                 _max = 0.0f;
+};
+
+// Measures the time from the first input of a frame to its present call returning, the interval between
+// presents, and how much of that interval was actual work rather than waiting on fences and the swapchain.
+class FramePacing
+{
+public:
+    static constexpr float    BUCKET_WIDTH_MILLISECONDS = 0.5f;
+    static constexpr uint32_t BUCKET_COUNT = 200;
+
+    FramePacing();
+
+    void MarkInput();
+    void AddBlockedTime(float milliseconds);
+    void MarkPresent();
+    void Reset();
+
+    const Histogram& GetLatencyHistogram() const;
+    const Histogram& GetFrameIntervalHistogram() const;
+    float            GetAverageWorkMilliseconds() const;
+    uint32_t         GetPresentCount() const;
+
+    void PrintSummary() const;
+    void WriteReport(const std::string& path) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Histogram         _latency;
+    Histogram         _frameInterval;
+    Clock::time_point _lastPresent;
+    Clock::time_point _pendingInput;
+    bool              _hasPresented = false;
+    bool              _hasPendingInput = false;
+    float             _blockedMilliseconds = 0.0f;
+    double            _workMilliseconds = 0.0;
+    uint32_t          _workSampleCount = 0;
+};
+
+} // namespace tlr
@@ -0,0 +1,212 @@
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+#include "toolset.hpp"
+
+namespace tlr
+{
+
+static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+static constexpr uint32_t QUERIES_PER_FRAME = GpuProfiler::MAX_SCOPES_PER_FRAME * 2;
+
+void GpuProfiler::Init(const Device& device, uint32_t framesInFlight)
+{
+    uint32_t timestampValidBits = device.queueFamilies[device.queues.graphicsFamily].timestampValidBits;
+    if (timestampValidBits == 0)
+    {
+        std::cerr << "Graphics queue has no timestamp support, GPU profiling is disabled." << std::endl;
+        return;
+    }
+
+    _device = device.device;
+    _timestampPeriod = device.physicalDevice.properties.limits.timestampPeriod;
+    _timestampMask = timestampValidBits >= 64 ? UINT64_MAX : (uint64_t{1} << timestampValidBits) - 1;
+    _frames.resize(framesInFlight);
+    _queryResults.resize(QUERIES_PER_FRAME);
+
+    VkQueryPoolCreateInfo queryPoolCI{};
+    queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCI.queryCount = QUERIES_PER_FRAME * framesInFlight;
+    VK_CHECK_RESULT(vkCreateQueryPool(_device, &queryPoolCI, nullptr, &_queryPool));
+}
+
+void GpuProfiler::Destroy()
+{
+    if (IsEnabled())
+    {
+        vkDestroyQueryPool(_device, _queryPool, nullptr);
+        _queryPool = VK_NULL_HANDLE;
+    }
+}
+
+bool GpuProfiler::IsEnabled() const
+{
+    return _queryPool != VK_NULL_HANDLE;
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    CollectResults(frameIndex);
+
+    _currentFrame = frameIndex;
+    _frames[frameIndex].scopeNames.clear();
+    _frames[frameIndex].hasResults = false;
+    vkCmdResetQueryPool(cmd, _queryPool, frameIndex * QUERIES_PER_FRAME, QUERIES_PER_FRAME);
+}
+
+uint32_t GpuProfiler::BeginScope(VkCommandBuffer cmd, const char* name)
+{
+    if (!IsEnabled())
+    {
+        return INVALID_SCOPE;
+    }
+
+    FrameQueries& frame = _frames[_currentFrame];
+    if (frame.scopeNames.size() == MAX_SCOPES_PER_FRAME)
+    {
+        return INVALID_SCOPE;
+    }
+
+    uint32_t scope = static_cast<uint32_t>(frame.scopeNames.size());
+    frame.scopeNames.push_back(name);
+    frame.hasResults = true;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _queryPool, _currentFrame * QUERIES_PER_FRAME + scope * 2);
+    return scope;
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer cmd, uint32_t scope)
+{
+    if (scope == INVALID_SCOPE)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool, _currentFrame * QUERIES_PER_FRAME + scope * 2 + 1);
+}
+
+void GpuProfiler::CollectResults(uint32_t frameIndex)
+{
+    FrameQueries& frame = _frames[frameIndex];
+    if (!frame.hasResults)
+    {
+        return;
+    }
+
+    uint32_t queryCount = static_cast<uint32_t>(frame.scopeNames.size()) * 2;
+    VkResult result = vkGetQueryPoolResults(_device, _queryPool, frameIndex * QUERIES_PER_FRAME, queryCount,
+                                            queryCount * sizeof(uint64_t), _queryResults.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+    {
+        // VK_NOT_READY, the frame is dropped instead of waiting on it.
+        return;
+    }
+
+    for (size_t i = 0; i < frame.scopeNames.size(); ++i)
+    {
+        uint64_t ticks = (_queryResults[i * 2 + 1] - _queryResults[i * 2]) & _timestampMask;
+        float milliseconds = static_cast<float>(ticks) * _timestampPeriod / 1e6f;
+
+        auto it = _histories.find(frame.scopeNames[i]);
+        if (it == _histories.end())
+        {
+            it = _histories.emplace(frame.scopeNames[i], ScopeHistory{}).first;
+            _scopeOrder.emplace_back(frame.scopeNames[i]);
+        }
+
+        ScopeHistory& history = it->second;
+        history.samples[history.nextSample] = milliseconds;
+        history.nextSample = (history.nextSample + 1) % HISTORY_LENGTH;
+        history.sampleCount = std::min(history.sampleCount + 1, HISTORY_LENGTH);
+        history.lastMilliseconds = milliseconds;
+    }
+}
+
+std::vector<GpuScopeTiming> GpuProfiler::GetTimings() const
+{
+    std::vector<GpuScopeTiming> timings;
+
+    for (const auto& name : _scopeOrder)
+    {
+        const ScopeHistory& history = _histories.at(name);
+        auto first = history.samples.begin();
+        auto last = first + history.sampleCount;
+
+        GpuScopeTiming timing;
+        timing.name = name;
+        timing.sampleCount = history.sampleCount;
+        timing.lastMilliseconds = history.lastMilliseconds;
+        timing.minMilliseconds = *std::min_element(first, last);
+        timing.maxMilliseconds = *std::max_element(first, last);
+
+        float sum = 0.0f;
+        for (auto it = first; it != last; ++it)
+        {
+            sum += *it;
+        }
+        timing.averageMilliseconds = sum / history.sampleCount;
+
+        timings.push_back(timing);
+    }
+
+    return timings;
+}
+
+void GpuProfiler::WriteCsv(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open gpu profile file!");
+    }
+
+    file << "scope,samples,last_ms,avg_ms,min_ms,max_ms\n";
+    for (const auto& timing : GetTimings())
+    {
+        file << timing.name << ',' << timing.sampleCount << ',' << timing.lastMilliseconds << ',' << timing.averageMilliseconds << ','
+             << timing.minMilliseconds << ',' << timing.maxMilliseconds << '\n';
+    }
+}
+
+void GpuProfiler::WriteJson(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open gpu profile file!");
+    }
+
+    std::vector<GpuScopeTiming> timings = GetTimings();
+
+    file << "{\n  \"scopes\": [\n";
+    for (size_t i = 0; i < timings.size(); ++i)
+    {
+        const GpuScopeTiming& timing = timings[i];
+        file << "    {\"name\": \"" << timing.name << "\", \"samples\": " << timing.sampleCount
+             << ", \"last_ms\": " << timing.lastMilliseconds << ", \"avg_ms\": " << timing.averageMilliseconds
+             << ", \"min_ms\": " << timing.minMilliseconds << ", \"max_ms\": " << timing.maxMilliseconds << "}"
+             << (i + 1 < timings.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+}
+
+GpuProfileScope::GpuProfileScope(GpuProfiler& profiler, VkCommandBuffer cmd, const char* name) : _profiler(profiler), _cmd(cmd)
+{
+    _scope = _profiler.BeginScope(cmd, name);
+}
+
+GpuProfileScope::~GpuProfileScope()
+{
+    _profiler.EndScope(_cmd, _scope);
+}
+
+} // namespace tlr
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+
+#define GPU_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GPU_PROFILE_CONCAT(a, b) GPU_PROFILE_CONCAT_IMPL(a, b)
+#define GPU_PROFILE_SCOPE(profiler, cmd, name) tlr::GpuProfileScope GPU_PROFILE_CONCAT(gpuProfileScope, __LINE__)((profiler), (cmd), (name))
+
+namespace tlr
+{
+
+struct GpuScopeTiming
+{
+    std::string name;
+    uint32_t    sampleCount;
+    float       lastMilliseconds;
+    float       averageMilliseconds;
+    float       minMilliseconds;
+    float       maxMilliseconds;
+};
+
+class GpuProfiler
+{
+public:
+    static constexpr uint32_t MAX_SCOPES_PER_FRAME = 32;
+    static constexpr uint32_t HISTORY_LENGTH = 128;
+
+    void Init(const Device& device, uint32_t framesInFlight);
+    void Destroy();
+    bool IsEnabled() const;
+
+    // Must be recorded outside of any render pass, right after vkBeginCommandBuffer. The slot's fence has to be
+    // waited on already, so reading back its previous results never blocks.
+    void     BeginFrame(VkCommandBuffer cmd, uint32_t frameIndex);
+    uint32_t BeginScope(VkCommandBuffer cmd, const char* name);
+    void     EndScope(VkCommandBuffer cmd, uint32_t scope);
+
+    std::vector<GpuScopeTiming> GetTimings() const;
+    void                        WriteCsv(const std::string& path) const;
+    void                        WriteJson(const std::string& path) const;
+
+private:
+    struct FrameQueries
+    {
+        std::vector<const char*> scopeNames;
+        bool                     hasResults = false;
+    };
+
+    struct ScopeHistory
+    {
+        std::array<float, HISTORY_LENGTH> samples;
+        uint32_t                          sampleCount = 0;
+        uint32_t                          nextSample = 0;
+        float                             lastMilliseconds = 0.0f;
+    };
+
+    VkDevice                                      _device = VK_NULL_HANDLE;
+    VkQueryPool                                   _queryPool = VK_NULL_HANDLE;
+    float                                         _timestampPeriod = 0.0f;
+    uint64_t                                      _timestampMask = 0;
+    std::vector<FrameQueries>                     _frames;
+    uint32_t                                      _currentFrame = 0;
+    std::vector<uint64_t>                         _queryResults;
+    std::unordered_map<std::string, ScopeHistory> _histories;
+    std::vector<std::string>                      _scopeOrder;
+
+    void CollectResults(uint32_t frameIndex);
+};
+
+class GpuProfileScope
+{
+public:
+    GpuProfileScope(GpuProfiler& profiler, VkCommandBuffer cmd, const char* name);
+    ~GpuProfileScope();
+
+private:
+    GpuProfiler&    _profiler;
+    VkCommandBuffer _cmd;
+    uint32_t        _scope;
+};
+
+} // namespace tlr
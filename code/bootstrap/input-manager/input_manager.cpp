@@ -1,5 +1,7 @@
 #include "input_manager.hpp"
 
+#include "cpu_profiler.hpp"
+
 namespace tlr
 {
 
@@ -22,38 +24,12 @@ InputManager* InputManager::GetInstance()
 
 void InputManager::GLFWKeyboardButtonCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-    InputManager* instance = GetInstance();
-    
-    switch (action)
-    {
-    case GLFW_PRESS:
-        instance->_keyPressed[key].Raise();
-        instance->_pressedKeys.insert(key);
-        break;
-
-    case GLFW_RELEASE:
-        instance->_keyReleased[key].Raise();
-        instance->_pressedKeys.erase(key);
-        break;
-    }
+    GetInstance()->InjectButton(key, action);
 }
 
 void InputManager::GLFWMouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
-    InputManager* instance = GetInstance();
-    
-    switch (action)
-    {
-    case GLFW_PRESS:
-        instance->_keyPressed[button].Raise();
-        instance->_pressedKeys.insert(button);
-        break;
-
-    case GLFW_RELEASE:
-        instance->_keyReleased[button].Raise();
-        instance->_pressedKeys.erase(button);
-        break;
-    }
+    GetInstance()->InjectButton(button, action);
 }
 
 void InputManager::GLFWCursorCallback(GLFWwindow* window, double xpos, double ypos)
@@ -75,61 +51,112 @@ void InputManager::GLFWCursorCallback(GLFWwindow* window, double xpos, double yp
     firstXpos = xpos;
     firstYpos = ypos;
 
-    InputManager* instance = GetInstance();
-    instance->_cursorMoved.Raise(deltaX, -deltaY);
+    GetInstance()->InjectCursorMovement(deltaX, -deltaY);
+}
+
+void InputManager::InjectButton(int keyCode, int action)
+{
+    if (!IsValidKeyCode(keyCode))
+    {
+        return;
+    }
+    PushEvent({InputEventType::Button, keyCode, action, 0.0f, 0.0f});
+}
+
+void InputManager::InjectCursorMovement(float xoffset, float yoffset)
+{
+    PushEvent({InputEventType::CursorMovement, 0, 0, xoffset, yoffset});
 }
 
-void InputManager::AddCursorPositionListener(std::function<void(float, float)>&& listener)
+void InputManager::PushEvent(const InputEvent& event)
 {
-    _cursorMoved += std::move(listener);
+    ++_inputEventCount;
+    if (!_eventQueue.TryPush(event))
+    {
+        ++_droppedEventCount;
+    }
 }
 
-void InputManager::RemoveCursorPositionListener(std::function<void(float, float)>&& listener)
+void InputManager::ProcessEvent(const InputEvent& event)
 {
-    _cursorMoved -= std::move(listener);
+    if (event.type == InputEventType::CursorMovement)
+    {
+        _cursorMoved.Raise(event.xoffset, event.yoffset);
+        return;
+    }
+
+    switch (event.action)
+    {
+    case GLFW_PRESS:
+        _keyPressed[event.keyCode].Raise();
+        _pressedKeys.set(event.keyCode);
+        break;
+
+    case GLFW_RELEASE:
+        _keyReleased[event.keyCode].Raise();
+        _pressedKeys.reset(event.keyCode);
+        break;
+    }
+}
+
+bool InputManager::IsValidKeyCode(int keyCode)
+{
+    return keyCode >= 0 && keyCode < KEY_CODE_COUNT;
 }
 
-void InputManager::AddKeyPressListener(int keyCode, std::function<void()>&& listener)
+void InputManager::RemoveCursorPositionListener(EventHandle handle)
 {
-    _keyPressed[keyCode] += std::move(listener);
+    _cursorMoved.Remove(handle);
 }
 
-void InputManager::RemoveKeyPressListener(int keyCode, std::function<void()>&& listener)
+void InputManager::RemoveKeyPressListener(int keyCode, EventHandle handle)
 {
-    _keyPressed[keyCode] -= std::move(listener);
+    _keyPressed[keyCode].Remove(handle);
 }
 
-void InputManager::AddKeyReleaseListener(int keyCode, std::function<void()>&& listener)
+void InputManager::RemoveKeyReleaseListener(int keyCode, EventHandle handle)
 {
-    _keyReleased[keyCode] += std::move(listener);
+    _keyReleased[keyCode].Remove(handle);
 }
 
-void InputManager::RemoveKeyReleaseListener(int keyCode, std::function<void()>&& listener)
+void InputManager::RemoveKeyHoldListener(int keyCode, EventHandle handle)
 {
-    _keyReleased[keyCode] -= std::move(listener);
+    _keyIsBeingPressed[keyCode].Remove(handle);
 }
 
-void InputManager::AddKeyHoldListener(int keyCode, std::function<void()>&& listener)
+bool InputManager::IsKeyPressed(int keyCode) const
 {
-    _keyIsBeingPressed[keyCode] += std::move(listener);
+    return IsValidKeyCode(keyCode) && _pressedKeys.test(keyCode);
 }
 
-void InputManager::RemoveKeyHoldListener(int keyCode, std::function<void()>&& listener)
+uint32_t InputManager::GetInputEventCount() const
 {
-    _keyIsBeingPressed[keyCode] -= std::move(listener);
+    return _inputEventCount.load(std::memory_order_relaxed);
 }
 
-bool InputManager::IsKeyPressed(int keyCode)
+uint32_t InputManager::GetDroppedEventCount() const
 {
-    auto it = _pressedKeys.find(keyCode);
-    return it != _pressedKeys.end();
+    return _droppedEventCount.load(std::memory_order_relaxed);
 }
 
 void InputManager::Update()
 {
-    for (int key : _pressedKeys)
+    CPU_PROFILE_SCOPE("InputManager::Update");
+
+    InputEvent event;
+    while (_eventQueue.TryPop(event))
+    {
+        ProcessEvent(event);
+    }
+
+    std::bitset<KEY_CODE_COUNT> heldKeys = _pressedKeys & _holdListenedKeys;
+    for (int key = 0; key < KEY_CODE_COUNT && heldKeys.any(); ++key)
     {
-        _keyIsBeingPressed[key].Raise();
+        if (heldKeys.test(key))
+        {
+            heldKeys.reset(key);
+            _keyIsBeingPressed[key].Raise();
+        }
     }
 }
 
@@ -1,8 +1,9 @@
 #pragma once
 
-#include <unordered_set>
-#include <unordered_map>
-#include <functional>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <utility>
 #include <cassert>
 #include <memory>
 #include <iostream>
@@ -10,6 +11,7 @@
 #include <GLFW/glfw3.h>
 
 #include "event.hpp"
+#include "spsc_queue.hpp"
 
 namespace tlr
 {
@@ -23,20 +25,52 @@ public:
     static void Init(GLFWwindow* window);
     static InputManager* GetInstance();
 
-    void AddCursorPositionListener(std::function<void(float, float)>&& listener);
-    void RemoveCursorPositionListener(std::function<void(float, float)>&& listener);
-
-    void AddKeyPressListener(int keyCode, std::function<void()>&& listener);
-    void RemoveKeyPressListener(int keyCode, std::function<void()>&& listener);
-
-    void AddKeyReleaseListener(int keyCode, std::function<void()>&& listener);
-    void RemoveKeyReleaseListener(int keyCode, std::function<void()>&& listener);
-
-    void AddKeyHoldListener(int keyCode, std::function<void()>&& listener);
-    void RemoveKeyHoldListener(int keyCode, std::function<void()>&& listener);
-
-    bool IsKeyPressed(int keyCode);
-
+    // Listeners are stored without std::function, keep the returned handle to remove them again.
+    template <typename F>
+    EventHandle AddCursorPositionListener(F&& listener)
+    {
+        return _cursorMoved.Add(std::forward<F>(listener));
+    }
+    void RemoveCursorPositionListener(EventHandle handle);
+
+    template <typename F>
+    EventHandle AddKeyPressListener(int keyCode, F&& listener)
+    {
+        assert(IsValidKeyCode(keyCode) && "key code is out of the GLFW range!");
+        return _keyPressed[keyCode].Add(std::forward<F>(listener));
+    }
+    void RemoveKeyPressListener(int keyCode, EventHandle handle);
+
+    template <typename F>
+    EventHandle AddKeyReleaseListener(int keyCode, F&& listener)
+    {
+        assert(IsValidKeyCode(keyCode) && "key code is out of the GLFW range!");
+        return _keyReleased[keyCode].Add(std::forward<F>(listener));
+    }
+    void RemoveKeyReleaseListener(int keyCode, EventHandle handle);
+
+    template <typename F>
+    EventHandle AddKeyHoldListener(int keyCode, F&& listener)
+    {
+        assert(IsValidKeyCode(keyCode) && "key code is out of the GLFW range!");
+        _holdListenedKeys.set(keyCode);
+        return _keyIsBeingPressed[keyCode].Add(std::forward<F>(listener));
+    }
+    void RemoveKeyHoldListener(int keyCode, EventHandle handle);
+
+    bool IsKeyPressed(int keyCode) const;
+
+    // Goes through the same path as the GLFW callbacks, so scripted input is indistinguishable from a user's. Both only
+    // queue the input, so they may be called from a sampling thread while the consumer runs Update.
+    void InjectButton(int keyCode, int action);
+    void InjectCursorMovement(float xoffset, float yoffset);
+
+    // Bumped by every key, button and cursor callback, compare it across frames to tell whether input arrived.
+    uint32_t GetInputEventCount() const;
+    uint32_t GetDroppedEventCount() const;
+
+    // Drains the queued input into the key state and raises its events, then the hold events. Call it at one fixed
+    // point of the frame from the consuming thread.
     void Update();
 
 private:
@@ -46,11 +80,38 @@ private:
     static void GLFWMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
     static void GLFWCursorCallback(GLFWwindow* window, double xpos, double ypos);
 
-    Event<float, float>              _cursorMoved;
-    std::unordered_set<int>          _pressedKeys;
-    std::unordered_map<int, Event<>> _keyPressed;
-    std::unordered_map<int, Event<>> _keyReleased;
-    std::unordered_map<int, Event<>> _keyIsBeingPressed;
+    // Keyboard keys and mouse buttons share one code space, mouse buttons stay below the first printable key.
+    static constexpr int KEY_CODE_COUNT = GLFW_KEY_LAST + 1;
+    static constexpr size_t EVENT_QUEUE_CAPACITY = 1024;
+
+    enum class InputEventType : uint8_t
+    {
+        Button,
+        CursorMovement
+    };
+
+    struct InputEvent
+    {
+        InputEventType type;
+        int            keyCode;
+        int            action;
+        float          xoffset;
+        float          yoffset;
+    };
+
+    Event<float, float>                         _cursorMoved;
+    std::bitset<KEY_CODE_COUNT>                 _pressedKeys;
+    std::array<Event<>, KEY_CODE_COUNT>         _keyPressed;
+    std::array<Event<>, KEY_CODE_COUNT>         _keyReleased;
+    std::array<Event<>, KEY_CODE_COUNT>         _keyIsBeingPressed;
+    std::bitset<KEY_CODE_COUNT>                 _holdListenedKeys; // keys that ever got a hold listener, skips the rest in Update
+    SpscQueue<InputEvent, EVENT_QUEUE_CAPACITY> _eventQueue;
+    std::atomic<uint32_t>                       _inputEventCount{0};
+    std::atomic<uint32_t>                       _droppedEventCount{0};
+
+    static bool IsValidKeyCode(int keyCode);
+    void        PushEvent(const InputEvent& event);
+    void        ProcessEvent(const InputEvent& event);
 
     InputManager() = default;
 };
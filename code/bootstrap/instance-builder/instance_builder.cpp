@@ -65,7 +65,6 @@ void DestroyDebugUtilsMessengerEXT
 InstanceBuilder::InstanceBuilder()
 {
     _info.defaultLayers = { "VK_LAYER_KHRONOS_validation" };
-    _info.defaultExtensions = GetDefaultExtensions();
 }
 
 Instance InstanceBuilder::Build()
@@ -106,6 +105,7 @@ Instance InstanceBuilder::Build()
     instanceCI.ppEnabledExtensionNames = nullptr;
     if (_info.isDefaultExtensionsRequested)
     {
+        _info.defaultExtensions = GetDefaultExtensions();
         instanceCI.enabledExtensionCount = static_cast<uint32_t>(_info.defaultExtensions.size());
         instanceCI.ppEnabledExtensionNames = _info.defaultExtensions.data();
     }
@@ -174,6 +174,12 @@ InstanceBuilder& InstanceBuilder::UseDebugMessenger()
     return *this;
 }
 
+InstanceBuilder& InstanceBuilder::EnableHeadless()
+{
+    _info.isHeadless = true;
+    return *this;
+}
+
 bool InstanceBuilder::AreValidationLayersSupported()
 {
     uint32_t layersCount;
@@ -207,6 +213,12 @@ bool InstanceBuilder::IsValidationLayerSupported(const char *layerName, const st
 
 std::vector<const char *> InstanceBuilder::GetDefaultExtensions()
 {
+    if (_info.isHeadless)
+    {
+        // No window system, so no surface extensions are needed (or available).
+        return { VK_EXT_DEBUG_UTILS_EXTENSION_NAME };
+    }
+
     uint32_t glfwExtensionCount = 0;
     const char **glfwExtensions;
     glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -36,6 +36,7 @@ public:
     InstanceBuilder& RequestDefaultLayers();
     InstanceBuilder& RequestDefaultExtensions();
     InstanceBuilder& UseDebugMessenger();
+    InstanceBuilder& EnableHeadless();
     
 private:
     struct InstanceInfo
@@ -52,6 +53,7 @@ private:
         bool                     isDebugMessengerRequested = false;
         bool                     isDefaultLayersRequested = false;
         bool                     isDefaultExtensionsRequested = false;
+        bool                     isHeadless = false;
     } _info;
 
     bool                     AreValidationLayersSupported();
@@ -21,6 +21,13 @@ PhysicalDeviceSelector& PhysicalDeviceSelector::EnableDedicatedGPU()
     return *this;
 }
 
+PhysicalDeviceSelector& PhysicalDeviceSelector::EnableHeadless()
+{
+    _info.isHeadless = true;
+    _info.extensions.clear();
+    return *this;
+}
+
 PhysicalDeviceSelector& PhysicalDeviceSelector::SetExtensions(const std::vector<const char*>& extensions)
 {
     _info.extensions = extensions;
@@ -55,7 +62,10 @@ PhysicalDevice PhysicalDeviceSelector::Select()
     deviceInfo.surface = _surface;
     deviceInfo.extensions = _info.extensions;
     deviceInfo.familyIndices = GetQueueFamilyIndices(deviceInfo.physicalDevice);
-    deviceInfo.swapchainSupportDetails = GetSwapchainSupport(deviceInfo.physicalDevice);
+    if (!_info.isHeadless)
+    {
+        deviceInfo.swapchainSupportDetails = GetSwapchainSupport(deviceInfo.physicalDevice);
+    }
     
     return deviceInfo;
 }
@@ -88,6 +98,10 @@ bool PhysicalDeviceSelector::IsDeviceSuitable(const VkPhysicalDevice& device)
     {
         return false;
     }
+    if (_info.isHeadless)
+    {
+        return indices.IsComplete();
+    }
 
     bool isSwapChainAdequate = false;
     SwapchainSupportDetails swapChainSupport = GetSwapchainSupport(device);
@@ -109,12 +123,19 @@ QueueFamilyIndices PhysicalDeviceSelector::GetQueueFamilyIndices(const VkPhysica
     VkBool32 isPresentSupported = false;
     for (const auto& queueFamily : queueFamilies)
     {
-        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, _surface, &isPresentSupported);
-        
         if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
         {
             indices.graphicsFamily = i;
         }
+        if (_info.isHeadless)
+        {
+            // Frames are read back instead of presented, the graphics queue does both.
+            isPresentSupported = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+        }
+        else
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, _surface, &isPresentSupported);
+        }
         if (isPresentSupported)
         {
             indices.presentFamily = i;
@@ -126,6 +147,20 @@ QueueFamilyIndices PhysicalDeviceSelector::GetQueueFamilyIndices(const VkPhysica
         i++;
     }
 
+    // A family without graphics is usually backed by the copy engines, prefer the one that can't compute either.
+    for (uint32_t family = 0; family < queueFamilyCount; ++family)
+    {
+        VkQueueFlags flags = queueFamilies[family].queueFlags;
+        if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            continue;
+        }
+        if (!indices.transferFamily.has_value() || !(flags & VK_QUEUE_COMPUTE_BIT))
+        {
+            indices.transferFamily = family;
+        }
+    }
+
     return indices;
 }
 
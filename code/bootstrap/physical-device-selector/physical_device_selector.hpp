@@ -34,6 +34,7 @@ public:
 
     PhysicalDevice          Select();
     PhysicalDeviceSelector& EnableDedicatedGPU();
+    PhysicalDeviceSelector& EnableHeadless();
     PhysicalDeviceSelector& SetExtensions(const std::vector<const char*>& extensions);
     
 private:
@@ -41,6 +42,7 @@ private:
     {
         std::vector<const char*> extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
         bool                     isDedicatedGPU = false;
+        bool                     isHeadless = false;
         bool                     isGraphicsEnabled = false;
         bool                     isPresentEnabled = false;
     } _info;
@@ -9,6 +9,7 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> transferFamily; // optional, uploads fall back to the graphics queue without it
 
     bool IsComplete()
     {
@@ -18,6 +18,26 @@
 namespace tlr
 {
 
+// Goals for picking the present mode and image count, a zero leaves that goal unconstrained. The frame time is
+// the CPU and GPU work of a frame without the time spent waiting on the swapchain, measure it on the running
+// app and build again, before that the policy assumes the app keeps up with the display.
+struct PresentPolicy
+{
+    float maxLatencyMilliseconds = 0.0f;
+    float minFramesPerSecond = 0.0f;
+    bool  allowTearing = false;
+    float frameTimeMilliseconds = 0.0f;
+    float refreshIntervalMilliseconds = 0.0f; // 0 asks the monitor the window is on
+};
+
+struct PresentConfig
+{
+    VkPresentModeKHR presentMode;
+    uint32_t         imageCount;
+    float            estimatedLatencyMilliseconds;
+    float            estimatedFramesPerSecond;
+};
+
 struct Swapchain
 {
     VkDevice                 device{VK_NULL_HANDLE};
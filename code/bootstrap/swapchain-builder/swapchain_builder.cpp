@@ -10,11 +10,65 @@
 
 #include "swapchain_builder.hpp"
 
+#include <cmath>
+#include <cfloat>
+
 #include "toolset.hpp"
 
 namespace tlr
 {
 
+const char* PresentModeName(VkPresentModeKHR presentMode)
+{
+    switch (presentMode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "IMMEDIATE";
+    case VK_PRESENT_MODE_MAILBOX_KHR:      return "MAILBOX";
+    case VK_PRESENT_MODE_FIFO_KHR:         return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+    default:                               return "UNKNOWN";
+    }
+}
+
+// A rough model of the presentation engine. Scanout adds half a refresh on average, a queued FIFO image waits
+// a whole refresh for every image ahead of it, and tearing modes don't wait for vblank at all.
+static PresentConfig EstimatePresentConfig(VkPresentModeKHR presentMode, uint32_t imageCount, float frameTime, float refreshInterval)
+{
+    bool keepsUp = frameTime <= refreshInterval;
+    float presentWait = 0.0f;
+    float frameInterval = frameTime;
+
+    switch (presentMode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        break;
+
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        presentWait = refreshInterval * 0.5f;
+        break;
+
+    case VK_PRESENT_MODE_FIFO_KHR:
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+        if (keepsUp)
+        {
+            presentWait = (imageCount - 1) * refreshInterval;
+            frameInterval = refreshInterval;
+        }
+        else if (presentMode == VK_PRESENT_MODE_FIFO_KHR)
+        {
+            // Double buffering stalls the GPU until the next vblank, so a late frame costs a whole refresh.
+            presentWait = refreshInterval * 0.5f;
+            frameInterval = imageCount <= 2 ? std::ceil(frameTime / refreshInterval) * refreshInterval : frameTime;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return {presentMode, imageCount, frameTime + presentWait + refreshInterval * 0.5f, 1000.0f / frameInterval};
+}
+
 SwapchainBuilder::SwapchainBuilder(GLFWwindow* window, const VkSurfaceKHR& surface, const PhysicalDevice& physicalDevice, const Device& device)
 {
     _info.window = window;
@@ -29,18 +83,28 @@ Swapchain SwapchainBuilder::Build()
 {
     SwapchainSupportDetails swapchainSupport = _info.physicalDevice.swapchainSupportDetails;
     VkSurfaceFormatKHR surfaceFormat = GetSwapSurfaceFormat(swapchainSupport.formats);
-    VkPresentModeKHR presentMode = GetSwapPresentMode(swapchainSupport.presentModes);
     VkExtent2D extent = GetSwapExtent(swapchainSupport.capabilities);
 
-    if (swapchainSupport.capabilities.maxImageCount > 0 && _info.imageCount > swapchainSupport.capabilities.maxImageCount)
+    VkPresentModeKHR presentMode;
+    uint32_t minImageCount;
+    if (_info.hasPresentPolicy)
+    {
+        PresentConfig presentConfig = SelectPresentConfig();
+        presentMode = presentConfig.presentMode;
+        minImageCount = presentConfig.imageCount;
+        std::cout << "Present policy picked " << PresentModeName(presentMode) << " with " << minImageCount << " images, estimated "
+                  << presentConfig.estimatedLatencyMilliseconds << " ms latency at " << presentConfig.estimatedFramesPerSecond << " fps." << std::endl;
+    }
+    else
     {
-        _info.imageCount = swapchainSupport.capabilities.maxImageCount;
+        presentMode = GetSwapPresentMode(swapchainSupport.presentModes);
+        minImageCount = ClampImageCount(_info.imageCount, swapchainSupport.capabilities);
     }
 
     VkSwapchainCreateInfoKHR createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
     createInfo.surface = _info.surface;
-    createInfo.minImageCount = _info.imageCount;
+    createInfo.minImageCount = minImageCount;
     createInfo.imageFormat = surfaceFormat.format;
     createInfo.imageColorSpace = surfaceFormat.colorSpace;
     createInfo.imageExtent = extent;
@@ -64,13 +128,12 @@ Swapchain SwapchainBuilder::Build()
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = _info.oldSwapchain;
 
     Swapchain swapchainInfo;
 
     swapchainInfo.device = _info.device;
     VK_CHECK_RESULT(vkCreateSwapchainKHR(_info.device, &createInfo, nullptr, &swapchainInfo.swapchain));
-    swapchainInfo.imageCount = _info.imageCount;
     swapchainInfo.imageFormat = _info.desiredFormat;
     swapchainInfo.colorSpace = surfaceFormat.colorSpace;
     swapchainInfo.imageUsageFlags = _info.imageUsageFlags;
@@ -83,6 +146,7 @@ Swapchain SwapchainBuilder::Build()
     {
         throw std::runtime_error("zero swap chain images count!");
     }
+    swapchainInfo.imageCount = imageCount;
     swapchainInfo.images.resize(imageCount);
     vkGetSwapchainImagesKHR(swapchainInfo.device, swapchainInfo.swapchain, &imageCount, swapchainInfo.images.data());
     
@@ -110,7 +174,60 @@ Swapchain SwapchainBuilder::Build()
     return swapchainInfo;
 }
 
+PresentConfig SwapchainBuilder::SelectPresentConfig() const
+{
+    const SwapchainSupportDetails& swapchainSupport = _info.physicalDevice.swapchainSupportDetails;
+    const PresentPolicy& policy = _info.presentPolicy;
+
+    float refreshInterval = policy.refreshIntervalMilliseconds > 0.0f ? policy.refreshIntervalMilliseconds : GetRefreshIntervalMilliseconds();
+    float frameTime = policy.frameTimeMilliseconds > 0.0f ? policy.frameTimeMilliseconds : refreshInterval * 0.5f;
+
+    // Once every goal is met the earlier mode wins, FIFO never tears or renders frames that are never shown.
+    const VkPresentModeKHR preferredModes[] = {
+        VK_PRESENT_MODE_FIFO_KHR,
+        VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+        VK_PRESENT_MODE_MAILBOX_KHR,
+        VK_PRESENT_MODE_IMMEDIATE_KHR
+    };
+
+    PresentConfig bestConfig = EstimatePresentConfig(VK_PRESENT_MODE_FIFO_KHR, ClampImageCount(0, swapchainSupport.capabilities), frameTime, refreshInterval);
+    float bestShortfall = FLT_MAX;
 
+    for (VkPresentModeKHR presentMode : preferredModes)
+    {
+        bool isAvailable = std::find(swapchainSupport.presentModes.begin(), swapchainSupport.presentModes.end(), presentMode) != swapchainSupport.presentModes.end();
+        bool isTearing = presentMode == VK_PRESENT_MODE_IMMEDIATE_KHR || presentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        if (!isAvailable || (isTearing && !policy.allowTearing))
+        {
+            continue;
+        }
+
+        for (uint32_t extraImageCount = 0; extraImageCount <= 1; ++extraImageCount)
+        {
+            uint32_t imageCount = ClampImageCount(swapchainSupport.capabilities.minImageCount + extraImageCount, swapchainSupport.capabilities);
+            PresentConfig config = EstimatePresentConfig(presentMode, imageCount, frameTime, refreshInterval);
+
+            // 1 means every goal is met, above that it's how far the worst goal is missed.
+            float shortfall = 1.0f;
+            if (policy.maxLatencyMilliseconds > 0.0f)
+            {
+                shortfall = std::max(shortfall, config.estimatedLatencyMilliseconds / policy.maxLatencyMilliseconds);
+            }
+            if (policy.minFramesPerSecond > 0.0f)
+            {
+                shortfall = std::max(shortfall, policy.minFramesPerSecond / config.estimatedFramesPerSecond);
+            }
+
+            if (shortfall < bestShortfall)
+            {
+                bestConfig = config;
+                bestShortfall = shortfall;
+            }
+        }
+    }
+
+    return bestConfig;
+}
 
 SwapchainBuilder& SwapchainBuilder::SetDesiredColorSpace(VkColorSpaceKHR colorSpace)
 {
@@ -155,6 +272,19 @@ SwapchainBuilder& SwapchainBuilder::SetDesiredArrayLayerCount(uint32_t arrayLaye
     return *this;
 }
 
+SwapchainBuilder& SwapchainBuilder::SetPresentPolicy(const PresentPolicy& policy)
+{
+    _info.hasPresentPolicy = true;
+    _info.presentPolicy = policy;
+    return *this;
+}
+
+SwapchainBuilder& SwapchainBuilder::SetOldSwapchain(VkSwapchainKHR oldSwapchain)
+{
+    _info.oldSwapchain = oldSwapchain;
+    return *this;
+}
+
 VkSurfaceFormatKHR SwapchainBuilder::GetSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
 {
     for (const auto& availableFormat : availableFormats) {
@@ -176,6 +306,7 @@ VkPresentModeKHR SwapchainBuilder::GetSwapPresentMode(const std::vector<VkPresen
         }
     }
 
+    std::cerr << PresentModeName(static_cast<VkPresentModeKHR>(_info.desiredPresentMode)) << " present mode is not supported, falling back to FIFO." << std::endl;
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -205,4 +336,30 @@ VkExtent2D SwapchainBuilder::GetSwapExtent(const VkSurfaceCapabilitiesKHR& capab
     }
 }
 
+uint32_t SwapchainBuilder::ClampImageCount(uint32_t imageCount, const VkSurfaceCapabilitiesKHR& capabilities) const
+{
+    imageCount = std::max(imageCount, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0)
+    {
+        imageCount = std::min(imageCount, capabilities.maxImageCount);
+    }
+    return imageCount;
+}
+
+float SwapchainBuilder::GetRefreshIntervalMilliseconds() const
+{
+    GLFWmonitor* monitor = _info.window != nullptr ? glfwGetWindowMonitor(_info.window) : nullptr;
+    if (monitor == nullptr)
+    {
+        monitor = glfwGetPrimaryMonitor();
+    }
+
+    const GLFWvidmode* videoMode = monitor != nullptr ? glfwGetVideoMode(monitor) : nullptr;
+    if (videoMode == nullptr || videoMode->refreshRate <= 0)
+    {
+        return 1000.0f / 60.0f;
+    }
+    return 1000.0f / videoMode->refreshRate;
+}
+
 } // namespace tlr
\ No newline at end of file
@@ -20,6 +20,8 @@
 
 namespace tlr
 {
+
+const char* PresentModeName(VkPresentModeKHR presentMode);
     
 class SwapchainBuilder
 {
@@ -34,6 +36,11 @@ public:
     SwapchainBuilder& SetDesiredImageCount(uint32_t imageCount);
     SwapchainBuilder& SetImageFlags(VkImageUsageFlags usageFlags);
     SwapchainBuilder& SetDesiredArrayLayerCount(uint32_t arrayLayerCount);
+    SwapchainBuilder& SetPresentPolicy(const PresentPolicy& policy);
+    SwapchainBuilder& SetOldSwapchain(VkSwapchainKHR oldSwapchain);
+
+    // What Build() is going to use when a present policy is set.
+    PresentConfig SelectPresentConfig() const;
 
 private:
 
@@ -55,11 +62,16 @@ private:
         uint32_t                      graphicsQueueIndex = 0;
         uint32_t                      presentQueueIndex = 0;
         VkSurfaceTransformFlagBitsKHR preTransform = static_cast<VkSurfaceTransformFlagBitsKHR>(0);
+        bool                          hasPresentPolicy = false;
+        PresentPolicy                 presentPolicy;
+        VkSwapchainKHR                oldSwapchain{VK_NULL_HANDLE};
     } _info;
 
     VkSurfaceFormatKHR GetSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
     VkPresentModeKHR   GetSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
     VkExtent2D         GetSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
+    uint32_t           ClampImageCount(uint32_t imageCount, const VkSurfaceCapabilitiesKHR& capabilities) const;
+    float              GetRefreshIntervalMilliseconds() const;
 };
 
 } // namespace tlr
\ No newline at end of file
@@ -12,11 +12,16 @@ void Timer::Update()
 {
     auto currentTime = std::chrono::high_resolution_clock::now();
     std::chrono::duration<float> duration = currentTime - _lastTime;
-    _deltaTime = duration.count();
+    _deltaTime = _fixedDeltaTime > 0.0f ? _fixedDeltaTime : duration.count();
     _elapsedTime += _deltaTime;
     _lastTime = currentTime;
 }
 
+void Timer::SetFixedDeltaTime(float deltaTime)
+{
+    _fixedDeltaTime = deltaTime;
+}
+
 float Timer::GetDeltaTime() const
 {
     return _deltaTime;
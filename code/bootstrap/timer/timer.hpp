@@ -11,6 +11,7 @@ public:
     Timer();
 
     void  Update();
+    void  SetFixedDeltaTime(float deltaTime); // every Update advances by this instead of the clock, 0 goes back to the clock
     float GetElapsedTime() const;
     float GetDeltaTime()   const;
 
@@ -18,6 +19,7 @@ private:
     std::chrono::high_resolution_clock::time_point _lastTime;
     float _deltaTime = 0.0f;
     float _elapsedTime = 0.0f;
+    float _fixedDeltaTime = 0.0f;
 };
 
 } // namespace tlr
@@ -0,0 +1,57 @@
+#include "uniform_ring.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "toolset.hpp"
+
+namespace tlr
+{
+
+void UniformRing::Init(Device& device, uint32_t framesInFlight, VkDeviceSize frameSize)
+{
+    _alignment = device.physicalDevice.properties.limits.minUniformBufferOffsetAlignment;
+    _frameSize = (frameSize + _alignment - 1) / _alignment * _alignment;
+
+    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &_buffer, _frameSize * framesInFlight));
+    VK_CHECK_RESULT(_buffer.Map());
+}
+
+void UniformRing::Destroy()
+{
+    _buffer.Destroy();
+}
+
+void UniformRing::BeginFrame(uint32_t frameIndex)
+{
+    _frameBegin = frameIndex * _frameSize;
+    _head = _frameBegin;
+}
+
+uint32_t UniformRing::Push(const void* data, VkDeviceSize size)
+{
+    VkDeviceSize offset = _head;
+    if (offset + size > _frameBegin + _frameSize)
+    {
+        throw std::runtime_error("uniform ring ran out of space for this frame!");
+    }
+    memcpy(static_cast<char*>(_buffer.mapped) + offset, data, size);
+    _head = (offset + size + _alignment - 1) / _alignment * _alignment;
+    return static_cast<uint32_t>(offset);
+}
+
+VkDescriptorBufferInfo UniformRing::GetDescriptor(VkDeviceSize range) const
+{
+    VkDescriptorBufferInfo descriptor{};
+    descriptor.buffer = _buffer.buffer;
+    descriptor.offset = 0;
+    descriptor.range = range;
+    return descriptor;
+}
+
+VkDeviceSize UniformRing::GetUsedBytes() const
+{
+    return _head - _frameBegin;
+}
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+#include "buffer.hpp"
+
+namespace tlr
+{
+
+// Per-frame uniform data is bump allocated from one persistently mapped buffer, split into a region per frame in
+// flight. Descriptors are written once as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC against the whole buffer and
+// every draw picks its data with the offset returned by Push.
+class UniformRing
+{
+public:
+    static constexpr VkDeviceSize DEFAULT_FRAME_SIZE = 1024 * 1024;
+
+    void Init(Device& device, uint32_t framesInFlight, VkDeviceSize frameSize = DEFAULT_FRAME_SIZE);
+    void Destroy();
+
+    // Rewinds the frame's region, its fence must have been waited on already.
+    void BeginFrame(uint32_t frameIndex);
+
+    // Returns the dynamic offset of the copied data.
+    uint32_t Push(const void* data, VkDeviceSize size);
+
+    template <typename T>
+    uint32_t Push(const T& value)
+    {
+        return Push(&value, sizeof(T));
+    }
+
+    // Range is the size of the struct a binding reads, offset 0 so the dynamic offset alone selects the data.
+    VkDescriptorBufferInfo GetDescriptor(VkDeviceSize range) const;
+    VkDeviceSize           GetUsedBytes() const;
+
+private:
+    Buffer       _buffer{};
+    VkDeviceSize _frameSize = 0;
+    VkDeviceSize _alignment = 0;
+    VkDeviceSize _frameBegin = 0;
+    VkDeviceSize _head = 0;
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "upload_manager.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "toolset.hpp"
+#include "initializers.hpp"
+#include "cpu_profiler.hpp"
+
+namespace tlr
+{
+
+void UploadManager::Init(Device& device, VkDeviceSize stagingSize, uint32_t batchCount)
+{
+    _device = device;
+    _transferQueue = device.queues.transfer;
+    _transferFamily = device.queues.transferFamily;
+    _graphicsQueue = device.queues.graphics;
+    _graphicsFamily = device.queues.graphicsFamily;
+
+    VkCommandPoolCreateInfo transferPoolCI = init::CommandPoolCreateInfo(_transferFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    VK_CHECK_RESULT(vkCreateCommandPool(_device, &transferPoolCI, nullptr, &_transferPool));
+    if (IsSeparateTransferFamily())
+    {
+        VkCommandPoolCreateInfo acquirePoolCI = init::CommandPoolCreateInfo(_graphicsFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+        VK_CHECK_RESULT(vkCreateCommandPool(_device, &acquirePoolCI, nullptr, &_acquirePool));
+    }
+
+    _batches.resize(std::max(batchCount, 1u));
+    for (Batch& batch : _batches)
+    {
+        VkCommandBufferAllocateInfo transferAI = init::CommandBufferAllocateInfo(_transferPool, 1);
+        VK_CHECK_RESULT(vkAllocateCommandBuffers(_device, &transferAI, &batch.transferCommandBuffer));
+        if (IsSeparateTransferFamily())
+        {
+            VkCommandBufferAllocateInfo acquireAI = init::CommandBufferAllocateInfo(_acquirePool, 1);
+            VK_CHECK_RESULT(vkAllocateCommandBuffers(_device, &acquireAI, &batch.acquireCommandBuffer));
+            VkSemaphoreCreateInfo semaphoreCI = init::SemaphoreCreateInfo();
+            VK_CHECK_RESULT(vkCreateSemaphore(_device, &semaphoreCI, nullptr, &batch.releaseSemaphore));
+        }
+        VkFenceCreateInfo fenceCI = init::FenceCreateInfo();
+        VK_CHECK_RESULT(vkCreateFence(_device, &fenceCI, nullptr, &batch.fence));
+    }
+
+    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &_staging, stagingSize));
+    VK_CHECK_RESULT(_staging.Map());
+
+    _pendingCopies.reserve(256);
+    _copyRegions.reserve(256);
+    _barriers.reserve(64);
+    _stats.stagingCapacity = stagingSize;
+}
+
+void UploadManager::Destroy()
+{
+    for (Batch& batch : _batches)
+    {
+        if (batch.isInFlight)
+        {
+            VK_CHECK_RESULT(vkWaitForFences(_device, 1, &batch.fence, VK_TRUE, UINT64_MAX));
+            RetireBatch(batch);
+        }
+        vkDestroyFence(_device, batch.fence, nullptr);
+        if (batch.releaseSemaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(_device, batch.releaseSemaphore, nullptr);
+        }
+    }
+    _batches.clear();
+
+    if (_acquirePool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(_device, _acquirePool, nullptr);
+    }
+    vkDestroyCommandPool(_device, _transferPool, nullptr);
+    _staging.Unmap();
+    _staging.Destroy();
+}
+
+UploadTicket UploadManager::Upload(const Buffer& dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+{
+    assert(dstOffset + size <= dstBuffer.size && "upload runs past the end of the destination!");
+    assert(std::none_of(_batches.begin(), _batches.end(), [&dstBuffer](const Batch& batch) {
+        return batch.isInFlight && std::find(batch.releasedBuffers.begin(), batch.releasedBuffers.end(), dstBuffer.buffer) != batch.releasedBuffers.end(); })
+        && "destination was already handed to the graphics family, uploads only support fresh buffers!");
+
+    const uint8_t* source = static_cast<const uint8_t*>(data);
+    VkDeviceSize remaining = size;
+
+    // Anything larger than the ring goes through in ring-sized pieces, each piece waits for space on its own.
+    while (remaining > 0)
+    {
+        VkDeviceSize chunkSize = std::min(remaining, _staging.size);
+        VkDeviceSize srcOffset = AllocateStaging(chunkSize);
+        memcpy(static_cast<uint8_t*>(_staging.mapped) + srcOffset, source, chunkSize);
+        _pendingCopies.push_back({ dstBuffer.buffer, srcOffset, dstOffset, chunkSize });
+
+        source += chunkSize;
+        dstOffset += chunkSize;
+        remaining -= chunkSize;
+    }
+
+    ++_stats.uploadCount;
+    _stats.uploadedBytes += size;
+    return ++_lastTicket;
+}
+
+UploadTicket UploadManager::Flush()
+{
+    if (_pendingCopies.empty())
+    {
+        return _lastTicket;
+    }
+
+    CPU_PROFILE_SCOPE("UploadManager::Flush");
+
+    // Batches are reused round-robin, so the next one is also the oldest that can still be in flight.
+    Batch& batch = _batches[_nextBatch];
+    if (batch.isInFlight)
+    {
+        ++_stats.stallCount;
+        VK_CHECK_RESULT(vkWaitForFences(_device, 1, &batch.fence, VK_TRUE, UINT64_MAX));
+        RetireBatch(batch);
+    }
+    VK_CHECK_RESULT(vkResetFences(_device, 1, &batch.fence));
+
+    RecordCopies(batch);
+
+    VkSubmitInfo transferSI = init::SubmitInfo();
+    transferSI.commandBufferCount = 1;
+    transferSI.pCommandBuffers = &batch.transferCommandBuffer;
+    if (IsSeparateTransferFamily())
+    {
+        transferSI.signalSemaphoreCount = 1;
+        transferSI.pSignalSemaphores = &batch.releaseSemaphore;
+        VK_CHECK_RESULT(vkQueueSubmit(_transferQueue, 1, &transferSI, VK_NULL_HANDLE));
+
+        RecordAcquire(batch);
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo acquireSI = init::SubmitInfo();
+        acquireSI.waitSemaphoreCount = 1;
+        acquireSI.pWaitSemaphores = &batch.releaseSemaphore;
+        acquireSI.pWaitDstStageMask = &waitStage;
+        acquireSI.commandBufferCount = 1;
+        acquireSI.pCommandBuffers = &batch.acquireCommandBuffer;
+        VK_CHECK_RESULT(vkQueueSubmit(_graphicsQueue, 1, &acquireSI, batch.fence));
+    }
+    else
+    {
+        VK_CHECK_RESULT(vkQueueSubmit(_transferQueue, 1, &transferSI, batch.fence));
+    }
+
+    batch.ticket = _lastTicket;
+    batch.stagingEnd = _stagingHead;
+    batch.isInFlight = true;
+    _submittedTicket = _lastTicket;
+    _nextBatch = (_nextBatch + 1) % static_cast<uint32_t>(_batches.size());
+    _pendingCopies.clear();
+    ++_stats.batchCount;
+
+    return _lastTicket;
+}
+
+void UploadManager::Wait(UploadTicket ticket)
+{
+    if (ticket > _submittedTicket)
+    {
+        Flush();
+    }
+    while (_completedTicket < ticket)
+    {
+        WaitOldestBatch();
+    }
+}
+
+bool UploadManager::IsComplete(UploadTicket ticket)
+{
+    if (ticket <= _completedTicket)
+    {
+        return true;
+    }
+    Retire();
+    return ticket <= _completedTicket;
+}
+
+void UploadManager::Retire()
+{
+    uint32_t batchCount = static_cast<uint32_t>(_batches.size());
+    for (uint32_t i = 0; i < batchCount; ++i)
+    {
+        Batch& batch = _batches[(_nextBatch + i) % batchCount];
+        if (!batch.isInFlight)
+        {
+            continue;
+        }
+        if (vkGetFenceStatus(_device, batch.fence) != VK_SUCCESS)
+        {
+            break;
+        }
+        RetireBatch(batch);
+    }
+}
+
+UploadStats UploadManager::GetStats() const
+{
+    return _stats;
+}
+
+bool UploadManager::IsSeparateTransferFamily() const
+{
+    return _transferFamily != _graphicsFamily;
+}
+
+VkDeviceSize UploadManager::AllocateStaging(VkDeviceSize size)
+{
+    const uint64_t capacity = _staging.size;
+    while (true)
+    {
+        uint64_t offset = (_stagingHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+        if (offset % capacity + size > capacity)
+        {
+            // Copies can't wrap around, skip the tail end of the ring.
+            offset = (offset / capacity + 1) * capacity;
+        }
+        if (offset + size - _stagingTail <= capacity)
+        {
+            _stagingHead = offset + size;
+            return offset % capacity;
+        }
+
+        ++_stats.stallCount;
+        Flush();
+        WaitOldestBatch();
+    }
+}
+
+void UploadManager::WaitOldestBatch()
+{
+    uint32_t batchCount = static_cast<uint32_t>(_batches.size());
+    for (uint32_t i = 0; i < batchCount; ++i)
+    {
+        Batch& batch = _batches[(_nextBatch + i) % batchCount];
+        if (batch.isInFlight)
+        {
+            VK_CHECK_RESULT(vkWaitForFences(_device, 1, &batch.fence, VK_TRUE, UINT64_MAX));
+            RetireBatch(batch);
+            return;
+        }
+    }
+
+    // Nothing in flight and nothing pending, the whole ring is free so restart it at its beginning.
+    uint64_t capacity = _staging.size;
+    _stagingHead = (_stagingHead + capacity - 1) / capacity * capacity;
+    _stagingTail = _stagingHead;
+}
+
+void UploadManager::RetireBatch(Batch& batch)
+{
+    batch.isInFlight = false;
+    batch.releasedBuffers.clear();
+    _stagingTail = batch.stagingEnd;
+    _completedTicket = batch.ticket;
+}
+
+void UploadManager::RecordCopies(Batch& batch)
+{
+    VkCommandBuffer cmd = batch.transferCommandBuffer;
+    VK_CHECK_RESULT(vkResetCommandBuffer(cmd, 0));
+    VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+
+    // Consecutive copies into the same buffer share one command.
+    size_t runBegin = 0;
+    while (runBegin < _pendingCopies.size())
+    {
+        VkBuffer dstBuffer = _pendingCopies[runBegin].dstBuffer;
+        _copyRegions.clear();
+        size_t runEnd = runBegin;
+        while (runEnd < _pendingCopies.size() && _pendingCopies[runEnd].dstBuffer == dstBuffer)
+        {
+            const PendingCopy& copy = _pendingCopies[runEnd];
+            _copyRegions.push_back({ copy.srcOffset, copy.dstOffset, copy.size });
+            ++runEnd;
+        }
+        vkCmdCopyBuffer(cmd, _staging.buffer, dstBuffer, static_cast<uint32_t>(_copyRegions.size()), _copyRegions.data());
+        runBegin = runEnd;
+    }
+
+    if (IsSeparateTransferFamily())
+    {
+        // Release every written buffer to the graphics family, RecordAcquire records the matching acquire.
+        _barriers.clear();
+        for (const PendingCopy& copy : _pendingCopies)
+        {
+            bool isReleased = std::any_of(_barriers.begin(), _barriers.end(), [&copy](const VkBufferMemoryBarrier& barrier) { return barrier.buffer == copy.dstBuffer; });
+            if (isReleased)
+            {
+                continue;
+            }
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = _transferFamily;
+            barrier.dstQueueFamilyIndex = _graphicsFamily;
+            barrier.buffer = copy.dstBuffer;
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            _barriers.push_back(barrier);
+        }
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+            0, nullptr, static_cast<uint32_t>(_barriers.size()), _barriers.data(), 0, nullptr);
+
+        batch.releasedBuffers.clear();
+        for (const VkBufferMemoryBarrier& barrier : _barriers)
+        {
+            batch.releasedBuffers.push_back(barrier.buffer);
+        }
+    }
+    else
+    {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+            1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+}
+
+void UploadManager::RecordAcquire(Batch& batch)
+{
+    VkCommandBuffer cmd = batch.acquireCommandBuffer;
+    VK_CHECK_RESULT(vkResetCommandBuffer(cmd, 0));
+    VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+
+    for (VkBufferMemoryBarrier& barrier : _barriers)
+    {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    }
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+        0, nullptr, static_cast<uint32_t>(_barriers.size()), _barriers.data(), 0, nullptr);
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+}
+
+} // namespace tlr
\ No newline at end of file
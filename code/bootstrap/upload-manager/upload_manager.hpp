@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "device.hpp"
+#include "buffer.hpp"
+
+namespace tlr
+{
+
+// Tickets grow monotonically, a ticket is complete once every batch up to it retired.
+using UploadTicket = uint64_t;
+
+struct UploadStats
+{
+    uint64_t     uploadCount;
+    uint64_t     uploadedBytes;
+    uint64_t     batchCount;
+    uint64_t     stallCount;      // times the ring was full and the CPU had to wait on a batch
+    VkDeviceSize stagingCapacity;
+};
+
+class UploadManager
+{
+public:
+    static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 16 * 1024 * 1024;
+    static constexpr uint32_t     DEFAULT_BATCH_COUNT = 4;
+
+    void Init(Device& device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE, uint32_t batchCount = DEFAULT_BATCH_COUNT);
+    void Destroy();
+
+    // Copies the data into the staging ring right away, the GPU copy is recorded on the next Flush. The destination
+    // needs VK_BUFFER_USAGE_TRANSFER_DST_BIT and must not be used by the GPU until the returned ticket completed.
+    // Overlapping uploads into the same range need a Flush in between, copies of one batch aren't ordered.
+    // Only fresh destinations are supported: with a separate transfer family the buffer is handed to the graphics
+    // family once the batch completes and is never acquired back, so writing it again (at any dstOffset) after a
+    // Flush is invalid. Partial updates of a buffer the GPU already reads are recorded on the graphics queue instead.
+    UploadTicket Upload(const Buffer& dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+    // Submits every pending copy as one batch, returns the ticket of the last upload. Doesn't block.
+    UploadTicket Flush();
+
+    // Flushes first if the ticket is still pending.
+    void Wait(UploadTicket ticket);
+    bool IsComplete(UploadTicket ticket);
+
+    // Reclaims staging space of finished batches without blocking, call it once per frame.
+    void Retire();
+
+    UploadStats GetStats() const;
+
+private:
+    static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    struct PendingCopy
+    {
+        VkBuffer     dstBuffer;
+        VkDeviceSize srcOffset;
+        VkDeviceSize dstOffset;
+        VkDeviceSize size;
+    };
+
+    // With a separate transfer family the copy is released there and acquired by a second submit on graphics,
+    // the fence then signals once the data is usable by the graphics queue.
+    struct Batch
+    {
+        VkCommandBuffer transferCommandBuffer;
+        VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+        VkSemaphore     releaseSemaphore = VK_NULL_HANDLE;
+        VkFence         fence;
+        std::vector<VkBuffer> releasedBuffers;  // handed to the graphics family, checked by Upload until retired
+        UploadTicket    ticket = 0;
+        uint64_t        stagingEnd = 0;
+        bool            isInFlight = false;
+    };
+
+    VkDevice                  _device = VK_NULL_HANDLE;
+    VkQueue                   _transferQueue = VK_NULL_HANDLE;
+    VkQueue                   _graphicsQueue = VK_NULL_HANDLE;
+    uint32_t                  _transferFamily = 0;
+    uint32_t                  _graphicsFamily = 0;
+    VkCommandPool             _transferPool = VK_NULL_HANDLE;
+    VkCommandPool             _acquirePool = VK_NULL_HANDLE;
+    Buffer                    _staging{};
+
+    // Offsets only ever grow, the position in the ring is the offset modulo its size.
+    uint64_t                  _stagingHead = 0;
+    uint64_t                  _stagingTail = 0;
+
+    std::vector<Batch>        _batches;
+    uint32_t                  _nextBatch = 0;
+    std::vector<PendingCopy>  _pendingCopies;
+    std::vector<VkBufferCopy> _copyRegions;
+    std::vector<VkBufferMemoryBarrier> _barriers;
+
+    UploadTicket              _lastTicket = 0;
+    UploadTicket              _submittedTicket = 0;
+    UploadTicket              _completedTicket = 0;
+    UploadStats               _stats{};
+
+    bool         IsSeparateTransferFamily() const;
+    VkDeviceSize AllocateStaging(VkDeviceSize size);
+    void         WaitOldestBatch();
+    void         RetireBatch(Batch& batch);
+    void         RecordCopies(Batch& batch);
+    void         RecordAcquire(Batch& batch);
+};
+
+} // namespace tlr
\ No newline at end of file
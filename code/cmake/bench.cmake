@@ -0,0 +1,15 @@
+# `cmake --build . --target bench` runs the app headless for a fixed number of frames with scripted input and
+# writes bench.json into the build folder. A project can pass its own input script instead of the default flythrough.
+function(add_bench_target target)
+    set(BENCH_ARGUMENTS --headless --no-validation --bench ${CMAKE_BINARY_DIR}/bench.json)
+    if(ARGC GREATER 1)
+        list(APPEND BENCH_ARGUMENTS --input-script ${ARGV1})
+    endif()
+
+    add_custom_target(bench
+        COMMAND ${target} ${BENCH_ARGUMENTS}
+        WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+        COMMENT "Benchmarking ${target}, results go to ${CMAKE_BINARY_DIR}/bench.json"
+        USES_TERMINAL
+    )
+endfunction()
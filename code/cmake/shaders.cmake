@@ -0,0 +1,73 @@
+# Compiles the GLSL sources in a target's shaders folder to SPIR-V with glslc and embeds them. Each shader becomes a
+# constexpr uint32_t array in the generated embedded_shaders.hpp, e.g. shaders/shader.vert turns into SHADER_VERT_CODE
+# and the EmbeddedShader SHADER_VERT. MANIFEST lists every shader of the target with its stage.
+if(NOT GLSLC_EXECUTABLE)
+    if(Vulkan_GLSLC_EXECUTABLE)
+        set(GLSLC_EXECUTABLE ${Vulkan_GLSLC_EXECUTABLE})
+    else()
+        find_program(GLSLC_EXECUTABLE glslc HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin")
+    endif()
+    if(NOT GLSLC_EXECUTABLE)
+        message(FATAL_ERROR "glslc not found, install the Vulkan SDK or pass -DGLSLC_EXECUTABLE!")
+    endif()
+endif()
+
+function(add_embedded_shaders target shader_dir)
+    file(GLOB SHADER_SOURCES ${shader_dir}/*.vert ${shader_dir}/*.frag ${shader_dir}/*.comp)
+    set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/embedded_shaders)
+
+    set(WORD_FILES)
+    set(DEFINITIONS)
+    set(MANIFEST)
+    foreach(SHADER_SOURCE ${SHADER_SOURCES})
+        get_filename_component(SHADER_NAME ${SHADER_SOURCE} NAME)
+        get_filename_component(SHADER_EXTENSION ${SHADER_SOURCE} EXT)
+        string(MAKE_C_IDENTIFIER ${SHADER_NAME} SHADER_IDENTIFIER)
+        string(TOUPPER ${SHADER_IDENTIFIER} SHADER_IDENTIFIER)
+
+        if(SHADER_EXTENSION STREQUAL ".vert")
+            set(SHADER_STAGE VK_SHADER_STAGE_VERTEX_BIT)
+        elseif(SHADER_EXTENSION STREQUAL ".frag")
+            set(SHADER_STAGE VK_SHADER_STAGE_FRAGMENT_BIT)
+        else()
+            set(SHADER_STAGE VK_SHADER_STAGE_COMPUTE_BIT)
+        endif()
+
+        # -mfmt=num writes the words as comma separated hex literals, ready to be included into an initializer.
+        set(WORD_FILE ${OUTPUT_DIR}/${SHADER_NAME}.inc)
+        add_custom_command(
+            OUTPUT ${WORD_FILE}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+            COMMAND ${GLSLC_EXECUTABLE} -mfmt=num -o ${WORD_FILE} ${SHADER_SOURCE}
+            DEPENDS ${SHADER_SOURCE}
+            COMMENT "Compiling ${SHADER_NAME} to SPIR-V"
+            VERBATIM
+        )
+        list(APPEND WORD_FILES ${WORD_FILE})
+
+        string(APPEND DEFINITIONS
+            "inline constexpr uint32_t ${SHADER_IDENTIFIER}_CODE[] =\n{\n#include \"${SHADER_NAME}.inc\"\n};\n"
+            "inline constexpr EmbeddedShader ${SHADER_IDENTIFIER}{\"${SHADER_NAME}\", ${SHADER_STAGE}, ${SHADER_IDENTIFIER}_CODE, sizeof(${SHADER_IDENTIFIER}_CODE) / sizeof(uint32_t)};\n\n")
+        list(APPEND MANIFEST ${SHADER_IDENTIFIER})
+    endforeach()
+
+    string(REPLACE ";" ", " MANIFEST "${MANIFEST}")
+    file(GENERATE OUTPUT ${OUTPUT_DIR}/embedded_shaders.hpp CONTENT
+"// Generated by add_embedded_shaders() from ${shader_dir}, edit the shaders instead.
+#pragma once
+
+#include <cstdint>
+
+#include \"shader_module.hpp\"
+
+namespace tlr::shaders
+{
+
+${DEFINITIONS}inline constexpr EmbeddedShader MANIFEST[] = {${MANIFEST}};
+
+} // namespace tlr::shaders
+")
+
+    target_sources(${target} PRIVATE ${WORD_FILES})
+    target_include_directories(${target} PUBLIC ${OUTPUT_DIR})
+endfunction()
\ No newline at end of file
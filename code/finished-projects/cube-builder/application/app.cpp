@@ -1,27 +1,33 @@
 #include "app.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <cstring>
+#include <stdexcept>
 
 #include "initializers.hpp"
 #include "toolset.hpp"
 #include "shader_module.hpp"
+#include "embedded_shaders.hpp"
+#include "spirv_reflect.hpp"
 
 #define ENQUEUE_OBJ_DEL(lambda) (_deletionQueue).PushFunction(lambda)
 
 namespace tlr
 {
 
-std::string GetAbsolutePath(const std::string& relativePath)
-{
-    std::string fullPath(__FILE__);
-    std::string directory = fullPath.substr(0, fullPath.find_last_of("\\/") + 1);
-    std::string absolutePath = directory + relativePath;
-    return absolutePath;
-}
+// Checked against the embedded SPIR-V so a shader edit can't silently shift the data the C++ side uploads.
+static_assert(spirv::MemberOffset(shaders::SHADER_VERT_CODE, "CameraTransform", "view") == offsetof(CameraTransform, view), "CameraTransform.view doesn't match shader.vert!");
+static_assert(spirv::MemberOffset(shaders::SHADER_VERT_CODE, "CameraTransform", "proj") == offsetof(CameraTransform, proj), "CameraTransform.proj doesn't match shader.vert!");
+static_assert(spirv::MemberOffset(shaders::SHADER_VERT_CODE, "constants", "transform") == offsetof(CubeInfo, transform), "CubeInfo.transform doesn't match the push constant block!");
+static_assert(spirv::MemberOffset(shaders::SHADER_VERT_CODE, "constants", "color") == offsetof(CubeInfo, color), "CubeInfo.color doesn't match the push constant block!");
 
-App::App()
+App::App(const AppBaseCreateInfo& createInfo) : AppBase(createInfo)
 {
     camera.SetMovementSpeed(5.0f);
+    // Start a little above the ground, the chunks around it stream in over the first frames.
+    camera.SetPosition({0.5f, _chunkStreamer.GetGenerator().GetSurfaceHeight(0, 0) + 3.0f, 0.5f});
     
     inputManager->AddKeyPressListener(GLFW_MOUSE_BUTTON_RIGHT, [&]() {
         _world.BuildBlock(camera.GetPosition(), camera.GetForwardVector());
@@ -29,39 +35,62 @@ App::App()
     inputManager->AddKeyPressListener(GLFW_MOUSE_BUTTON_LEFT, [&]() {
         _world.BreakBlock(camera.GetPosition(), camera.GetForwardVector());
     });
-
-    InitCommands();
-    InitSyncStructures();
+    inputManager->AddKeyPressListener(GLFW_KEY_M, [&]() {
+        switch (_renderMode)
+        {
+        case RenderMode::MESHED:    SetRenderMode(RenderMode::INSTANCED); break;
+        case RenderMode::INSTANCED: SetRenderMode(RenderMode::PER_BLOCK); break;
+        case RenderMode::PER_BLOCK: SetRenderMode(RenderMode::MESHED);    break;
+        }
+    });
 
     InitVertexBuffer();
     InitIndexBuffer();
+    ENQUEUE_OBJ_DEL(( [this] {
+        if (_blockInstances.current.capacity > 0)
+        {
+            _blockInstances.current.buffer.Destroy();
+        }
+        if (_blockInstances.pending.capacity > 0)
+        {
+            _blockInstances.pending.buffer.Destroy();
+        }
+    } ));
+    UploadTicket uploadTicket = uploadManager.Flush(); // copies overlap with the setup below
 
     CreateDescriptorSetLayout();
     CreateDescriptorPool();
     CreateDescriptorSets();
     
     CreateGraphicsPipeline();
+    uploadManager.Wait(uploadTicket);
+
+    uint32_t threadCount = createInfo.workerThreadCount > 0 ? createInfo.workerThreadCount : ThreadPool::GetHardwareThreadCount();
+    InitRecordingThreads(threadCount);
+    ENQUEUE_OBJ_DEL(( [this] { DestroyRecordingThreads(); } ));
+    ENQUEUE_OBJ_DEL(( [this] { DestroyChunkMeshes(); } ));
 }
 
 App::~App()
 {
     vkDeviceWaitIdle(device);
+    pipelines.WaitIdle();
     _deletionQueue.Flush();
 }
 
 void App::Update()
 {
+    FrameData& frameData = frameContext.BeginFrame();
     UpdateDesciptorUbos();
+    UpdateStreaming();
+    UpdateChunkMeshes();
 
-    auto frameData = GetCurrentFrameData();
-    vkWaitForFences(device, 1, &frameData.renderFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(device, 1, &frameData.renderFence);
-
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frameData.swapchainSemaphore, VK_NULL_HANDLE, &imageIndex);
+    uint32_t imageIndex = AcquireNextImage(frameData.swapchainSemaphore);
     
-    vkResetCommandBuffer(frameData.commandBuffer, 0);    
+    auto recordingStart = std::chrono::high_resolution_clock::now();
     RecordCommandBuffer(frameData.commandBuffer, imageIndex);
+    _recordingSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - recordingStart).count();
+    _world.ClearChanges(); // meshes and instances are caught up
     
     VkSemaphore waitSemaphores[] = {frameData.swapchainSemaphore};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
@@ -69,74 +98,113 @@ void App::Update()
     VkSubmitInfo submitInfo = init::SubmitInfo(1, waitSemaphores, waitStages, 1, &frameData.commandBuffer, 1, signalSemaphores);
     VK_CHECK_RESULT(vkQueueSubmit(device.queues.graphics, 1, &submitInfo, frameData.renderFence));
 
-    VkPresentInfoKHR presentInfo = init::PresentInfoKHR(1, signalSemaphores, &swapchain.swapchain, &imageIndex);
-    vkQueuePresentKHR(device.queues.present, &presentInfo);
-    _frameNumber = (_frameNumber + 1) % FRAME_OVERLAP;
+    PresentImage(frameData.renderSemaphore, imageIndex);
+    frameContext.EndFrame();
 }
 
-void App::InitCommands()
+void App::BenchmarkRecording(uint32_t frameCount)
 {
-    VkCommandPoolCreateInfo transferCommandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
-    VK_CHECK_RESULT(vkCreateCommandPool(device, &transferCommandPoolCI, nullptr, &_transferPool));
-    ENQUEUE_OBJ_DEL([this] { vkDestroyCommandPool(device, _transferPool, nullptr); });
+    // Recording scales with the block count only in the per-block mode, the meshed one records a draw per chunk.
+    // Streaming is paused so every thread count records the same blocks, and so the meshed counts below are those
+    // of the fill alone. It is one color, the greedy mesher merges each side of it into a single quad per chunk.
+    if (!_world.GetActiveBlocks().empty())
+    {
+        throw std::runtime_error("recording benchmark needs an empty world!");
+    }
+    RenderMode renderMode = _renderMode;
+    SetRenderMode(RenderMode::PER_BLOCK);
+    _isStreaming = false;
+
+    _world.Fill({-10, -10, -10}, {10, 10, 10}, Block::GetRandomColor());
+    size_t blockCount = _world.GetActiveBlocks().size();
+
+    std::cout << "threads,blocks,frames,avg_record_ms,speedup" << std::endl;
 
-    VkCommandPoolCreateInfo commandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-    for (int i = 0; i < FRAME_OVERLAP; ++i)
+    double singleThreadMilliseconds = 0.0;
+    for (uint32_t threadCount = 1; threadCount <= ThreadPool::GetHardwareThreadCount(); ++threadCount)
     {
-        VK_CHECK_RESULT(vkCreateCommandPool(device, &commandPoolCI, nullptr, &_frames[i].commandPool));
-        ENQUEUE_OBJ_DEL(( [this, i] { vkDestroyCommandPool(device, _frames[i].commandPool, nullptr); } ));
+        vkDeviceWaitIdle(device);
+        InitRecordingThreads(threadCount);
 
-        VkCommandBufferAllocateInfo commandBufferAI = init::CommandBufferAllocateInfo(_frames[i].commandPool, 1);
-        VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &commandBufferAI, &_frames[i].commandBuffer));
+        // The first few frames pay for pool growth inside the driver, keep them out of the average.
+        for (uint32_t i = 0; i < frameContext.GetFramesInFlight(); ++i)
+        {
+            Update();
+        }
+
+        _recordingSeconds = 0.0;
+        for (uint32_t i = 0; i < frameCount; ++i)
+        {
+            Update();
+        }
+
+        double averageMilliseconds = _recordingSeconds * 1000.0 / frameCount;
+        if (threadCount == 1)
+        {
+            singleThreadMilliseconds = averageMilliseconds;
+        }
+
+        std::cout << threadCount << ',' << blockCount << ',' << frameCount << ',' << averageMilliseconds << ',' << singleThreadMilliseconds / averageMilliseconds << std::endl;
     }
+
+    size_t chunkCount = 0;
+    size_t meshedTriangleCount = 0;
+    const WorldSpace& worldSpace = _world.GetWorldSpace();
+    worldSpace.ForEachChunk([&](const Chunk& chunk)
+    {
+        _mesher.Build(worldSpace, chunk, _meshScratch);
+        chunkCount += _meshScratch.IsEmpty() ? 0 : 1;
+        meshedTriangleCount += _meshScratch.indices.size() / 3;
+    });
+
+    std::cout << std::endl << "mode,draws,triangles" << std::endl;
+    std::cout << "per_block," << blockCount << ',' << blockCount * _cube.indices.size() / 3 << std::endl;
+    std::cout << "meshed," << chunkCount << ',' << meshedTriangleCount << std::endl;
+    std::cout << "instanced,1," << blockCount * _cube.indices.size() / 3 << std::endl;
+
+    SetRenderMode(renderMode);
+    _isStreaming = true;
 }
 
-void App::InitSyncStructures()
+void App::SetViewRadius(int viewRadius)
 {
-    VkFenceCreateInfo fenceCI = init::FenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-    VkSemaphoreCreateInfo semaphoreCI = init::SemaphoreCreateInfo();
+    _chunkStreamer.SetViewRadius(viewRadius);
+}
 
-    for (int i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        VK_CHECK_RESULT(vkCreateFence(device, &fenceCI, nullptr, &_frames[i].renderFence));
-        VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCI, nullptr, &_frames[i].swapchainSemaphore));
-        VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCI, nullptr, &_frames[i].renderSemaphore));
+void App::InitRecordingThreads(uint32_t threadCount)
+{
+    DestroyRecordingThreads();
+
+    _recordingPool = std::make_unique<ThreadPool>(threadCount);
+    _secondaryCommandBuffers.resize(threadCount);
+    _recordingThreads.resize(frameContext.GetFramesInFlight());
 
-        ENQUEUE_OBJ_DEL(( [this, i] {
-            vkDestroySemaphore(device, _frames[i].renderSemaphore, nullptr);
-            vkDestroySemaphore(device, _frames[i].swapchainSemaphore, nullptr);
-            vkDestroyFence(device, _frames[i].renderFence, nullptr);
-        } ));
+    // Command pools are externally synchronized, so every worker gets its own pool for every frame slot.
+    VkCommandPoolCreateInfo commandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    for (auto& frameThreads : _recordingThreads)
+    {
+        frameThreads.resize(threadCount);
+        for (auto& thread : frameThreads)
+        {
+            VK_CHECK_RESULT(vkCreateCommandPool(device, &commandPoolCI, nullptr, &thread.commandPool));
+            VkCommandBufferAllocateInfo commandBufferAI = init::CommandBufferAllocateInfo(thread.commandPool, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &commandBufferAI, &thread.commandBuffer));
+        }
     }
 }
 
-App::FrameData& App::GetCurrentFrameData()
+void App::DestroyRecordingThreads()
 {
-    return _frames[_frameNumber];
-}
+    _recordingPool.reset();
 
-void App::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
-{
-    VkCommandBufferAllocateInfo allocInfo = init::CommandBufferAllocateInfo(_transferPool, 1);
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    VkBufferCopy copyRegion{};
-    copyRegion.srcOffset = 0;
-    copyRegion.dstOffset = 0;
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo = init::SubmitInfo();
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-    vkQueueSubmit(device.queues.graphics, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(device.queues.graphics);
-    
-    vkFreeCommandBuffers(device, _transferPool, 1, &commandBuffer);
+    for (auto& frameThreads : _recordingThreads)
+    {
+        for (auto& thread : frameThreads)
+        {
+            vkDestroyCommandPool(device, thread.commandPool, nullptr);
+        }
+    }
+    _recordingThreads.clear();
 }
 
 void App::InitIndexBuffer()
@@ -157,14 +225,9 @@ void App::InitIndexBuffer()
     };
 
     VkDeviceSize bufferSize = sizeof(_cube.indices[0]) * _cube.indices.size();
-    Buffer stagingBuffer;
-    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, bufferSize));
-    VK_CHECK_RESULT(stagingBuffer.Map());
-    stagingBuffer.CopyTo(_cube.indices.data(), bufferSize);
     VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &_cube.indexBuffer, bufferSize));
     ENQUEUE_OBJ_DEL(( [this]() { _cube.indexBuffer.Destroy(); } ));
-    CopyBuffer(stagingBuffer.buffer, _cube.indexBuffer.buffer, bufferSize);
-    stagingBuffer.Destroy();
+    uploadManager.Upload(_cube.indexBuffer, _cube.indices.data(), bufferSize);
 }
 
 void App::InitVertexBuffer()
@@ -182,14 +245,9 @@ void App::InitVertexBuffer()
     };
 
     VkDeviceSize bufferSize = sizeof(_cube.vertices[0]) * _cube.vertices.size();
-    Buffer stagingBuffer;
-    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, bufferSize));
-    VK_CHECK_RESULT(stagingBuffer.Map());
-    stagingBuffer.CopyTo(_cube.vertices.data(), bufferSize);
     VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &_cube.vertexBuffer, bufferSize));
     ENQUEUE_OBJ_DEL(([this] { _cube.vertexBuffer.Destroy(); }));
-    CopyBuffer(stagingBuffer.buffer, _cube.vertexBuffer.buffer, bufferSize);
-    stagingBuffer.Destroy();
+    uploadManager.Upload(_cube.vertexBuffer, _cube.vertices.data(), bufferSize);
 }
 
 void App::CreateDescriptorSetLayout()
@@ -208,10 +266,10 @@ void App::CreateDescriptorSetLayout()
 
 void App::CreateDescriptorPool()
 {
-    uint32_t viewTransformCount = static_cast<uint32_t>(FRAME_OVERLAP);
+    uint32_t viewTransformCount = frameContext.GetFramesInFlight();
     VkDescriptorPoolSize viewTransformSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, viewTransformCount);
 
-    uint32_t projTransformCount = static_cast<uint32_t>(FRAME_OVERLAP);
+    uint32_t projTransformCount = frameContext.GetFramesInFlight();
     VkDescriptorPoolSize projTransformSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, projTransformCount);
 
     uint32_t maxDescriptorCount = viewTransformCount + projTransformCount;
@@ -224,10 +282,10 @@ void App::CreateDescriptorPool()
 
 void App::CreateDescriptorSets()
 {
-    _layout0.sets.resize(FRAME_OVERLAP);
-    _layout0.ubos.resize(FRAME_OVERLAP);
+    _layout0.sets.resize(frameContext.GetFramesInFlight());
+    _layout0.ubos.resize(frameContext.GetFramesInFlight());
 
-    for (std::size_t i = 0; i < FRAME_OVERLAP; ++i)
+    for (std::size_t i = 0; i < frameContext.GetFramesInFlight(); ++i)
     {
         auto& ubo = _layout0.ubos[i];
         VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ubo.cameraTransform, sizeof(CameraTransform)));
@@ -235,12 +293,12 @@ void App::CreateDescriptorSets()
         VK_CHECK_RESULT(ubo.cameraTransform.Map());
     }
 
-    uint32_t layout0DescriptorSetsCount = static_cast<uint32_t>(FRAME_OVERLAP);
+    uint32_t layout0DescriptorSetsCount = frameContext.GetFramesInFlight();
     std::vector<VkDescriptorSetLayout> layouts0(layout0DescriptorSetsCount, _layout0);
     VkDescriptorSetAllocateInfo set0AllocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts0.data(), layout0DescriptorSetsCount);
     VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &set0AllocInfo, _layout0.sets.data()));
 
-    for (std::size_t i = 0; i < FRAME_OVERLAP; ++i)
+    for (std::size_t i = 0; i < frameContext.GetFramesInFlight(); ++i)
     {
         auto& set = _layout0.sets[i];
         auto& ubo = _layout0.ubos[i];
@@ -255,74 +313,19 @@ void App::CreateDescriptorSets()
 
 void App::UpdateDesciptorUbos()
 {
+    CPU_PROFILE_SCOPE("UpdateDesciptorUbos");
+
     CameraTransform transform;
     transform.view = camera.GetViewMatrix();
     transform.proj = camera.GetProjectionMatrix();
-    memcpy(_layout0.ubos[_frameNumber].cameraTransform.mapped, &transform, sizeof(CameraTransform));
+    memcpy(_layout0.ubos[frameContext.GetCurrentIndex()].cameraTransform.mapped, &transform, sizeof(CameraTransform));
 }
 
 void App::CreateGraphicsPipeline()
 {
-    // Create shaderStages[]
-    std::string fragSpvPath = GetAbsolutePath("../build/spvs/frag.spv");
-    std::string vertSpvPath = GetAbsolutePath("../build/spvs/vert.spv");
-
-    ShaderModule vertModule(device.device, vertSpvPath, VK_SHADER_STAGE_VERTEX_BIT);
-    ShaderModule fragModule(device.device, fragSpvPath, VK_SHADER_STAGE_FRAGMENT_BIT);
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertModule.GetCreateInfo(), fragModule.GetCreateInfo()};
-
-    // Dynamic states
-    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    VkPipelineDynamicStateCreateInfo dynamicStateCI = init::PipelineDynamicStateCreateInfo(dynamicStates, 0);
-
-    // Vertex input
-    auto bindingDescription = VertexInfo::GetBindingDescription();
-    auto attributeDescriptions = VertexInfo::GetAttributeDescriptions();
-    VkPipelineVertexInputStateCreateInfo vertexInputCI = init::PipelineVertexInputStateCreateInfo();
-    vertexInputCI.vertexBindingDescriptionCount = 1;
-    vertexInputCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputCI.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputCI.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    // Input assembly
-    VkPipelineInputAssemblyStateCreateInfo inputAssemblyCI = init::PipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
-
-    // Depth stencil
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-    depthStencil.depthBoundsTestEnable = VK_FALSE;
-    depthStencil.minDepthBounds = 0.0f; // Optional
-    depthStencil.maxDepthBounds = 1.0f; // Optional
-    depthStencil.stencilTestEnable = VK_FALSE;
-    depthStencil.front = {}; // Optional
-    depthStencil.back = {}; // Optional
-
-    // Viewport state
-    VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
-    VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
-    VkPipelineViewportStateCreateInfo viewportStateCI = init::PipelineViewportStateCreateInfo(1, &viewport, 1, &scissor, 0);
-
-    // Rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterizer = init::PipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_CLOCKWISE, 0);
-
-    // Multisampling
-    VkPipelineMultisampleStateCreateInfo multisampling = init::PipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
-
-    // Color blending
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending = init::PipelineColorBlendStateCreateInfo(1, &colorBlendAttachment);
+    // Shader stages, the modules live in the cache so they outlive the compile
+    ShaderModule vertModule(shaderModuleCache, shaders::SHADER_VERT);
+    ShaderModule fragModule(shaderModuleCache, shaders::SHADER_FRAG);
 
     // Pipeline layout
     VkPipelineLayoutCreateInfo pipelineLayoutCI{};
@@ -342,29 +345,60 @@ void App::CreateGraphicsPipeline()
     VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &_pipelineLayout));
     ENQUEUE_OBJ_DEL(( [this] { vkDestroyPipelineLayout(device, _pipelineLayout, nullptr); } ));
 
-    // Pipeline
-    VkGraphicsPipelineCreateInfo pipelineCI = init::PipelineCreateInfo();
-    pipelineCI.stageCount = 2;
-    pipelineCI.pStages = shaderStages;
-    pipelineCI.pVertexInputState = &vertexInputCI;
-    pipelineCI.pInputAssemblyState = &inputAssemblyCI;
-    pipelineCI.pViewportState = &viewportStateCI;
-    pipelineCI.pRasterizationState = &rasterizer;
-    pipelineCI.pMultisampleState = &multisampling;
-    pipelineCI.pColorBlendState = &colorBlending;
-    pipelineCI.pDynamicState = &dynamicStateCI;
-    pipelineCI.pDepthStencilState = &depthStencil;
-    pipelineCI.renderPass = renderPass;
-    pipelineCI.layout = _pipelineLayout;
-    pipelineCI.subpass = 0;
-    VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &_graphicsPipeline));
-    ENQUEUE_OBJ_DEL(( [this] { vkDestroyPipeline(device, _graphicsPipeline, nullptr); } ));
+    // Pipeline, compiled on a worker thread, RecordCommandBuffer skips the draws until it's ready
+    PipelineBuilder builder;
+    builder.AddShaderStage(vertModule.GetCreateInfo())
+           .AddShaderStage(fragModule.GetCreateInfo())
+           .SetVertexInput(VertexInfo::GetBindingDescription(), VertexInfo::GetAttributeDescriptions())
+           .SetBlendMode(BlendMode::ALPHA)
+           .SetLayout(_pipelineLayout)
+           .SetRenderPass(renderPass);
+    _graphicsPipeline = pipelines.Request(builder);
+
+    // Chunk meshes carry world space positions and colors per vertex, the push constant range goes unused.
+    ShaderModule chunkVertModule(shaderModuleCache, shaders::CHUNK_VERT);
+    PipelineBuilder chunkBuilder;
+    chunkBuilder.AddShaderStage(chunkVertModule.GetCreateInfo())
+                .AddShaderStage(fragModule.GetCreateInfo())
+                .SetVertexInput(ChunkVertexInfo::GetBindingDescription(), ChunkVertexInfo::GetAttributeDescriptions())
+                .SetBlendMode(BlendMode::ALPHA)
+                .SetLayout(_pipelineLayout)
+                .SetRenderPass(renderPass);
+    _chunkPipeline = pipelines.Request(chunkBuilder);
+
+    // The cube's vertices on binding 0, a BlockInstance per block on binding 1.
+    ShaderModule instancedVertModule(shaderModuleCache, shaders::INSTANCED_VERT);
+    PipelineBuilder instancedBuilder;
+    instancedBuilder.AddShaderStage(instancedVertModule.GetCreateInfo())
+                    .AddShaderStage(fragModule.GetCreateInfo())
+                    .SetVertexInput(VertexInfo::GetBindingDescription(), VertexInfo::GetAttributeDescriptions())
+                    .AddVertexInput(BlockInstance::GetBindingDescription(), BlockInstance::GetAttributeDescriptions())
+                    .SetBlendMode(BlendMode::ALPHA)
+                    .SetLayout(_pipelineLayout)
+                    .SetRenderPass(renderPass);
+    _instancedPipeline = pipelines.Request(instancedBuilder);
 }
 
 void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
 {
+    CPU_PROFILE_SCOPE("RecordCommandBuffer");
+
     VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo();
     VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+    gpuProfiler.BeginFrame(cmd, frameContext.GetCurrentIndex());
+
+    // Only the instanced mode draws from the instance buffer, the other modes don't pay for keeping it current.
+    if (_renderMode == RenderMode::INSTANCED)
+    {
+        RecordInstanceUpdates(cmd);
+    }
+    else
+    {
+        ReleaseInstances();
+    }
+
+    // A subpass recorded from secondaries only accepts vkCmdExecuteCommands, so the pass is timed from outside.
+    uint32_t mainPassScope = gpuProfiler.BeginScope(cmd, "MainPass");
 
     std::array<VkClearValue, 2> clearValues{};
     clearValues[0].color = {{1.0f, 1.0f, 1.0f, 1.0f}};
@@ -374,9 +408,71 @@ void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
     renderPassInfo.renderArea.extent = swapchain.extent;
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();    
-    vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipeline);
+    // Nothing to draw with while the pipeline is still compiling, the pass then only clears.
+    if (_renderMode == RenderMode::MESHED)
+    {
+        VkPipeline pipeline = pipelines.Get(_chunkPipeline);
+        if (pipeline != VK_NULL_HANDLE)
+        {
+            // A draw per chunk is too little work to split, the first worker's buffer records it right here.
+            RecordingThread& thread = _recordingThreads[frameContext.GetCurrentIndex()][0];
+            RecordChunks(thread, pipeline, imageIndex);
+            vkCmdExecuteCommands(cmd, 1, &thread.commandBuffer);
+        }
+    }
+    else if (_renderMode == RenderMode::INSTANCED)
+    {
+        VkPipeline pipeline = pipelines.Get(_instancedPipeline);
+        if (pipeline != VK_NULL_HANDLE)
+        {
+            RecordingThread& thread = _recordingThreads[frameContext.GetCurrentIndex()][0];
+            RecordInstances(thread, pipeline, imageIndex);
+            vkCmdExecuteCommands(cmd, 1, &thread.commandBuffer);
+        }
+    }
+    else
+    {
+        VkPipeline pipeline = pipelines.Get(_graphicsPipeline);
+        if (pipeline != VK_NULL_HANDLE)
+        {
+            const std::vector<ActiveBlock>& blocks = _world.GetActiveBlocks();
+            std::vector<RecordingThread>& threads = _recordingThreads[frameContext.GetCurrentIndex()];
+            size_t blocksPerThread = (blocks.size() + threads.size() - 1) / threads.size();
+
+            for (size_t i = 0; i < threads.size(); ++i)
+            {
+                size_t first = std::min(i * blocksPerThread, blocks.size());
+                size_t last = std::min(first + blocksPerThread, blocks.size());
+                _recordingPool->Submit([this, pipeline, &thread = threads[i], &blocks, first, last, imageIndex]() {
+                    RecordBlocks(thread, pipeline, blocks, first, last, imageIndex);
+                });
+                _secondaryCommandBuffers[i] = threads[i].commandBuffer;
+            }
+            _recordingPool->Wait();
+
+            vkCmdExecuteCommands(cmd, static_cast<uint32_t>(_secondaryCommandBuffers.size()), _secondaryCommandBuffers.data());
+        }
+    }
+    
+    vkCmdEndRenderPass(cmd);
+    gpuProfiler.EndScope(cmd, mainPassScope);
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+}
+
+VkCommandBuffer App::BeginSecondary(RecordingThread& thread, VkPipeline pipeline, uint32_t imageIndex)
+{
+    VK_CHECK_RESULT(vkResetCommandPool(device, thread.commandPool, 0));
+
+    VkCommandBufferInheritanceInfo inheritanceInfo = init::CommandBufferInheritanceInfo(renderPass, 0, framebuffers[imageIndex]);
+    VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    
+    VkCommandBuffer cmd = thread.commandBuffer;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
     VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
     vkCmdSetViewport(cmd, 0, 1, &viewport);
@@ -384,17 +480,24 @@ void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
     VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
     vkCmdSetScissor(cmd, 0, 1, &scissor);
     
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_layout0.sets[_frameNumber], 0, nullptr);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_layout0.sets[frameContext.GetCurrentIndex()], 0, nullptr);
+    return cmd;
+}
+
+void App::RecordBlocks(RecordingThread& thread, VkPipeline pipeline, const std::vector<ActiveBlock>& blocks, size_t first, size_t last, uint32_t imageIndex)
+{
+    CPU_PROFILE_SCOPE("RecordBlocks");
+
+    VkCommandBuffer cmd = BeginSecondary(thread, pipeline, imageIndex);
     
     VkBuffer vertexBuffers[] = {_cube.vertexBuffer.buffer};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
     vkCmdBindIndexBuffer(cmd, _cube.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
 
-    std::vector<Block> blocks = _world.GetActiveBlocks();
-    
-    for (const auto& block : blocks)
+    for (size_t i = first; i < last; ++i)
     {
+        Block block(blocks[i].position, blocks[i].GetColor(), true);
         CubeInfo pushConstant;
         pushConstant.color = block.GetColor();
         pushConstant.transform = block.GetModelMatrix();
@@ -403,8 +506,336 @@ void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
         vkCmdDrawIndexed(cmd, static_cast<uint32_t>(_cube.indices.size()), 1, 0, 0, 0);
     }
     
-    vkCmdEndRenderPass(cmd);
     VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
 }
 
+void App::RecordChunks(RecordingThread& thread, VkPipeline pipeline, uint32_t imageIndex)
+{
+    CPU_PROFILE_SCOPE("RecordChunks");
+
+    VkCommandBuffer cmd = BeginSecondary(thread, pipeline, imageIndex);
+
+    _chunkMeshes.ForEach([cmd](const glm::ivec3&, const ChunkDrawData& drawData)
+    {
+        const GpuMesh& mesh = drawData.current;
+        if (mesh.indexCount > 0)
+        {
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(cmd, 0, 1, &mesh.vertexBuffer.buffer, &offset);
+            vkCmdBindIndexBuffer(cmd, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+            vkCmdDrawIndexed(cmd, mesh.indexCount, 1, 0, 0, 0);
+        }
+    });
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+}
+
+void App::RecordInstances(RecordingThread& thread, VkPipeline pipeline, uint32_t imageIndex)
+{
+    CPU_PROFILE_SCOPE("RecordInstances");
+
+    VkCommandBuffer cmd = BeginSecondary(thread, pipeline, imageIndex);
+
+    uint32_t instanceCount = _blockInstances.current.count;
+    if (instanceCount > 0)
+    {
+        VkBuffer vertexBuffers[] = {_cube.vertexBuffer.buffer, _blockInstances.current.buffer.buffer};
+        VkDeviceSize offsets[] = {0, 0};
+        vkCmdBindVertexBuffers(cmd, 0, 2, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(cmd, _cube.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
+        vkCmdDrawIndexed(cmd, static_cast<uint32_t>(_cube.indices.size()), instanceCount, 0, 0, 0);
+    }
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+}
+
+void App::SetRenderMode(RenderMode renderMode)
+{
+    // Edits made in the other modes weren't tracked, the buffer starts over.
+    if (renderMode == RenderMode::INSTANCED && _renderMode != RenderMode::INSTANCED)
+    {
+        _blockInstances.isRebuildNeeded = true;
+    }
+    _renderMode = renderMode;
+}
+
+void App::RecordInstanceUpdates(VkCommandBuffer cmd)
+{
+    // Past this many edited slots a rebuild through the staging ring beats a command per slot. Streaming in a chunk
+    // dirties thousands.
+    static constexpr size_t MAX_PATCHED_SLOTS = 64;
+
+    const std::vector<ActiveBlock>& blocks = _world.GetActiveBlocks();
+    const std::vector<uint32_t>& dirtySlots = _world.GetDirtySlots();
+    uint32_t blockCount = static_cast<uint32_t>(blocks.size());
+
+    if (_blockInstances.hasPending)
+    {
+        if (!uploadManager.IsComplete(_blockInstances.pendingTicket))
+        {
+            // The copy in flight holds an older snapshot, edits in the meantime go into the next rebuild.
+            _blockInstances.isRebuildNeeded |= !dirtySlots.empty();
+            return;
+        }
+        DestroyInstanceBuffer(_blockInstances.current);
+        _blockInstances.current = _blockInstances.pending;
+        _blockInstances.pending = InstanceBuffer();
+        _blockInstances.hasPending = false;
+    }
+
+    if (_blockInstances.isRebuildNeeded || dirtySlots.size() > MAX_PATCHED_SLOTS || blockCount > _blockInstances.current.capacity)
+    {
+        RebuildInstances();
+        return;
+    }
+
+    if (dirtySlots.empty())
+    {
+        return;
+    }
+
+    InstanceBuffer& current = _blockInstances.current;
+    current.count = blockCount;
+    if (blockCount == 0)
+    {
+        return;
+    }
+
+    // Earlier frames may still be reading the slots about to be overwritten.
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    for (uint32_t slot : dirtySlots)
+    {
+        if (slot < blockCount)
+        {
+            vkCmdUpdateBuffer(cmd, current.buffer.buffer, slot * sizeof(BlockInstance), sizeof(BlockInstance), &blocks[slot]);
+        }
+    }
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+// The drawn buffer stays on screen until the new one has been uploaded, in-flight frames never see a copy running.
+void App::RebuildInstances()
+{
+    static_assert(sizeof(ActiveBlock) == sizeof(BlockInstance), "the active set is uploaded as instances as it is");
+
+    const std::vector<ActiveBlock>& blocks = _world.GetActiveBlocks();
+    uint32_t blockCount = static_cast<uint32_t>(blocks.size());
+    _blockInstances.isRebuildNeeded = false;
+
+    if (blockCount == 0)
+    {
+        DestroyInstanceBuffer(_blockInstances.current);
+        return;
+    }
+
+    // Room to spare, so blocks placed afterwards can still be patched in.
+    uint32_t capacity = 1024;
+    while (capacity < blockCount)
+    {
+        capacity *= 2;
+    }
+
+    InstanceBuffer& pending = _blockInstances.pending;
+    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &pending.buffer, capacity * sizeof(BlockInstance)));
+    pending.capacity = capacity;
+    pending.count = blockCount;
+
+    _blockInstances.pendingTicket = uploadManager.Upload(pending.buffer, blocks.data(), blockCount * sizeof(BlockInstance));
+    _blockInstances.hasPending = true;
+    uploadManager.Flush();
+}
+
+void App::ReleaseInstances()
+{
+    // A buffer still being copied into has to wait for its copy.
+    if (_blockInstances.hasPending)
+    {
+        if (!uploadManager.IsComplete(_blockInstances.pendingTicket))
+        {
+            return;
+        }
+        DestroyInstanceBuffer(_blockInstances.pending);
+        _blockInstances.hasPending = false;
+    }
+    DestroyInstanceBuffer(_blockInstances.current);
+}
+
+void App::DestroyInstanceBuffer(InstanceBuffer& instanceBuffer)
+{
+    if (instanceBuffer.capacity > 0)
+    {
+        frameContext.DeferDeletion([buffer = instanceBuffer.buffer]() mutable { buffer.Destroy(); });
+    }
+    instanceBuffer = InstanceBuffer();
+}
+
+void App::UpdateStreaming()
+{
+    CPU_PROFILE_SCOPE("UpdateStreaming");
+
+    // Only hands over what the workers finished, a chunk that isn't generated yet just shows up a frame later.
+    if (_isStreaming)
+    {
+        _chunkStreamer.Update(_world, camera.GetPosition(), camera.GetForwardVector());
+    }
+}
+
+void App::UpdateChunkMeshes()
+{
+    CPU_PROFILE_SCOPE("UpdateChunkMeshes");
+
+    // Only chunks the world marked dirty are remeshed, an unchanged world costs nothing here.
+    const WorldSpace& worldSpace = _world.GetWorldSpace();
+    const std::vector<glm::ivec3>& dirtyChunks = _world.GetDirtyChunks();
+    for (const glm::ivec3& chunkCoord : dirtyChunks)
+    {
+        const Chunk* chunk = worldSpace.FindChunk(chunkCoord);
+        if (chunk == nullptr)
+        {
+            if (ChunkDrawData* drawData = _chunkMeshes.Find(chunkCoord))
+            {
+                RetirePendingMesh(*drawData);
+                DestroyGpuMesh(drawData->current);
+                _chunkMeshes.Erase(chunkCoord);
+            }
+            continue;
+        }
+
+        _mesher.Build(worldSpace, *chunk, _meshScratch);
+
+        ChunkDrawData& drawData = _chunkMeshes[chunkCoord];
+        RetirePendingMesh(drawData);
+        drawData.pendingTicket = CreateGpuMesh(_meshScratch, drawData.pending);
+        drawData.hasPending = true;
+        ++_pendingMeshCount;
+    }
+
+    if (!dirtyChunks.empty())
+    {
+        uploadManager.Flush();
+    }
+    DestroyRetiredMeshes();
+
+    // Nothing uploading is the common case, an unchanged world doesn't walk the chunks at all.
+    if (_pendingMeshCount == 0)
+    {
+        return;
+    }
+
+    _chunkMeshes.ForEach([this](const glm::ivec3&, ChunkDrawData& drawData)
+    {
+        if (drawData.hasPending && uploadManager.IsComplete(drawData.pendingTicket))
+        {
+            DestroyGpuMesh(drawData.current);
+            drawData.current = drawData.pending;
+            drawData.pending = GpuMesh();
+            drawData.hasPending = false;
+            --_pendingMeshCount;
+        }
+    });
+}
+
+UploadTicket App::CreateGpuMesh(const ChunkMesh& mesh, GpuMesh& gpuMesh)
+{
+    gpuMesh = GpuMesh();
+    if (mesh.IsEmpty())
+    {
+        return 0; // complete from the start, there is nothing to upload
+    }
+
+    VkDeviceSize vertexBufferSize = sizeof(mesh.vertices[0]) * mesh.vertices.size();
+    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &gpuMesh.vertexBuffer, vertexBufferSize));
+    uploadManager.Upload(gpuMesh.vertexBuffer, mesh.vertices.data(), vertexBufferSize);
+
+    VkDeviceSize indexBufferSize = sizeof(mesh.indices[0]) * mesh.indices.size();
+    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &gpuMesh.indexBuffer, indexBufferSize));
+    gpuMesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    return uploadManager.Upload(gpuMesh.indexBuffer, mesh.indices.data(), indexBufferSize);
+}
+
+void App::DestroyGpuMesh(GpuMesh& gpuMesh)
+{
+    if (gpuMesh.indexCount > 0)
+    {
+        // Frames in flight may still draw it.
+        frameContext.DeferDeletion([vertexBuffer = gpuMesh.vertexBuffer, indexBuffer = gpuMesh.indexBuffer]() mutable {
+            vertexBuffer.Destroy();
+            indexBuffer.Destroy();
+        });
+    }
+    gpuMesh = GpuMesh();
+}
+
+// Never drawn, but its copy may still be running on the transfer queue. The render thread doesn't wait for it.
+void App::RetirePendingMesh(ChunkDrawData& drawData)
+{
+    if (!drawData.hasPending)
+    {
+        return;
+    }
+
+    if (uploadManager.IsComplete(drawData.pendingTicket))
+    {
+        DestroyGpuMesh(drawData.pending);
+    }
+    else
+    {
+        _retiredMeshes.push_back({drawData.pendingTicket, drawData.pending});
+        drawData.pending = GpuMesh();
+    }
+    drawData.hasPending = false;
+    --_pendingMeshCount;
+}
+
+void App::DestroyRetiredMeshes()
+{
+    // Only meshes replaced before their upload landed end up here, the list stays short.
+    for (size_t i = 0; i < _retiredMeshes.size();)
+    {
+        if (uploadManager.IsComplete(_retiredMeshes[i].ticket))
+        {
+            DestroyGpuMesh(_retiredMeshes[i].mesh);
+            _retiredMeshes[i] = _retiredMeshes.back();
+            _retiredMeshes.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void App::DestroyChunkMeshes()
+{
+    // Runs with the device idle, nothing can use the meshes anymore.
+    _chunkMeshes.ForEach([](const glm::ivec3&, ChunkDrawData& drawData)
+    {
+        for (GpuMesh* mesh : {&drawData.current, &drawData.pending})
+        {
+            if (mesh->indexCount > 0)
+            {
+                mesh->vertexBuffer.Destroy();
+                mesh->indexBuffer.Destroy();
+            }
+        }
+    });
+    _chunkMeshes.Clear();
+
+    for (RetiredMesh& retired : _retiredMeshes)
+    {
+        if (retired.mesh.indexCount > 0)
+        {
+            retired.mesh.vertexBuffer.Destroy();
+            retired.mesh.indexBuffer.Destroy();
+        }
+    }
+    _retiredMeshes.clear();
+}
+
 } // namespace tlr
\ No newline at end of file
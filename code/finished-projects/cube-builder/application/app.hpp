@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -10,10 +11,12 @@
 
 #include "app_base.hpp"
 #include "world.hpp"
+#include "chunk_map.hpp"
+#include "chunk_mesher.hpp"
+#include "chunk_streamer.hpp"
 #include "shader_vertex.hpp"
 #include "cube_push_constant.hpp"
-
-#define FRAME_OVERLAP 2
+#include "thread_pool.hpp"
 
 namespace tlr
 {
@@ -35,30 +38,27 @@ struct Layout
     std::vector<VkDescriptorSet> sets;
 };
 
+enum class RenderMode
+{
+    PER_BLOCK, // a push constant and a cube draw per block, recorded on every worker thread
+    MESHED,    // one greedy mesh and one draw per chunk
+    INSTANCED  // one instanced cube draw for the whole world
+};
+
 class App : public AppBase
 {
 public:
-    App();
+    App(const AppBaseCreateInfo& createInfo);
     ~App();
 
+    void BenchmarkRecording(uint32_t frameCount);
+    // In chunks, how far around the camera the world is kept loaded.
+    void SetViewRadius(int viewRadius);
+
 protected:
     void Update() override;
 
 private:
-    struct FrameData
-    {
-        VkCommandPool   commandPool;
-        VkCommandBuffer commandBuffer;
-        VkSemaphore     swapchainSemaphore, renderSemaphore;
-        VkFence         renderFence;
-    }                _frames[FRAME_OVERLAP];
-    int              _frameNumber = 0;
-    VkCommandPool    _transferPool;
-    
-    void       InitCommands();
-    void       InitSyncStructures();
-    FrameData& GetCurrentFrameData();
-
     struct
     {
         Buffer vertexBuffer;
@@ -67,7 +67,6 @@ private:
         std::vector<int16_t> indices;
     } _cube;
 
-    void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
     void InitVertexBuffer();
     void InitIndexBuffer();
 
@@ -84,12 +83,95 @@ private:
     void UpdateDesciptorUbos();
 
     VkPipelineLayout _pipelineLayout;
-    VkPipeline _graphicsPipeline;
+    PipelineHandle   _graphicsPipeline;
+
+    PipelineHandle   _chunkPipeline;
+    PipelineHandle   _instancedPipeline;
+    RenderMode       _renderMode = RenderMode::MESHED;
 
     void CreateGraphicsPipeline();
     void RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex);
 
-    World _world;
+    struct RecordingThread
+    {
+        VkCommandPool   commandPool;
+        VkCommandBuffer commandBuffer;
+    };
+    std::unique_ptr<ThreadPool>               _recordingPool;
+    std::vector<std::vector<RecordingThread>> _recordingThreads; // [frame in flight][worker]
+    std::vector<VkCommandBuffer>              _secondaryCommandBuffers;
+    double                                    _recordingSeconds = 0.0;
+
+    void InitRecordingThreads(uint32_t threadCount);
+    void DestroyRecordingThreads();
+    VkCommandBuffer BeginSecondary(RecordingThread& thread, VkPipeline pipeline, uint32_t imageIndex);
+    void RecordBlocks(RecordingThread& thread, VkPipeline pipeline, const std::vector<ActiveBlock>& blocks, size_t first, size_t last, uint32_t imageIndex);
+    void RecordChunks(RecordingThread& thread, VkPipeline pipeline, uint32_t imageIndex);
+    void RecordInstances(RecordingThread& thread, VkPipeline pipeline, uint32_t imageIndex);
+
+    struct GpuMesh
+    {
+        Buffer   vertexBuffer;
+        Buffer   indexBuffer;
+        uint32_t indexCount = 0;
+    };
+    // The drawn mesh is only swapped once the upload of its replacement finished, edits never show a hole.
+    struct ChunkDrawData
+    {
+        GpuMesh      current;
+        GpuMesh      pending;
+        UploadTicket pendingTicket = 0;
+        bool         hasPending = false;
+    };
+    // A pending mesh that got replaced or unloaded before its upload finished, destroyed once the ticket completed.
+    struct RetiredMesh
+    {
+        UploadTicket ticket;
+        GpuMesh      mesh;
+    };
+    ChunkMap<ChunkDrawData>  _chunkMeshes;
+    ChunkMesher              _mesher;
+    ChunkMesh                _meshScratch;
+    uint32_t                 _pendingMeshCount = 0;
+    std::vector<RetiredMesh> _retiredMeshes;
+
+    void         UpdateChunkMeshes();
+    UploadTicket CreateGpuMesh(const ChunkMesh& mesh, GpuMesh& gpuMesh);
+    void         DestroyGpuMesh(GpuMesh& gpuMesh);
+    void         RetirePendingMesh(ChunkDrawData& drawData);
+    void         DestroyRetiredMeshes();
+    void         DestroyChunkMeshes();
+
+    // Slot i of the device local buffer is World's active block i. Only kept while the instanced mode is on, entering
+    // it rebuilds the buffer. Rebuilds go through the upload manager into a new buffer that replaces the drawn one once
+    // its copy landed, a handful of edited slots are patched in place with vkCmdUpdateBuffer ahead of the render pass.
+    struct InstanceBuffer
+    {
+        Buffer   buffer;
+        uint32_t capacity = 0;
+        uint32_t count = 0;
+    };
+    struct
+    {
+        InstanceBuffer current;
+        InstanceBuffer pending;
+        UploadTicket   pendingTicket = 0;
+        bool           hasPending = false;
+        bool           isRebuildNeeded = false;
+    } _blockInstances;
+
+    void SetRenderMode(RenderMode renderMode);
+    void RecordInstanceUpdates(VkCommandBuffer cmd);
+    void RebuildInstances();
+    void ReleaseInstances();
+    void DestroyInstanceBuffer(InstanceBuffer& instanceBuffer);
+
+    World         _world;
+    ChunkStreamer _chunkStreamer;
+    bool          _isStreaming = true;
+
+    void UpdateStreaming();
+
     DeletionQueue _deletionQueue;
 };
 
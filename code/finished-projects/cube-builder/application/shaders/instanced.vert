@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in ivec3 inBlockPosition;
+layout(location = 2) in vec4 inColor;
+
+layout(set = 0, binding = 0) uniform CameraTransform
+{
+    mat4 view;
+    mat4 proj;
+} camera;
+
+layout(location = 0) out vec3 fragColor;
+
+void main()
+{
+    gl_Position = camera.proj * camera.view * vec4(inPosition + vec3(inBlockPosition), 1.0);
+    fragColor = inColor.rgb;
+}
\ No newline at end of file
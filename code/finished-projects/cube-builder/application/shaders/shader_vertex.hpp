@@ -7,6 +7,7 @@
 #include <glm/glm.hpp>
 
 #include "initializers.hpp"
+#include "chunk_mesher.hpp"
 
 namespace tlr
 {
@@ -29,4 +30,44 @@ struct VertexInfo
     }
 };
 
+// Vertex input of chunk.vert, the mesher writes MeshVertex directly into the vertex buffer.
+struct ChunkVertexInfo
+{
+    static VkVertexInputBindingDescription GetBindingDescription()
+    {
+        VkVertexInputBindingDescription bindingDescription = init::VertexInputBindingDescription(0, sizeof(MeshVertex), VK_VERTEX_INPUT_RATE_VERTEX);
+        return bindingDescription;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 2> GetAttributeDescriptions()
+    {
+        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+        attributeDescriptions[0] = init::VertexInputAttributeDescription(0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, position));
+        attributeDescriptions[1] = init::VertexInputAttributeDescription(0, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, color));
+        return attributeDescriptions;
+    }
+};
+
+// Per-instance input of instanced.vert, 16 bytes a block instead of a mat4 and a color. Same layout as the world's
+// ActiveBlock, the active set uploads as it is.
+struct BlockInstance
+{
+    glm::ivec3 position;
+    uint32_t   color; // RGBA8, the attribute unpacks it to a vec4
+
+    static VkVertexInputBindingDescription GetBindingDescription()
+    {
+        VkVertexInputBindingDescription bindingDescription = init::VertexInputBindingDescription(1, sizeof(BlockInstance), VK_VERTEX_INPUT_RATE_INSTANCE);
+        return bindingDescription;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 2> GetAttributeDescriptions()
+    {
+        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+        attributeDescriptions[0] = init::VertexInputAttributeDescription(1, 1, VK_FORMAT_R32G32B32_SINT, offsetof(BlockInstance, position));
+        attributeDescriptions[1] = init::VertexInputAttributeDescription(1, 2, VK_FORMAT_R8G8B8A8_UNORM, offsetof(BlockInstance, color));
+        return attributeDescriptions;
+    }
+};
+
 } // namespace tlr
\ No newline at end of file
@@ -6,11 +6,11 @@
 namespace tlr
 {
 
-void Block::Initialize(const glm::ivec3& position)
+Block::Block(const glm::ivec3& position, const glm::vec3& color, bool isPlaced) :
+    _position(position),
+    _color(color),
+    _isPlaced(isPlaced)
 {
-    assert(!_isInitialized && "position cannot be changed after initialization!");
-    _position = position;
-    _color = {1.0f, 0.0f, 0.0f};
 }
 
 glm::ivec3 Block::GetPositionFromCenter(const glm::vec3& center)
@@ -44,21 +44,9 @@ bool Block::IsPlaced() const
     return _isPlaced;
 }
 
-void Block::Place()
+glm::vec3 Block::GetRandomColor()
 {
-    _color = GetRandomVec3();
-    _isPlaced = true;
-}
-
-void Block::Break()
-{
-    _isPlaced = false;
-}
-
-glm::vec3 Block::GetRandomVec3()
-{
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    static std::mt19937 gen(std::random_device{}());
     std::uniform_real_distribution<> dis(0.0, 1.0);
 
     float x = static_cast<float>(dis(gen));
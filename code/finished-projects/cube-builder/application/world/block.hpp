@@ -4,13 +4,18 @@
 
 namespace tlr
 {
-    
+
+// A copy of one cell, the world itself only stores occupancy bits and palette indices per chunk.
 class Block
 {
 public:
     static constexpr glm::vec3 CORNER_OFFSET{1, 1, 1};
 
     static glm::ivec3 GetPositionFromCenter(const glm::vec3& center);
+    static glm::vec3  GetRandomColor();
+
+    Block() = default;
+    Block(const glm::ivec3& position, const glm::vec3& color, bool isPlaced);
 
     glm::ivec3 GetPosition()    const;
     glm::vec3  GetColor()       const;
@@ -18,17 +23,10 @@ public:
     glm::mat4  GetModelMatrix() const;
     bool       IsPlaced()       const;
 
-    void       Initialize(const glm::ivec3& position);
-    void       Place();
-    void       Break();
-
 private:
-    glm::ivec3 _position;
-    glm::vec3  _color;
+    glm::ivec3 _position{0};
+    glm::vec3  _color{0.0f};
     bool       _isPlaced = false;
-    bool       _isInitialized = false;
-
-    glm::vec3 GetRandomVec3();
 };
 
 } // namespace tlr
\ No newline at end of file
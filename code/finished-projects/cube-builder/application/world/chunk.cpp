@@ -0,0 +1,216 @@
+#include "chunk.hpp"
+
+#include <utility>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace tlr
+{
+
+Chunk::Chunk(const glm::ivec3& coord) : _coord(coord)
+{
+}
+
+glm::ivec3 Chunk::GetCoord() const
+{
+    return _coord;
+}
+
+glm::ivec3 Chunk::GetOrigin() const
+{
+    return _coord * SIZE;
+}
+
+glm::ivec3 Chunk::GetPosition(int index) const
+{
+    return GetOrigin() + GetLocalPosition(index);
+}
+
+glm::vec3 Chunk::GetColor(int index) const
+{
+    return _palette.empty() ? glm::vec3(0.0f) : _palette[_paletteIndices[index]];
+}
+
+uint8_t Chunk::GetPaletteIndex(int index) const
+{
+    return _paletteIndices[index];
+}
+
+Block Chunk::GetBlock(int index) const
+{
+    return Block(GetPosition(index), GetColor(index), IsPlaced(index));
+}
+
+void Chunk::Place(int index, const glm::vec3& color)
+{
+    _mayHaveUnusedEntries |= IsPlaced(index);
+    _paletteIndices[index] = GetOrAddPaletteEntry(color);
+    _occupancy[index >> 6] |= uint64_t(1) << (index & 63);
+}
+
+void Chunk::Break(int index)
+{
+    _mayHaveUnusedEntries = true;
+    _occupancy[index >> 6] &= ~(uint64_t(1) << (index & 63));
+}
+
+bool Chunk::IsEmpty() const
+{
+    uint64_t any = 0;
+    for (uint64_t word : _occupancy)
+    {
+        any |= word;
+    }
+    return any == 0;
+}
+
+bool Chunk::IsFull() const
+{
+    uint64_t all = ~uint64_t(0);
+    for (uint64_t word : _occupancy)
+    {
+        all &= word;
+    }
+    return all == ~uint64_t(0);
+}
+
+int Chunk::GetPlacedCount() const
+{
+    int count = 0;
+    for (uint64_t word : _occupancy)
+    {
+#ifdef _MSC_VER
+        count += static_cast<int>(__popcnt64(word));
+#else
+        count += __builtin_popcountll(word);
+#endif
+    }
+    return count;
+}
+
+int Chunk::GetPlacedCountBefore(int index) const
+{
+    int count = 0;
+    int lastWord = index >> 6;
+    for (int word = 0; word <= lastWord; ++word)
+    {
+        uint64_t bits = _occupancy[word];
+        if (word == lastWord)
+        {
+            bits &= (uint64_t(1) << (index & 63)) - 1;
+        }
+#ifdef _MSC_VER
+        count += static_cast<int>(__popcnt64(bits));
+#else
+        count += __builtin_popcountll(bits);
+#endif
+    }
+    return count;
+}
+
+bool Chunk::IsDirty() const
+{
+    return _isDirty;
+}
+
+void Chunk::SetDirty(bool isDirty)
+{
+    _isDirty = isDirty;
+}
+
+const std::array<uint64_t, Chunk::WORD_COUNT>& Chunk::GetOccupancy() const
+{
+    return _occupancy;
+}
+
+const std::vector<glm::vec3>& Chunk::GetPalette() const
+{
+    return _palette;
+}
+
+int Chunk::CountTrailingZeros(uint64_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+uint8_t Chunk::GetOrAddPaletteEntry(const glm::vec3& color)
+{
+    for (size_t i = 0; i < _palette.size(); ++i)
+    {
+        if (_palette[i] == color)
+        {
+            return static_cast<uint8_t>(i);
+        }
+    }
+
+    // Compacting walks every cell, it only pays off once something was broken or painted over.
+    if (_palette.size() == MAX_PALETTE_SIZE && _mayHaveUnusedEntries)
+    {
+        CompactPalette();
+    }
+
+    // Every entry is still in use, the block takes the closest color already in the chunk.
+    if (_palette.size() == MAX_PALETTE_SIZE)
+    {
+        return FindNearestPaletteEntry(color);
+    }
+
+    _palette.push_back(color);
+    return static_cast<uint8_t>(_palette.size() - 1);
+}
+
+uint8_t Chunk::FindNearestPaletteEntry(const glm::vec3& color) const
+{
+    size_t nearest = 0;
+    float nearestDistance = glm::dot(_palette[0] - color, _palette[0] - color);
+    for (size_t i = 1; i < _palette.size(); ++i)
+    {
+        float distance = glm::dot(_palette[i] - color, _palette[i] - color);
+        if (distance < nearestDistance)
+        {
+            nearest = i;
+            nearestDistance = distance;
+        }
+    }
+    return static_cast<uint8_t>(nearest);
+}
+
+// Drops the entries only broken cells point at.
+void Chunk::CompactPalette()
+{
+    _mayHaveUnusedEntries = false;
+
+    std::array<int, MAX_PALETTE_SIZE> remap;
+    remap.fill(-1);
+
+    ForEachPlaced([this, &remap](int index)
+    {
+        remap[_paletteIndices[index]] = 0;
+    });
+
+    std::vector<glm::vec3> palette;
+    for (int i = 0; i < static_cast<int>(_palette.size()); ++i)
+    {
+        if (remap[i] == 0)
+        {
+            remap[i] = static_cast<int>(palette.size());
+            palette.push_back(_palette[i]);
+        }
+    }
+
+    ForEachPlaced([this, &remap](int index)
+    {
+        _paletteIndices[index] = static_cast<uint8_t>(remap[_paletteIndices[index]]);
+    });
+    _palette = std::move(palette);
+}
+
+} // namespace tlr
\ No newline at end of file
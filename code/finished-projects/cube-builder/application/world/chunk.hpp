@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block.hpp"
+
+namespace tlr
+{
+
+// A 16x16x16 cube of cells, x varies fastest in the flat index. Chunk coordinates are world positions divided by SIZE
+// rounded towards negative infinity, so the chunk at (-1, 0, 0) holds x in [-16, -1].
+// Occupancy is one bit per cell, appearance is a byte per cell indexing into the chunk's own color palette. That is
+// a little over a byte per cell instead of a whole Block, and whole chunk queries run on 64 cells at a time.
+class Chunk
+{
+public:
+    static constexpr int SIZE_LOG2 = 4;
+    static constexpr int SIZE = 1 << SIZE_LOG2;
+    static constexpr int MASK = SIZE - 1;
+    static constexpr int VOLUME = SIZE * SIZE * SIZE;
+    static constexpr int WORD_COUNT = VOLUME / 64;
+    static constexpr int MAX_PALETTE_SIZE = 256;
+
+    // Arithmetic shift floors for negative positions too.
+    static glm::ivec3 GetChunkCoord(const glm::ivec3& position)
+    {
+        return {position.x >> SIZE_LOG2, position.y >> SIZE_LOG2, position.z >> SIZE_LOG2};
+    }
+
+    static glm::ivec3 GetLocalPosition(const glm::ivec3& position)
+    {
+        return {position.x & MASK, position.y & MASK, position.z & MASK};
+    }
+
+    static int GetIndex(const glm::ivec3& localPosition)
+    {
+        return localPosition.x | (localPosition.y << SIZE_LOG2) | (localPosition.z << (2 * SIZE_LOG2));
+    }
+
+    static glm::ivec3 GetLocalPosition(int index)
+    {
+        return {index & MASK, (index >> SIZE_LOG2) & MASK, index >> (2 * SIZE_LOG2)};
+    }
+
+    explicit Chunk(const glm::ivec3& coord);
+
+    glm::ivec3 GetCoord() const;
+    glm::ivec3 GetOrigin() const;
+    glm::ivec3 GetPosition(int index) const;
+
+    bool      IsPlaced(int index) const
+    {
+        return (_occupancy[index >> 6] >> (index & 63)) & 1;
+    }
+    glm::vec3 GetColor(int index) const;
+    uint8_t   GetPaletteIndex(int index) const;
+    Block     GetBlock(int index) const;
+    void      Place(int index, const glm::vec3& color);
+    void      Break(int index);
+
+    bool IsEmpty() const;
+    bool IsFull() const;
+    int  GetPlacedCount() const;
+    // Placed cells with a smaller index, i.e. where index ranks among the placed cells. Its own bit doesn't count.
+    int  GetPlacedCountBefore(int index) const;
+
+    // Set by World when the chunk's faces may have changed, cleared once the consumers caught up.
+    bool IsDirty() const;
+    void SetDirty(bool isDirty);
+
+    const std::array<uint64_t, WORD_COUNT>& GetOccupancy() const;
+    const std::vector<glm::vec3>&           GetPalette() const;
+
+    // f(int index) for every placed cell in index order, skips empty words entirely.
+    template <typename F>
+    void ForEachPlaced(F&& f) const
+    {
+        for (int word = 0; word < WORD_COUNT; ++word)
+        {
+            uint64_t bits = _occupancy[word];
+            while (bits != 0)
+            {
+                f(word * 64 + CountTrailingZeros(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    glm::ivec3                       _coord;
+    std::array<uint64_t, WORD_COUNT> _occupancy{};
+    std::array<uint8_t, VOLUME>      _paletteIndices{};
+    std::vector<glm::vec3>           _palette;
+    bool                             _isDirty = false;
+    bool                             _mayHaveUnusedEntries = false; // a cell let go of its entry since the last compaction
+
+    static int CountTrailingZeros(uint64_t bits);
+
+    uint8_t GetOrAddPaletteEntry(const glm::vec3& color);
+    uint8_t FindNearestPaletteEntry(const glm::vec3& color) const;
+    void    CompactPalette();
+};
+
+// What WorldSpace hands out for writing, a chunk and a cell index standing in for a Block&.
+class BlockRef
+{
+public:
+    BlockRef(Chunk& chunk, int index) : _chunk(&chunk), _index(index) {}
+
+    glm::ivec3 GetPosition() const { return _chunk->GetPosition(_index); }
+    glm::vec3  GetColor()    const { return _chunk->GetColor(_index); }
+    bool       IsPlaced()    const { return _chunk->IsPlaced(_index); }
+    Block      Get()         const { return _chunk->GetBlock(_index); }
+
+    void Place() { _chunk->Place(_index, Block::GetRandomColor()); }
+    void Place(const glm::vec3& color) { _chunk->Place(_index, color); }
+    void Break() { _chunk->Break(_index); }
+
+private:
+    Chunk* _chunk;
+    int    _index;
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace tlr
+{
+
+// Open addressing hash map keyed by integer grid coordinates, chunk coordinates or block positions. Slots live in one
+// array and are probed linearly, a lookup is a hash and usually a single compare. Removed slots are left as tombstones
+// until the next rehash, so erasing never moves other entries. Values are moved on rehash, keep them cheap to move
+// (e.g. unique_ptrs).
+template <typename T>
+class ChunkMap
+{
+public:
+    ChunkMap()
+    {
+        _slots.resize(MIN_CAPACITY);
+    }
+
+    T* Find(const glm::ivec3& key)
+    {
+        size_t index = FindIndex(key);
+        return index == NOT_FOUND ? nullptr : &_slots[index].value;
+    }
+
+    const T* Find(const glm::ivec3& key) const
+    {
+        size_t index = FindIndex(key);
+        return index == NOT_FOUND ? nullptr : &_slots[index].value;
+    }
+
+    // Default constructs the value if the key isn't in the map yet.
+    T& operator[](const glm::ivec3& key)
+    {
+        size_t index = FindIndex(key);
+        if (index != NOT_FOUND)
+        {
+            return _slots[index].value;
+        }
+
+        if ((_size + _tombstoneCount + 1) * 2 > _slots.size())
+        {
+            Rehash(_size * 2 >= _slots.size() / 2 ? _slots.size() * 2 : _slots.size());
+        }
+
+        size_t mask = _slots.size() - 1;
+        for (size_t i = Hash(key) & mask;; i = (i + 1) & mask)
+        {
+            Slot& slot = _slots[i];
+            if (slot.state != SlotState::FULL)
+            {
+                _tombstoneCount -= slot.state == SlotState::TOMBSTONE ? 1 : 0;
+                slot.key = key;
+                slot.state = SlotState::FULL;
+                slot.value = T();
+                ++_size;
+                return slot.value;
+            }
+        }
+    }
+
+    bool Erase(const glm::ivec3& key)
+    {
+        size_t index = FindIndex(key);
+        if (index == NOT_FOUND)
+        {
+            return false;
+        }
+
+        _slots[index].state = SlotState::TOMBSTONE;
+        _slots[index].value = T();
+        --_size;
+        ++_tombstoneCount;
+        return true;
+    }
+
+    // f(const glm::ivec3& key, T& value), the map must not be modified while iterating.
+    template <typename F>
+    void ForEach(F&& f)
+    {
+        for (Slot& slot : _slots)
+        {
+            if (slot.state == SlotState::FULL)
+            {
+                f(slot.key, slot.value);
+            }
+        }
+    }
+
+    template <typename F>
+    void ForEach(F&& f) const
+    {
+        for (const Slot& slot : _slots)
+        {
+            if (slot.state == SlotState::FULL)
+            {
+                f(slot.key, slot.value);
+            }
+        }
+    }
+
+    void Clear()
+    {
+        _slots.clear();
+        _slots.resize(MIN_CAPACITY);
+        _size = 0;
+        _tombstoneCount = 0;
+    }
+
+    size_t GetSize()     const { return _size; }
+    size_t GetCapacity() const { return _slots.size(); }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 64;
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    enum class SlotState : uint8_t
+    {
+        EMPTY,
+        FULL,
+        TOMBSTONE
+    };
+
+    struct Slot
+    {
+        glm::ivec3 key{0};
+        SlotState  state = SlotState::EMPTY;
+        T          value{};
+    };
+
+    std::vector<Slot> _slots;
+    size_t            _size = 0;
+    size_t            _tombstoneCount = 0;
+
+    // Neighbouring chunks differ in one coordinate by one, the multiply and fold spread that over the low bits.
+    static size_t Hash(const glm::ivec3& key)
+    {
+        uint64_t h = static_cast<uint32_t>(key.x) * 0x9E3779B1ull;
+        h ^= static_cast<uint32_t>(key.y) * 0x85EBCA77ull;
+        h ^= static_cast<uint32_t>(key.z) * 0xC2B2AE3Dull;
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    size_t FindIndex(const glm::ivec3& key) const
+    {
+        size_t mask = _slots.size() - 1;
+        for (size_t i = Hash(key) & mask;; i = (i + 1) & mask)
+        {
+            const Slot& slot = _slots[i];
+            if (slot.state == SlotState::EMPTY)
+            {
+                return NOT_FOUND;
+            }
+            if (slot.state == SlotState::FULL && slot.key == key)
+            {
+                return i;
+            }
+        }
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<Slot> old = std::move(_slots);
+        _slots.clear();
+        _slots.resize(capacity);
+        _tombstoneCount = 0;
+
+        size_t mask = capacity - 1;
+        for (Slot& slot : old)
+        {
+            if (slot.state != SlotState::FULL)
+            {
+                continue;
+            }
+            size_t i = Hash(slot.key) & mask;
+            while (_slots[i].state == SlotState::FULL)
+            {
+                i = (i + 1) & mask;
+            }
+            _slots[i].key = slot.key;
+            _slots[i].state = SlotState::FULL;
+            _slots[i].value = std::move(slot.value);
+        }
+    }
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "chunk_mesher.hpp"
+
+namespace tlr
+{
+
+void ChunkMesher::Build(const WorldSpace& worldSpace, const Chunk& chunk, ChunkMesh& mesh)
+{
+    mesh.Clear();
+    if (chunk.IsEmpty())
+    {
+        return;
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int direction = -1; direction <= 1; direction += 2)
+        {
+            for (int slice = 0; slice < Chunk::SIZE; ++slice)
+            {
+                BuildSlice(worldSpace, chunk, axis, direction, slice);
+                MergeSlice(chunk, axis, direction, slice, mesh);
+            }
+        }
+    }
+}
+
+void ChunkMesher::BuildSlice(const WorldSpace& worldSpace, const Chunk& chunk, int axis, int direction, int slice)
+{
+    int uAxis = (axis + 1) % 3;
+    int vAxis = (axis + 2) % 3;
+    glm::ivec3 origin = chunk.GetOrigin();
+
+    for (int v = 0; v < Chunk::SIZE; ++v)
+    {
+        for (int u = 0; u < Chunk::SIZE; ++u)
+        {
+            glm::ivec3 local;
+            local[axis] = slice;
+            local[uAxis] = u;
+            local[vAxis] = v;
+
+            int index = Chunk::GetIndex(local);
+            int& face = _mask[u + v * Chunk::SIZE];
+            face = NO_FACE;
+            if (!chunk.IsPlaced(index))
+            {
+                continue;
+            }
+
+            // Only the outermost slices look into the neighbouring chunk, everything else stays in this one.
+            glm::ivec3 neighbour = local;
+            neighbour[axis] += direction;
+            bool isNeighbourInChunk = neighbour[axis] >= 0 && neighbour[axis] < Chunk::SIZE;
+            bool isHidden = isNeighbourInChunk ? chunk.IsPlaced(Chunk::GetIndex(neighbour)) : worldSpace.IsPlaced(origin + neighbour);
+            if (!isHidden)
+            {
+                face = chunk.GetPaletteIndex(index) + 1;
+            }
+        }
+    }
+}
+
+void ChunkMesher::MergeSlice(const Chunk& chunk, int axis, int direction, int slice, ChunkMesh& mesh)
+{
+    int uAxis = (axis + 1) % 3;
+    int vAxis = (axis + 2) % 3;
+    const std::vector<glm::vec3>& palette = chunk.GetPalette();
+
+    for (int v = 0; v < Chunk::SIZE; ++v)
+    {
+        for (int u = 0; u < Chunk::SIZE;)
+        {
+            int face = _mask[u + v * Chunk::SIZE];
+            if (face == NO_FACE)
+            {
+                ++u;
+                continue;
+            }
+
+            int width = 1;
+            while (u + width < Chunk::SIZE && _mask[u + width + v * Chunk::SIZE] == face)
+            {
+                ++width;
+            }
+
+            int height = 1;
+            for (; v + height < Chunk::SIZE; ++height)
+            {
+                bool isRowMatching = true;
+                for (int i = 0; i < width && isRowMatching; ++i)
+                {
+                    isRowMatching = _mask[u + i + (v + height) * Chunk::SIZE] == face;
+                }
+                if (!isRowMatching)
+                {
+                    break;
+                }
+            }
+
+            for (int j = 0; j < height; ++j)
+            {
+                for (int i = 0; i < width; ++i)
+                {
+                    _mask[u + i + (v + j) * Chunk::SIZE] = NO_FACE;
+                }
+            }
+
+            // Faces pointing along +axis sit on the far side of their cells.
+            glm::vec3 corner = glm::vec3(chunk.GetOrigin());
+            corner[axis] += static_cast<float>(slice + (direction > 0 ? 1 : 0));
+            corner[uAxis] += static_cast<float>(u);
+            corner[vAxis] += static_cast<float>(v);
+
+            glm::vec3 du(0.0f);
+            glm::vec3 dv(0.0f);
+            du[uAxis] = static_cast<float>(width);
+            dv[vAxis] = static_cast<float>(height);
+
+            AddQuad(corner, du, dv, direction, palette[face - 1], mesh);
+            u += width;
+        }
+    }
+}
+
+void ChunkMesher::AddQuad(const glm::vec3& corner, const glm::vec3& du, const glm::vec3& dv, int direction, const glm::vec3& color, ChunkMesh& mesh)
+{
+    uint32_t first = static_cast<uint32_t>(mesh.vertices.size());
+    mesh.vertices.push_back({corner, color});
+    mesh.vertices.push_back({corner + du, color});
+    mesh.vertices.push_back({corner + du + dv, color});
+    mesh.vertices.push_back({corner + dv, color});
+
+    // du x dv points along +axis. The cube's triangles have their counter-clockwise normal pointing into the cube,
+    // so a face looking along +axis is wound the other way around.
+    if (direction > 0)
+    {
+        mesh.indices.insert(mesh.indices.end(), {first, first + 3, first + 2, first + 2, first + 1, first});
+    }
+    else
+    {
+        mesh.indices.insert(mesh.indices.end(), {first, first + 1, first + 2, first + 2, first + 3, first});
+    }
+}
+
+} // namespace tlr
\ No newline at end of file
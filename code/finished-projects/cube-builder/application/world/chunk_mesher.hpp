@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+#include "world_space.hpp"
+
+namespace tlr
+{
+
+struct MeshVertex
+{
+    glm::vec3 position; // world space
+    glm::vec3 color;
+};
+
+struct ChunkMesh
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t>   indices;
+
+    bool IsEmpty() const
+    {
+        return indices.empty();
+    }
+
+    void Clear()
+    {
+        vertices.clear();
+        indices.clear();
+    }
+};
+
+// Turns a chunk into one indexed triangle list. Faces against a placed neighbour are dropped, neighbours in other
+// chunks included, and the remaining coplanar faces of the same color are merged into rectangles greedily: a quad
+// grows along the first axis of its slice as far as it can, then along the second while whole rows still match.
+// Triangles wind like the cube of the per-block path, so culling and the front face setting stay the same.
+class ChunkMesher
+{
+public:
+    // Clears mesh first, the vectors keep their capacity between calls.
+    void Build(const WorldSpace& worldSpace, const Chunk& chunk, ChunkMesh& mesh);
+
+private:
+    static constexpr int NO_FACE = 0;
+
+    // Palette index + 1 of every exposed face in the current slice, NO_FACE where there is none.
+    std::array<int, Chunk::SIZE * Chunk::SIZE> _mask;
+
+    void BuildSlice(const WorldSpace& worldSpace, const Chunk& chunk, int axis, int direction, int slice);
+    void MergeSlice(const Chunk& chunk, int axis, int direction, int slice, ChunkMesh& mesh);
+    void AddQuad(const glm::vec3& corner, const glm::vec3& du, const glm::vec3& dv, int direction, const glm::vec3& color, ChunkMesh& mesh);
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,542 @@
+#include "chunk_streamer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace tlr
+{
+
+namespace
+{
+
+// Turning the camera only reorders the requests, a rescan for every small turn would rebuild the queue each frame.
+constexpr float RESCAN_ANGLE_COS = 0.866f;
+
+// The palette, the occupancy words, then the palette index of every placed cell in index order.
+bool WriteChunk(const std::string& path, const Chunk& chunk)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    const std::vector<glm::vec3>& palette = chunk.GetPalette();
+    uint32_t paletteSize = static_cast<uint32_t>(palette.size());
+    file.write(reinterpret_cast<const char*>(&paletteSize), sizeof(paletteSize));
+    file.write(reinterpret_cast<const char*>(palette.data()), paletteSize * sizeof(glm::vec3));
+    file.write(reinterpret_cast<const char*>(chunk.GetOccupancy().data()), Chunk::WORD_COUNT * sizeof(uint64_t));
+    chunk.ForEachPlaced([&file, &chunk](int index)
+    {
+        uint8_t paletteIndex = chunk.GetPaletteIndex(index);
+        file.write(reinterpret_cast<const char*>(&paletteIndex), sizeof(paletteIndex));
+    });
+    return file.good();
+}
+
+// nullptr if the file is missing or cut short.
+std::unique_ptr<Chunk> ReadChunk(const std::string& path, const glm::ivec3& chunkCoord)
+{
+    std::ifstream file(path, std::ios::binary);
+    uint32_t paletteSize = 0;
+    if (!file.read(reinterpret_cast<char*>(&paletteSize), sizeof(paletteSize)) || paletteSize > Chunk::MAX_PALETTE_SIZE)
+    {
+        return nullptr;
+    }
+
+    std::vector<glm::vec3> palette(paletteSize);
+    std::array<uint64_t, Chunk::WORD_COUNT> occupancy;
+    file.read(reinterpret_cast<char*>(palette.data()), paletteSize * sizeof(glm::vec3));
+    file.read(reinterpret_cast<char*>(occupancy.data()), Chunk::WORD_COUNT * sizeof(uint64_t));
+
+    auto chunk = std::make_unique<Chunk>(chunkCoord);
+    for (int word = 0; word < Chunk::WORD_COUNT && file; ++word)
+    {
+        for (int bit = 0; bit < 64; ++bit)
+        {
+            uint8_t paletteIndex = 0;
+            if (((occupancy[word] >> bit) & 1) != 0 && file.read(reinterpret_cast<char*>(&paletteIndex), sizeof(paletteIndex)) && paletteIndex < paletteSize)
+            {
+                chunk->Place(word * 64 + bit, palette[paletteIndex]);
+            }
+        }
+    }
+    return file ? std::move(chunk) : nullptr;
+}
+
+} // namespace
+
+ChunkStreamer::ChunkStreamer(const ChunkStreamerSettings& settings) : _settings(settings)
+{
+    uint32_t threadCount = _settings.threadCount;
+    if (threadCount == 0)
+    {
+        // One thread stays free for rendering.
+        threadCount = std::max(1u, ThreadPool::GetHardwareThreadCount() - 1);
+    }
+    _threadPool = std::make_unique<ThreadPool>(threadCount);
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+    // Queued jobs still get popped, but return right away.
+    _isStopping = true;
+    _threadPool.reset();
+
+    // Spill files only live as long as the world, it isn't saved.
+    _spilledChunks.ForEach([this](const glm::ivec3& chunkCoord, bool)
+    {
+        std::remove(GetSpillPath(chunkCoord).c_str());
+    });
+}
+
+void ChunkStreamer::Update(World& world, const glm::vec3& cameraPosition, const glm::vec3& cameraForward)
+{
+    TrackEdits(world);
+
+    glm::ivec3 cameraChunkCoord = Chunk::GetChunkCoord(static_cast<glm::ivec3>(glm::floor(cameraPosition)));
+    if (_isRescanNeeded || cameraChunkCoord != _scanChunkCoord || glm::dot(glm::normalize(cameraForward), _scanForward) < RESCAN_ANGLE_COS)
+    {
+        Scan(cameraPosition, cameraForward);
+    }
+
+    Unload(world);
+    Dispatch(world);
+    Load(world);
+}
+
+void ChunkStreamer::SetViewRadius(int viewRadius)
+{
+    _settings.viewRadius = std::max(viewRadius, 1);
+    _isRescanNeeded = true;
+}
+
+const ChunkStreamerSettings& ChunkStreamer::GetSettings() const
+{
+    return _settings;
+}
+
+const TerrainGenerator& ChunkStreamer::GetGenerator() const
+{
+    return _generator;
+}
+
+uint32_t ChunkStreamer::GetResidentChunkCount() const
+{
+    return _residentChunkCount;
+}
+
+size_t ChunkStreamer::GetResidentBytes() const
+{
+    return _residentBytes;
+}
+
+uint32_t ChunkStreamer::GetJobsInFlight() const
+{
+    return _jobsInFlight;
+}
+
+// Edits can create chunks the streamer never asked for and grow the ones it loaded. An edit next to a chunk that isn't
+// loaded yet makes the world allocate a chunk holding just the edit, the real one is fetched and the edit replayed
+// onto it, so building across a chunk border never wipes out the terrain behind it.
+void ChunkStreamer::TrackEdits(World& world)
+{
+    for (const BlockChange& change : world.GetJournal())
+    {
+        glm::ivec3 chunkCoord = Chunk::GetChunkCoord(change.position);
+        ChunkRecord* record = _records.Find(chunkCoord);
+        if (record == nullptr)
+        {
+            bool isEdited = _editedChunks.Find(chunkCoord) != nullptr || _spilledChunks.Find(chunkCoord) != nullptr;
+            record = &_records[chunkCoord];
+            record->lastSeenScan = _scan;
+            if (isEdited || _generator.MayContainBlocks(chunkCoord))
+            {
+                record->state = ChunkState::REQUESTED;
+                Fetch(chunkCoord, *record);
+            }
+            else
+            {
+                record->state = ChunkState::LOADED;
+            }
+        }
+        record->isEdited = true;
+
+        if (record->state == ChunkState::REQUESTED)
+        {
+            _pendingEdits[chunkCoord].push_back(change.position);
+            continue;
+        }
+
+        if (const Chunk* chunk = world.GetWorldSpace().FindChunk(chunkCoord))
+        {
+            SetBytes(chunkCoord, *record, EstimateBytes(*chunk));
+        }
+    }
+}
+
+void ChunkStreamer::Scan(const glm::vec3& cameraPosition, const glm::vec3& cameraForward)
+{
+    ++_scan;
+    _scanChunkCoord = Chunk::GetChunkCoord(static_cast<glm::ivec3>(glm::floor(cameraPosition)));
+    _scanForward = glm::normalize(cameraForward);
+    _isRescanNeeded = false;
+    _requests = std::priority_queue<Request>();
+
+    int radius = _settings.viewRadius;
+    for (int y = -_settings.verticalRadius; y <= _settings.verticalRadius; ++y)
+    {
+        for (int z = -radius; z <= radius; ++z)
+        {
+            for (int x = -radius; x <= radius; ++x)
+            {
+                if (x * x + z * z > radius * radius)
+                {
+                    continue;
+                }
+
+                glm::ivec3 chunkCoord = _scanChunkCoord + glm::ivec3(x, y, z);
+                if (ChunkRecord* record = _records.Find(chunkCoord))
+                {
+                    // Seen now, so it moves to the back and the LRU list stays in lastSeenScan order.
+                    record->lastSeenScan = _scan;
+                    if (record->bytes > 0)
+                    {
+                        _loadedLru.splice(_loadedLru.end(), _loadedLru, record->lruPosition);
+                    }
+                    continue;
+                }
+
+                // Chunks behind the camera count as up to twice as far away as the ones in front.
+                glm::vec3 toChunk = (static_cast<glm::vec3>(chunkCoord) + 0.5f) * static_cast<float>(Chunk::SIZE) - cameraPosition;
+                float distance = glm::length(toChunk);
+                float facing = distance > 0.0f ? glm::dot(toChunk / distance, _scanForward) : 1.0f;
+                _requests.push({distance * (1.5f - 0.5f * facing), chunkCoord});
+            }
+        }
+    }
+
+    _unloads.clear();
+    _records.ForEach([this](const glm::ivec3& chunkCoord, const ChunkRecord& record)
+    {
+        if (record.state == ChunkState::LOADED && !IsInViewRange(chunkCoord, _settings.unloadMargin))
+        {
+            _unloads.push_back(chunkCoord);
+        }
+    });
+}
+
+void ChunkStreamer::Unload(World& world)
+{
+    uint32_t unloadCount = 0;
+    while (!_unloads.empty() && unloadCount < _settings.maxUnloadsPerFrame)
+    {
+        glm::ivec3 chunkCoord = _unloads.back();
+        _unloads.pop_back();
+
+        // The camera may have come back since the scan.
+        ChunkRecord* record = _records.Find(chunkCoord);
+        if (record == nullptr || record->state != ChunkState::LOADED || IsInViewRange(chunkCoord, _settings.unloadMargin))
+        {
+            continue;
+        }
+
+        // Forgetting an empty coord costs nothing, it doesn't count against the budget.
+        unloadCount += record->bytes > 0 ? 1 : 0;
+        Evict(world, chunkCoord, *record);
+    }
+}
+
+void ChunkStreamer::Dispatch(World& world)
+{
+    while (!_requests.empty() && _jobsInFlight < _settings.maxJobsInFlight)
+    {
+        glm::ivec3 chunkCoord = _requests.top().chunkCoord;
+        if (_records.Find(chunkCoord) != nullptr)
+        {
+            // An edit got there since the scan.
+            _requests.pop();
+            continue;
+        }
+
+        bool isEdited = _editedChunks.Find(chunkCoord) != nullptr || _spilledChunks.Find(chunkCoord) != nullptr;
+        if (!isEdited && !_generator.MayContainBlocks(chunkCoord))
+        {
+            _requests.pop();
+            ChunkRecord& record = _records[chunkCoord];
+            record.state = ChunkState::LOADED;
+            record.lastSeenScan = _scan;
+            continue;
+        }
+
+        // The rest of the queue waits for room, nearer chunks will push it out of the view first. Jobs and ready
+        // results are disjoint, a result leaves the job count once it reaches _ready.
+        if (!MakeRoom(world, _jobsInFlight + static_cast<uint32_t>(_ready.size()), 0))
+        {
+            break;
+        }
+
+        _requests.pop();
+        ChunkRecord& record = _records[chunkCoord];
+        record.state = ChunkState::REQUESTED;
+        record.lastSeenScan = _scan;
+        Fetch(chunkCoord, record);
+    }
+}
+
+void ChunkStreamer::Load(World& world)
+{
+    {
+        std::lock_guard<std::mutex> lock(_finishedMutex);
+        for (Result& result : _finished)
+        {
+            _ready.push_back(std::move(result));
+        }
+        _jobsInFlight -= static_cast<uint32_t>(_finished.size());
+        _finished.clear();
+    }
+
+    uint32_t loadCount = 0;
+    while (!_ready.empty() && loadCount < _settings.maxLoadsPerFrame)
+    {
+        Result result = std::move(_ready.front());
+        _ready.pop_front();
+
+        glm::ivec3 chunkCoord = result.chunkCoord;
+        ChunkRecord* record = _records.Find(chunkCoord);
+        if (record == nullptr || record->state != ChunkState::REQUESTED)
+        {
+            continue;
+        }
+
+        // Back in memory, it is either loaded or parked below.
+        if (_spilledChunks.Erase(chunkCoord))
+        {
+            std::remove(GetSpillPath(chunkCoord).c_str());
+        }
+
+        // The world already holds a chunk with the edits, it is replaced whatever the budget says.
+        bool hasPendingEdits = _pendingEdits.Find(chunkCoord) != nullptr;
+        if (hasPendingEdits)
+        {
+            MergePendingEdits(world, chunkCoord, result.chunk.get());
+            if (result.chunk == nullptr)
+            {
+                const Chunk* existing = world.GetWorldSpace().FindChunk(chunkCoord);
+                record->state = ChunkState::LOADED;
+                SetBytes(chunkCoord, *record, existing != nullptr ? EstimateBytes(*existing) : 0);
+                continue;
+            }
+        }
+
+        if (result.chunk == nullptr)
+        {
+            record->state = ChunkState::LOADED;
+            continue;
+        }
+
+        if (!hasPendingEdits && (!IsInViewRange(chunkCoord, _settings.unloadMargin) || !MakeRoom(world, 0, EstimateBytes(*result.chunk))))
+        {
+            _records.Erase(chunkCoord);
+            if (result.isEdited)
+            {
+                Park(chunkCoord, std::move(result.chunk));
+            }
+            continue;
+        }
+
+        // Evicting only tombstones other records, the pointer is still good.
+        record->state = ChunkState::LOADED;
+        SetBytes(chunkCoord, *record, EstimateBytes(*result.chunk));
+        world.LoadChunk(std::move(result.chunk));
+        ++loadCount;
+    }
+}
+
+// Brings an edited chunk back from memory or disk, any other chunk is generated. The record is already REQUESTED.
+void ChunkStreamer::Fetch(const glm::ivec3& chunkCoord, ChunkRecord& record)
+{
+    if (_editedChunks.Find(chunkCoord) != nullptr)
+    {
+        record.isEdited = true;
+        _ready.push_back({chunkCoord, Unpark(chunkCoord), true});
+        return;
+    }
+
+    bool isSpilled = _spilledChunks.Find(chunkCoord) != nullptr;
+    record.isEdited |= isSpilled;
+    Submit(chunkCoord, isSpilled);
+}
+
+void ChunkStreamer::Submit(const glm::ivec3& chunkCoord, bool isSpilled)
+{
+    ++_jobsInFlight;
+    std::string spillPath = isSpilled ? GetSpillPath(chunkCoord) : std::string();
+    _threadPool->Submit([this, chunkCoord, spillPath]()
+    {
+        if (_isStopping)
+        {
+            return;
+        }
+
+        // A spill file that can't be read comes back as fresh terrain.
+        std::unique_ptr<Chunk> chunk = spillPath.empty() ? nullptr : ReadChunk(spillPath, chunkCoord);
+        bool isEdited = chunk != nullptr;
+        if (!isEdited)
+        {
+            chunk = _generator.Generate(chunkCoord);
+        }
+
+        Result result{chunkCoord, std::move(chunk), isEdited};
+        std::lock_guard<std::mutex> lock(_finishedMutex);
+        _finished.push_back(std::move(result));
+    });
+}
+
+// The chunk the edits went into holds their final state, later edits of the same cell simply win.
+void ChunkStreamer::MergePendingEdits(const World& world, const glm::ivec3& chunkCoord, Chunk* chunk)
+{
+    const Chunk* edited = world.GetWorldSpace().FindChunk(chunkCoord);
+    if (chunk != nullptr && edited != nullptr)
+    {
+        for (const glm::ivec3& position : *_pendingEdits.Find(chunkCoord))
+        {
+            int index = Chunk::GetIndex(Chunk::GetLocalPosition(position));
+            if (edited->IsPlaced(index))
+            {
+                chunk->Place(index, edited->GetColor(index));
+            }
+            else
+            {
+                chunk->Break(index);
+            }
+        }
+    }
+    _pendingEdits.Erase(chunkCoord);
+}
+
+bool ChunkStreamer::IsInViewRange(const glm::ivec3& chunkCoord, int margin) const
+{
+    glm::ivec3 offset = chunkCoord - _scanChunkCoord;
+    int radius = _settings.viewRadius + margin;
+    int verticalRadius = _settings.verticalRadius + margin;
+    return offset.x * offset.x + offset.z * offset.z <= radius * radius && std::abs(offset.y) <= verticalRadius;
+}
+
+bool ChunkStreamer::MakeRoom(World& world, uint32_t pendingChunkCount, size_t bytes)
+{
+    while (_residentChunkCount + pendingChunkCount >= _settings.maxResidentChunks || _residentBytes + bytes > _settings.maxResidentBytes)
+    {
+        // Parked chunks were seen before any loaded one, and writing them out loses nothing.
+        if (!_parkedLru.empty())
+        {
+            SpillLeastRecentlyParked();
+        }
+        else if (!EvictLeastRecentlySeen(world))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Only chunks outside the current view are candidates, evicting one the camera sees would just request it again.
+// Everything the last scan saw sits at the back of the list, so the front is either a candidate or there is none.
+bool ChunkStreamer::EvictLeastRecentlySeen(World& world)
+{
+    if (_loadedLru.empty())
+    {
+        return false;
+    }
+
+    glm::ivec3 chunkCoord = _loadedLru.front();
+    ChunkRecord& record = *_records.Find(chunkCoord);
+    if (record.lastSeenScan == _scan)
+    {
+        return false;
+    }
+
+    Evict(world, chunkCoord, record);
+    return true;
+}
+
+void ChunkStreamer::Evict(World& world, const glm::ivec3& chunkCoord, ChunkRecord& record)
+{
+    bool isEdited = record.isEdited;
+    std::unique_ptr<Chunk> chunk = world.UnloadChunk(chunkCoord);
+    SetBytes(chunkCoord, record, 0);
+    _records.Erase(chunkCoord);
+    if (isEdited && chunk != nullptr)
+    {
+        Park(chunkCoord, std::move(chunk));
+    }
+}
+
+void ChunkStreamer::SetBytes(const glm::ivec3& chunkCoord, ChunkRecord& record, size_t bytes)
+{
+    // A chunk that just got blocks counts as seen now, it joins the back of the LRU list without breaking its order.
+    if (record.bytes == 0 && bytes > 0)
+    {
+        record.lastSeenScan = _scan;
+        record.lruPosition = _loadedLru.insert(_loadedLru.end(), chunkCoord);
+    }
+    else if (record.bytes > 0 && bytes == 0)
+    {
+        _loadedLru.erase(record.lruPosition);
+    }
+
+    _residentChunkCount += bytes > 0 ? 1 : 0;
+    _residentChunkCount -= record.bytes > 0 ? 1 : 0;
+    _residentBytes += bytes;
+    _residentBytes -= record.bytes;
+    record.bytes = bytes;
+}
+
+void ChunkStreamer::Park(const glm::ivec3& chunkCoord, std::unique_ptr<Chunk> chunk)
+{
+    ParkedChunk& parked = _editedChunks[chunkCoord];
+    parked.bytes = EstimateBytes(*chunk);
+    parked.chunk = std::move(chunk);
+    parked.lruPosition = _parkedLru.insert(_parkedLru.end(), chunkCoord);
+    ++_residentChunkCount;
+    _residentBytes += parked.bytes;
+}
+
+std::unique_ptr<Chunk> ChunkStreamer::Unpark(const glm::ivec3& chunkCoord)
+{
+    ParkedChunk& parked = *_editedChunks.Find(chunkCoord);
+    std::unique_ptr<Chunk> chunk = std::move(parked.chunk);
+    _parkedLru.erase(parked.lruPosition);
+    --_residentChunkCount;
+    _residentBytes -= parked.bytes;
+    _editedChunks.Erase(chunkCoord);
+    return chunk;
+}
+
+void ChunkStreamer::SpillLeastRecentlyParked()
+{
+    glm::ivec3 chunkCoord = _parkedLru.front();
+    std::unique_ptr<Chunk> chunk = Unpark(chunkCoord);
+    if (!WriteChunk(GetSpillPath(chunkCoord), *chunk))
+    {
+        throw std::runtime_error("failed to spill an edited chunk to disk!");
+    }
+    _spilledChunks[chunkCoord] = true;
+}
+
+std::string ChunkStreamer::GetSpillPath(const glm::ivec3& chunkCoord) const
+{
+    return _settings.spillPrefix + std::to_string(chunkCoord.x) + "_" + std::to_string(chunkCoord.y) + "_" + std::to_string(chunkCoord.z) + ".bin";
+}
+
+// The chunk itself, its palette, and its blocks in the world's dense active set with their slot back-references.
+size_t ChunkStreamer::EstimateBytes(const Chunk& chunk)
+{
+    return sizeof(Chunk) + chunk.GetPalette().capacity() * sizeof(glm::vec3) + static_cast<size_t>(chunk.GetPlacedCount()) * (sizeof(ActiveBlock) + sizeof(uint32_t));
+}
+
+} // namespace tlr
\ No newline at end of file
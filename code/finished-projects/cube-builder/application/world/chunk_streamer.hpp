@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+#include "chunk_map.hpp"
+#include "terrain_generator.hpp"
+#include "thread_pool.hpp"
+#include "world.hpp"
+
+namespace tlr
+{
+
+struct ChunkStreamerSettings
+{
+    int         viewRadius = 6;             // in chunks, around the camera on the horizontal plane
+    int         verticalRadius = 2;         // in chunks, above and below the camera
+    int         unloadMargin = 2;           // chunks stay until they are this much further than the view radius
+    uint32_t    maxResidentChunks = 2048;   // non-empty chunks in memory, loaded, parked or being generated
+    size_t      maxResidentBytes = 128 << 20;
+    uint32_t    maxJobsInFlight = 32;
+    uint32_t    maxLoadsPerFrame = 2;       // loading touches every block of the chunk and remeshes its neighbours
+    uint32_t    maxUnloadsPerFrame = 4;
+    uint32_t    threadCount = 0;            // 0 picks one less than the hardware threads
+    std::string spillPrefix = "chunk_spill_"; // parked chunks over the caps go to <prefix>x_y_z.bin, removed on exit
+};
+
+// Keeps the chunks around the camera loaded. Missing chunks are generated on worker threads, nearest and most in
+// front of the camera first, and handed to the world a few per frame. Chunks that fell behind are unloaded, and when
+// a cap is hit the least recently seen chunk outside the view goes first. Update never waits for a worker.
+// Chunks the player edited are parked in memory when they are unloaded and come back instead of being generated
+// again. Parked chunks count against the caps, when one is hit they are written to disk before anything loaded goes.
+// Edits into a chunk that hasn't arrived yet are replayed onto it when it does.
+class ChunkStreamer
+{
+public:
+    explicit ChunkStreamer(const ChunkStreamerSettings& settings = {});
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    // Call once per frame on the render thread, before anything reads the world's dirty chunks.
+    void Update(World& world, const glm::vec3& cameraPosition, const glm::vec3& cameraForward);
+
+    void SetViewRadius(int viewRadius);
+    const ChunkStreamerSettings& GetSettings() const;
+    const TerrainGenerator&      GetGenerator() const;
+
+    uint32_t GetResidentChunkCount() const;
+    size_t   GetResidentBytes() const;
+    uint32_t GetJobsInFlight() const;
+
+private:
+    enum class ChunkState : uint8_t
+    {
+        REQUESTED,
+        LOADED
+    };
+
+    struct ChunkRecord
+    {
+        ChunkState                      state = ChunkState::REQUESTED;
+        uint64_t                        lastSeenScan = 0;
+        size_t                          bytes = 0;       // 0 for coords that came out empty
+        bool                            isEdited = false;
+        std::list<glm::ivec3>::iterator lruPosition;     // into _loadedLru, only while bytes > 0
+    };
+
+    struct ParkedChunk
+    {
+        std::unique_ptr<Chunk>          chunk;
+        size_t                          bytes = 0;
+        std::list<glm::ivec3>::iterator lruPosition;     // into _parkedLru
+    };
+
+    struct Request
+    {
+        float      priority; // lower goes first
+        glm::ivec3 chunkCoord;
+
+        bool operator<(const Request& other) const
+        {
+            return priority > other.priority;
+        }
+    };
+
+    struct Result
+    {
+        glm::ivec3             chunkCoord;
+        std::unique_ptr<Chunk> chunk;    // nullptr if it came out empty
+        bool                   isEdited; // parked again instead of dropped if there's no room for it
+    };
+
+    ChunkStreamerSettings _settings;
+    TerrainGenerator      _generator;
+
+    ChunkMap<ChunkRecord>             _records;
+    ChunkMap<ParkedChunk>             _editedChunks;  // unloaded chunks the player changed
+    ChunkMap<bool>                    _spilledChunks; // edited chunks written to disk, until they are loaded again
+    ChunkMap<std::vector<glm::ivec3>> _pendingEdits;  // positions edited while the chunk was still on its way
+    std::list<glm::ivec3>             _loadedLru;     // loaded non-empty chunks, least recently seen first
+    std::list<glm::ivec3>             _parkedLru;     // parked chunks, least recently parked first
+    std::priority_queue<Request>      _requests;
+    std::vector<glm::ivec3>           _unloads;
+    std::deque<Result>                _ready;         // finished, waiting for a load slot
+
+    uint64_t   _scan = 0;
+    glm::ivec3 _scanChunkCoord{0};
+    glm::vec3  _scanForward{0.0f};
+    bool       _isRescanNeeded = true;
+
+    uint32_t _residentChunkCount = 0;
+    size_t   _residentBytes = 0;
+    uint32_t _jobsInFlight = 0;
+
+    std::mutex                  _finishedMutex;
+    std::vector<Result>         _finished;      // written by the workers
+    std::atomic<bool>           _isStopping{false};
+    std::unique_ptr<ThreadPool> _threadPool;
+
+    void TrackEdits(World& world);
+    void Scan(const glm::vec3& cameraPosition, const glm::vec3& cameraForward);
+    void Unload(World& world);
+    void Dispatch(World& world);
+    void Load(World& world);
+    void Fetch(const glm::ivec3& chunkCoord, ChunkRecord& record);
+    void Submit(const glm::ivec3& chunkCoord, bool isSpilled);
+    void MergePendingEdits(const World& world, const glm::ivec3& chunkCoord, Chunk* chunk);
+
+    bool IsInViewRange(const glm::ivec3& chunkCoord, int margin) const;
+    bool MakeRoom(World& world, uint32_t pendingChunkCount, size_t bytes);
+    bool EvictLeastRecentlySeen(World& world);
+    void Evict(World& world, const glm::ivec3& chunkCoord, ChunkRecord& record);
+    void SetBytes(const glm::ivec3& chunkCoord, ChunkRecord& record, size_t bytes);
+
+    void                   Park(const glm::ivec3& chunkCoord, std::unique_ptr<Chunk> chunk);
+    std::unique_ptr<Chunk> Unpark(const glm::ivec3& chunkCoord);
+    void                   SpillLeastRecentlyParked();
+    std::string            GetSpillPath(const glm::ivec3& chunkCoord) const;
+
+    static size_t EstimateBytes(const Chunk& chunk);
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "terrain_generator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tlr
+{
+
+namespace
+{
+
+uint32_t Hash(int x, int z, uint32_t seed)
+{
+    uint32_t h = seed ^ (static_cast<uint32_t>(x) * 0x9E3779B1u) ^ (static_cast<uint32_t>(z) * 0x85EBCA77u);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return h;
+}
+
+// A handful of shades per material keeps the chunk palettes tiny, chunks never run out of entries.
+constexpr int SHADE_COUNT = 4;
+
+const glm::vec3 GRASS_COLOR{0.36f, 0.62f, 0.25f};
+const glm::vec3 DIRT_COLOR{0.47f, 0.33f, 0.2f};
+const glm::vec3 STONE_COLOR{0.5f, 0.5f, 0.52f};
+
+} // namespace
+
+TerrainGenerator::TerrainGenerator(uint32_t seed) : _seed(seed)
+{
+}
+
+int TerrainGenerator::GetSurfaceHeight(int x, int z) const
+{
+    float hills = GetValueNoise(x / 48.0f, z / 48.0f, _seed);
+    float bumps = GetValueNoise(x / 12.0f, z / 12.0f, _seed + 1);
+    float height = MIN_SURFACE_HEIGHT + (MAX_SURFACE_HEIGHT - MIN_SURFACE_HEIGHT) * (0.8f * hills + 0.2f * bumps);
+    return std::clamp(static_cast<int>(std::lround(height)), MIN_SURFACE_HEIGHT, MAX_SURFACE_HEIGHT);
+}
+
+bool TerrainGenerator::MayContainBlocks(const glm::ivec3& chunkCoord) const
+{
+    int bottom = chunkCoord.y * Chunk::SIZE;
+    int top = bottom + Chunk::MASK;
+    return top >= FLOOR_HEIGHT && bottom <= MAX_SURFACE_HEIGHT;
+}
+
+std::unique_ptr<Chunk> TerrainGenerator::Generate(const glm::ivec3& chunkCoord) const
+{
+    if (!MayContainBlocks(chunkCoord))
+    {
+        return nullptr;
+    }
+
+    auto chunk = std::make_unique<Chunk>(chunkCoord);
+    glm::ivec3 origin = chunk->GetOrigin();
+    for (int z = 0; z < Chunk::SIZE; ++z)
+    {
+        for (int x = 0; x < Chunk::SIZE; ++x)
+        {
+            int surfaceHeight = GetSurfaceHeight(origin.x + x, origin.z + z);
+            int first = std::max(FLOOR_HEIGHT - origin.y, 0);
+            int last = std::min(surfaceHeight - origin.y, Chunk::MASK);
+            for (int y = first; y <= last; ++y)
+            {
+                glm::ivec3 localPosition(x, y, z);
+                chunk->Place(Chunk::GetIndex(localPosition), GetColor(origin + localPosition, surfaceHeight));
+            }
+        }
+    }
+
+    if (chunk->IsEmpty())
+    {
+        return nullptr;
+    }
+    return chunk;
+}
+
+float TerrainGenerator::GetValueNoise(float x, float z, uint32_t seed) const
+{
+    float cellX = std::floor(x);
+    float cellZ = std::floor(z);
+    int x0 = static_cast<int>(cellX);
+    int z0 = static_cast<int>(cellZ);
+
+    // Smoothstep weights hide the lattice lines.
+    float tx = x - cellX;
+    float tz = z - cellZ;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+
+    float bottom = GetLatticeValue(x0, z0, seed) + (GetLatticeValue(x0 + 1, z0, seed) - GetLatticeValue(x0, z0, seed)) * tx;
+    float top = GetLatticeValue(x0, z0 + 1, seed) + (GetLatticeValue(x0 + 1, z0 + 1, seed) - GetLatticeValue(x0, z0 + 1, seed)) * tx;
+    return bottom + (top - bottom) * tz;
+}
+
+float TerrainGenerator::GetLatticeValue(int x, int z, uint32_t seed) const
+{
+    return static_cast<float>(Hash(x, z, seed) & 0xFFFF) / 65535.0f;
+}
+
+glm::vec3 TerrainGenerator::GetColor(const glm::ivec3& position, int surfaceHeight) const
+{
+    glm::vec3 color = STONE_COLOR;
+    if (position.y == surfaceHeight)
+    {
+        color = GRASS_COLOR;
+    }
+    else if (position.y > surfaceHeight - DIRT_DEPTH)
+    {
+        color = DIRT_COLOR;
+    }
+
+    int shade = static_cast<int>(Hash(position.x, position.z, _seed ^ static_cast<uint32_t>(position.y)) % SHADE_COUNT);
+    return color * (0.88f + 0.04f * shade);
+}
+
+} // namespace tlr
\ No newline at end of file
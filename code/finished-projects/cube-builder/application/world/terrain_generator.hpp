@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+
+namespace tlr
+{
+
+// Heightmap terrain that goes on forever. Every column is solid from FLOOR_HEIGHT up to its surface, the surface
+// height comes from two octaves of value noise. Generation only reads the seed, so any thread may call it, and the
+// same chunk always comes out the same.
+class TerrainGenerator
+{
+public:
+    static constexpr int FLOOR_HEIGHT = -24;
+    static constexpr int MIN_SURFACE_HEIGHT = -16;
+    static constexpr int MAX_SURFACE_HEIGHT = -2;
+    static constexpr int DIRT_DEPTH = 3;
+
+    explicit TerrainGenerator(uint32_t seed = 1);
+
+    // y of the topmost block of the column.
+    int  GetSurfaceHeight(int x, int z) const;
+    // False for chunks entirely above the surface or below the floor, they don't need generating.
+    bool MayContainBlocks(const glm::ivec3& chunkCoord) const;
+    // nullptr if the chunk comes out empty.
+    std::unique_ptr<Chunk> Generate(const glm::ivec3& chunkCoord) const;
+
+private:
+    uint32_t _seed;
+
+    float     GetValueNoise(float x, float z, uint32_t seed) const;
+    float     GetLatticeValue(int x, int z, uint32_t seed) const;
+    glm::vec3 GetColor(const glm::ivec3& position, int surfaceHeight) const;
+};
+
+} // namespace tlr
\ No newline at end of file
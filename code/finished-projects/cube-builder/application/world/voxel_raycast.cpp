@@ -0,0 +1,255 @@
+#include "voxel_raycast.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TLR_RAYCAST_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace tlr
+{
+
+namespace
+{
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+struct RayStart
+{
+    glm::ivec3 cell{0};
+    glm::ivec3 step{0};
+    glm::vec3  tMax{0.0f};   // distance to the next cell boundary on each axis
+    glm::vec3  tDelta{0.0f}; // distance between two boundaries on each axis
+    bool       isValid = false;
+};
+
+RayStart BeginRay(const glm::vec3& origin, const glm::vec3& direction)
+{
+    RayStart start;
+    float length = glm::length(direction);
+    if (!(length > 0.0f))
+    {
+        return start;
+    }
+
+    glm::vec3 unit = direction / length;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float position = std::floor(origin[axis]);
+        start.cell[axis] = static_cast<int>(position);
+        if (unit[axis] > 0.0f)
+        {
+            start.step[axis] = 1;
+            start.tDelta[axis] = 1.0f / unit[axis];
+            start.tMax[axis] = (position + 1.0f - origin[axis]) * start.tDelta[axis];
+        }
+        else if (unit[axis] < 0.0f)
+        {
+            start.step[axis] = -1;
+            start.tDelta[axis] = -1.0f / unit[axis];
+            start.tMax[axis] = (origin[axis] - position) * start.tDelta[axis];
+        }
+        else
+        {
+            start.tDelta[axis] = INF;
+            start.tMax[axis] = INF;
+        }
+    }
+    start.isValid = true;
+    return start;
+}
+
+// Consecutive cells of a ray mostly share a chunk, only crossing into the next one costs a map probe.
+class ChunkCursor
+{
+public:
+    explicit ChunkCursor(const WorldSpace& worldSpace) : _worldSpace(worldSpace)
+    {
+    }
+
+    bool IsPlaced(const glm::ivec3& cell)
+    {
+        glm::ivec3 chunkCoord = Chunk::GetChunkCoord(cell);
+        if (!_hasLookup || chunkCoord != _chunkCoord)
+        {
+            _chunk = _worldSpace.FindChunk(chunkCoord);
+            _chunkCoord = chunkCoord;
+            _hasLookup = true;
+        }
+        return _chunk != nullptr && _chunk->IsPlaced(Chunk::GetIndex(Chunk::GetLocalPosition(cell)));
+    }
+
+private:
+    const WorldSpace& _worldSpace;
+    const Chunk*      _chunk = nullptr;
+    glm::ivec3        _chunkCoord{0};
+    bool              _hasLookup = false;
+};
+
+#ifdef TLR_RAYCAST_SSE2
+
+constexpr int LANE_COUNT = 4;
+
+void RaycastPacket(const WorldSpace& worldSpace, const Ray* rays, size_t count, float maxDistance, std::optional<RayHit>* hits)
+{
+    alignas(16) int   cell[3][LANE_COUNT] = {};
+    alignas(16) int   step[3][LANE_COUNT] = {};
+    alignas(16) float tMax[3][LANE_COUNT] = {};
+    alignas(16) float tDelta[3][LANE_COUNT] = {};
+
+    // Lanes past count or with a zero direction start out finished, their state stays zero and stepping them is a no-op.
+    int activeLanes = 0;
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        hits[lane].reset();
+        RayStart start = BeginRay(rays[lane].origin, rays[lane].direction);
+        if (!start.isValid)
+        {
+            continue;
+        }
+        activeLanes |= 1 << lane;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            cell[axis][lane] = start.cell[axis];
+            step[axis][lane] = start.step[axis];
+            tMax[axis][lane] = start.tMax[axis];
+            tDelta[axis][lane] = start.tDelta[axis];
+        }
+    }
+
+    __m128i cellX = _mm_load_si128(reinterpret_cast<const __m128i*>(cell[0]));
+    __m128i cellY = _mm_load_si128(reinterpret_cast<const __m128i*>(cell[1]));
+    __m128i cellZ = _mm_load_si128(reinterpret_cast<const __m128i*>(cell[2]));
+    __m128i stepX = _mm_load_si128(reinterpret_cast<const __m128i*>(step[0]));
+    __m128i stepY = _mm_load_si128(reinterpret_cast<const __m128i*>(step[1]));
+    __m128i stepZ = _mm_load_si128(reinterpret_cast<const __m128i*>(step[2]));
+    __m128  tMaxX = _mm_load_ps(tMax[0]);
+    __m128  tMaxY = _mm_load_ps(tMax[1]);
+    __m128  tMaxZ = _mm_load_ps(tMax[2]);
+    __m128  tDeltaX = _mm_load_ps(tDelta[0]);
+    __m128  tDeltaY = _mm_load_ps(tDelta[1]);
+    __m128  tDeltaZ = _mm_load_ps(tDelta[2]);
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i normalStepX = _mm_sub_epi32(zero, stepX);
+    __m128i normalStepY = _mm_sub_epi32(zero, stepY);
+    __m128i normalStepZ = _mm_sub_epi32(zero, stepZ);
+    __m128i normalX = zero;
+    __m128i normalY = zero;
+    __m128i normalZ = zero;
+    __m128  distance = _mm_setzero_ps();
+    __m128  maxDistances = _mm_set1_ps(maxDistance);
+
+    ChunkCursor cursors[LANE_COUNT] = {ChunkCursor(worldSpace), ChunkCursor(worldSpace), ChunkCursor(worldSpace), ChunkCursor(worldSpace)};
+    alignas(16) int   normal[3][LANE_COUNT];
+    alignas(16) float distances[LANE_COUNT];
+
+    while (activeLanes != 0)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i*>(cell[0]), cellX);
+        _mm_store_si128(reinterpret_cast<__m128i*>(cell[1]), cellY);
+        _mm_store_si128(reinterpret_cast<__m128i*>(cell[2]), cellZ);
+
+        bool isNormalStored = false;
+        for (int lane = 0; lane < LANE_COUNT; ++lane)
+        {
+            glm::ivec3 laneCell(cell[0][lane], cell[1][lane], cell[2][lane]);
+            if ((activeLanes & (1 << lane)) == 0 || !cursors[lane].IsPlaced(laneCell))
+            {
+                continue;
+            }
+            if (!isNormalStored)
+            {
+                _mm_store_si128(reinterpret_cast<__m128i*>(normal[0]), normalX);
+                _mm_store_si128(reinterpret_cast<__m128i*>(normal[1]), normalY);
+                _mm_store_si128(reinterpret_cast<__m128i*>(normal[2]), normalZ);
+                _mm_store_ps(distances, distance);
+                isNormalStored = true;
+            }
+            hits[lane] = RayHit{laneCell, glm::ivec3(normal[0][lane], normal[1][lane], normal[2][lane]), distances[lane]};
+            activeLanes &= ~(1 << lane);
+        }
+
+        // Same tie breaking as the scalar walk: x only if strictly closest, then y before z.
+        __m128 isX = _mm_and_ps(_mm_cmplt_ps(tMaxX, tMaxY), _mm_cmplt_ps(tMaxX, tMaxZ));
+        __m128 isY = _mm_andnot_ps(isX, _mm_cmplt_ps(tMaxY, tMaxZ));
+        __m128 isZ = _mm_andnot_ps(_mm_or_ps(isX, isY), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+
+        distance = _mm_min_ps(tMaxX, _mm_min_ps(tMaxY, tMaxZ));
+        activeLanes &= ~_mm_movemask_ps(_mm_cmpgt_ps(distance, maxDistances));
+
+        __m128i isXi = _mm_castps_si128(isX);
+        __m128i isYi = _mm_castps_si128(isY);
+        __m128i isZi = _mm_castps_si128(isZ);
+        cellX = _mm_add_epi32(cellX, _mm_and_si128(stepX, isXi));
+        cellY = _mm_add_epi32(cellY, _mm_and_si128(stepY, isYi));
+        cellZ = _mm_add_epi32(cellZ, _mm_and_si128(stepZ, isZi));
+        tMaxX = _mm_add_ps(tMaxX, _mm_and_ps(tDeltaX, isX));
+        tMaxY = _mm_add_ps(tMaxY, _mm_and_ps(tDeltaY, isY));
+        tMaxZ = _mm_add_ps(tMaxZ, _mm_and_ps(tDeltaZ, isZ));
+        normalX = _mm_and_si128(normalStepX, isXi);
+        normalY = _mm_and_si128(normalStepY, isYi);
+        normalZ = _mm_and_si128(normalStepZ, isZi);
+    }
+}
+
+#endif
+
+} // namespace
+
+std::optional<RayHit> Raycast(const WorldSpace& worldSpace, const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+    RayStart ray = BeginRay(origin, direction);
+    if (!ray.isValid)
+    {
+        return std::nullopt;
+    }
+
+    ChunkCursor cursor(worldSpace);
+    glm::ivec3 normal(0);
+    float distance = 0.0f;
+    while (distance <= maxDistance)
+    {
+        if (cursor.IsPlaced(ray.cell))
+        {
+            return RayHit{ray.cell, normal, distance};
+        }
+
+        int axis = 2;
+        if (ray.tMax.x < ray.tMax.y && ray.tMax.x < ray.tMax.z)
+        {
+            axis = 0;
+        }
+        else if (ray.tMax.y < ray.tMax.z)
+        {
+            axis = 1;
+        }
+
+        distance = ray.tMax[axis];
+        ray.tMax[axis] += ray.tDelta[axis];
+        ray.cell[axis] += ray.step[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -ray.step[axis];
+    }
+    return std::nullopt;
+}
+
+void RaycastBatch(const WorldSpace& worldSpace, const Ray* rays, size_t count, float maxDistance, std::optional<RayHit>* hits)
+{
+#ifdef TLR_RAYCAST_SSE2
+    for (size_t first = 0; first < count; first += LANE_COUNT)
+    {
+        size_t packetSize = count - first < LANE_COUNT ? count - first : LANE_COUNT;
+        RaycastPacket(worldSpace, rays + first, packetSize, maxDistance, hits + first);
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        hits[i] = Raycast(worldSpace, rays[i].origin, rays[i].direction, maxDistance);
+    }
+#endif
+}
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+#include <glm/glm.hpp>
+
+#include "world_space.hpp"
+
+namespace tlr
+{
+
+struct Ray
+{
+    glm::vec3 origin;
+    glm::vec3 direction; // doesn't have to be normalized
+};
+
+struct RayHit
+{
+    glm::ivec3 cell;     // the placed block the ray stopped in
+    glm::ivec3 normal;   // face the ray entered through, zero if it started inside the block
+    float      distance; // along the ray to the entry point
+};
+
+// Walks the cells along the ray in order (Amanatides & Woo) and stops at the first placed one. Nothing is allocated,
+// the chunk the ray is in is looked up once and reused until the ray leaves it.
+std::optional<RayHit> Raycast(const WorldSpace& worldSpace, const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+
+// Same as calling Raycast for every ray, hits[i] belongs to rays[i]. Rays are traversed four at a time, the stepping
+// runs in SSE lanes and only the occupancy lookups are per ray. Meant for many short rays per tick, e.g. AI builders.
+void RaycastBatch(const WorldSpace& worldSpace, const Ray* rays, size_t count, float maxDistance, std::optional<RayHit>* hits);
+
+} // namespace tlr
\ No newline at end of file
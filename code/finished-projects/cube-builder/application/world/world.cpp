@@ -1,214 +1,270 @@
 #include "world.hpp"
 
 #include <algorithm>
+#include <functional>
+
+#include "voxel_raycast.hpp"
 
 namespace tlr
 {
 
-static const std::vector<glm::vec3> DIRECTIONS =
+const std::vector<ActiveBlock>& World::GetActiveBlocks() const
+{
+    return _activeBlocks;
+}
+
+const WorldSpace& World::GetWorldSpace() const
+{
+    return _worldSpace;
+}
+
+const std::vector<BlockChange>& World::GetJournal() const
 {
-    {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {-1, 0, 0}, {0, -1, 0}, {0, 0, -1}
-};
+    return _journal;
+}
 
-World::World()
+const std::vector<uint32_t>& World::GetDirtySlots() const
 {
-    Initialize();
+    return _dirtySlots;
 }
 
-void World::Initialize()
+const std::vector<glm::ivec3>& World::GetDirtyChunks() const
 {
-    for (int x = -WorldSpace::X_DIMENSION; x < WorldSpace::X_DIMENSION; ++x)
+    return _dirtyChunks;
+}
+
+void World::ClearChanges()
+{
+    for (const glm::ivec3& chunkCoord : _dirtyChunks)
     {
-        for (int y = -WorldSpace::Y_DIMENSION; y < WorldSpace::Y_DIMENSION; ++y)
+        if (Chunk* chunk = _worldSpace.FindChunk(chunkCoord))
         {
-            for (int z = -WorldSpace::Z_DIMENSION; z < WorldSpace::Z_DIMENSION; ++z)
-            {
-                glm::ivec3 position{x, y, z};
-                _worldSpace[position].Initialize(position);
-            }
+            chunk->SetDirty(false);
         }
     }
-    _worldSpace[{0, 0, 0}].Place();
+    _journal.clear();
+    _dirtySlots.clear();
+    _dirtyChunks.clear();
 }
 
-std::vector<Block> World::GetActiveBlocks() const
+void World::LoadChunk(std::unique_ptr<Chunk> chunk)
 {
-    std::vector<Block> blocks;
-
-    for (int x = -WorldSpace::X_DIMENSION; x < WorldSpace::X_DIMENSION; ++x)
+    glm::ivec3 chunkCoord = chunk->GetCoord();
+    // A replaced chunk that was queued already keeps its entry in the dirty list, the new one takes it over.
+    std::unique_ptr<Chunk> replaced = DetachChunk(chunkCoord);
+    bool isQueued = replaced != nullptr && replaced->IsDirty();
+
+    Chunk& loaded = _worldSpace.InsertChunk(std::move(chunk));
+    loaded.SetDirty(isQueued);
+
+    // Cells come in index order, every slot goes to the back of the chunk's list.
+    std::vector<uint32_t>& slots = _chunkSlots[chunkCoord];
+    slots.reserve(loaded.GetPlacedCount());
+    loaded.ForEachPlaced([this, &loaded, &slots](int index)
+    {
+        uint32_t slot = static_cast<uint32_t>(_activeBlocks.size());
+        slots.push_back(slot);
+        _dirtySlots.push_back(slot);
+        _activeBlocks.push_back({loaded.GetPosition(index), ActiveBlock::PackColor(loaded.GetColor(index))});
+    });
+
+    // The neighbours' faces towards the new chunk are covered now.
+    MarkChunkDirty(chunkCoord);
+    for (int axis = 0; axis < 3; ++axis)
     {
-        for (int y = -WorldSpace::Y_DIMENSION; y < WorldSpace::Y_DIMENSION; ++y)
+        for (int direction = -1; direction <= 1; direction += 2)
         {
-            for (int z = -WorldSpace::Z_DIMENSION; z < WorldSpace::Z_DIMENSION; ++z)
-            {
-                Block block = _worldSpace[{x, y, z}];
-                if (block.IsPlaced())
-                {
-                    blocks.push_back(block);
-                }
-            }
+            glm::ivec3 neighbour = chunkCoord;
+            neighbour[axis] += direction;
+            MarkChunkDirty(neighbour);
         }
     }
-
-    return blocks;
 }
 
-void World::BuildBlock(const glm::vec3& playerPosition, const glm::vec3& ray)
+std::unique_ptr<Chunk> World::UnloadChunk(const glm::ivec3& chunkCoord)
 {
-    glm::vec3 rayEnd = playerPosition + glm::normalize(ray) * PLAYER_REACH_LENGTH;
-    glm::ivec3 targetBlockPosition = GetTargetBlockPosition(playerPosition, rayEnd);
-    
-    bool isTargetBlockNotFound = !_worldSpace.IsPositionInBounds(targetBlockPosition);
-    if (isTargetBlockNotFound)
+    // Consumers find the coord dirty but the chunk gone, e.g. the renderer drops its mesh. The neighbours keep their
+    // faces towards it as they are, seen from the loaded side those face away from the camera anyway.
+    MarkChunkDirty(chunkCoord);
+    std::unique_ptr<Chunk> unloaded = DetachChunk(chunkCoord);
+    if (unloaded != nullptr)
     {
-        return;
+        unloaded->SetDirty(false);
     }
-    
-    Block targetBlock = _worldSpace[targetBlockPosition];
+    return unloaded;
+}
 
-    for (const auto& dir : DIRECTIONS)
+std::unique_ptr<Chunk> World::DetachChunk(const glm::ivec3& chunkCoord)
+{
+    if (_worldSpace.FindChunk(chunkCoord) == nullptr)
     {
-        glm::vec3 center = targetBlock.GetCenter();
-        
-        bool isFaceNotTowardsUs = glm::dot(dir, ray) > 0;
-        bool isWrongNeighbor = _worldSpace[static_cast<glm::ivec3>(static_cast<glm::vec3>(targetBlock.GetPosition()) + dir)].IsPlaced();
-        if (isWrongNeighbor || isFaceNotTowardsUs)
-        {
-            continue;
-        }
-        
-        center += (dir / 2.0f);
-        glm::vec3 offsetVector = (Block::CORNER_OFFSET - glm::abs(dir)) / 2.0f;
-        glm::vec3 minFacePosition = center - offsetVector;
-        glm::vec3 maxFacePosition = center + offsetVector;
+        return nullptr;
+    }
 
-        if (DoesRayIntersectCube(playerPosition, ray, minFacePosition, maxFacePosition))
+    // Highest slot first, whatever moves into a freed slot then belongs to another chunk.
+    if (std::vector<uint32_t>* slots = _chunkSlots.Find(chunkCoord))
+    {
+        std::sort(slots->begin(), slots->end(), std::greater<uint32_t>());
+        for (uint32_t slot : *slots)
         {
-            _worldSpace[Block::GetPositionFromCenter(center + dir)].Place();
-            break;
+            RemoveActiveSlot(slot);
         }
+        _chunkSlots.Erase(chunkCoord);
     }
+    return _worldSpace.ReleaseChunk(chunkCoord);
 }
 
-bool World::DoesRayIntersectCube(const glm::vec3& rayStart, const glm::vec3& rayDirection, const glm::vec3& cubeMin, const glm::vec3& cubeMax)
+void World::SetBlock(const glm::ivec3& position, bool isPlaced)
 {
-    glm::vec3 tMin = (cubeMin - rayStart) / rayDirection;
-    glm::vec3 tMax = (cubeMax - rayStart) / rayDirection;
-
-    glm::vec3 t1 = glm::min(tMin, tMax);
-    glm::vec3 t2 = glm::max(tMin, tMax);
+    if (isPlaced)
+    {
+        PlaceBlock(position, Block::GetRandomColor());
+        return;
+    }
 
-    float tEnter = std::max(std::max(t1.x, t1.y), t1.z);
-    float tExit = std::min(std::min(t2.x, t2.y), t2.z);
+    int index = Chunk::GetIndex(Chunk::GetLocalPosition(position));
+    Chunk* chunk = _worldSpace.FindChunk(Chunk::GetChunkCoord(position));
+    if (chunk == nullptr || !chunk->IsPlaced(index))
+    {
+        return;
+    }
+    chunk->Break(index);
+    RemoveActiveBlock(*chunk, index);
 
-    return tEnter <= tExit && tExit >= 0;
+    _journal.push_back({position, false});
+    MarkChunksDirty(position);
 }
 
-void World::BreakBlock(const glm::vec3& playerPosition, const glm::vec3& ray)
+void World::PlaceBlock(const glm::ivec3& position, const glm::vec3& color)
 {
-    glm::vec3 rayEnd = playerPosition + glm::normalize(ray) * PLAYER_REACH_LENGTH;
-    glm::ivec3 targetBlockPosition = GetTargetBlockPosition(playerPosition, rayEnd);
+    int index = Chunk::GetIndex(Chunk::GetLocalPosition(position));
+    Chunk& chunk = _worldSpace.GetOrCreateChunk(Chunk::GetChunkCoord(position));
+    bool wasPlaced = chunk.IsPlaced(index);
+    chunk.Place(index, color);
+    AddActiveBlock(chunk, index, wasPlaced);
+
+    _journal.push_back({position, true});
+    MarkChunksDirty(position);
+}
 
-    bool isTargetBlockNotFound = !_worldSpace.IsPositionInBounds(targetBlockPosition);
-    if (isTargetBlockNotFound || targetBlockPosition == glm::ivec3(0, 0, 0))
+void World::AddActiveBlock(const Chunk& chunk, int index, bool wasPlaced)
+{
+    ActiveBlock block{chunk.GetPosition(index), ActiveBlock::PackColor(chunk.GetColor(index))};
+    std::vector<uint32_t>& slots = _chunkSlots[chunk.GetCoord()];
+    int rank = chunk.GetPlacedCountBefore(index);
+    if (wasPlaced)
     {
+        _activeBlocks[slots[rank]] = block;
+        _dirtySlots.push_back(slots[rank]);
         return;
     }
 
-    _worldSpace[targetBlockPosition].Break();
+    uint32_t slot = static_cast<uint32_t>(_activeBlocks.size());
+    slots.insert(slots.begin() + rank, slot);
+    _dirtySlots.push_back(slot);
+    _activeBlocks.push_back(block);
 }
 
-glm::ivec3 World::GetTargetBlockPosition(const glm::vec3& rayStart, const glm::vec3& rayEnd)
+void World::RemoveActiveBlock(const Chunk& chunk, int index)
 {
-    std::vector<glm::ivec3> blockPositions = GetIntersectedBlockPositions(rayStart, rayEnd);
+    std::vector<uint32_t>& slots = *_chunkSlots.Find(chunk.GetCoord());
+    int rank = chunk.GetPlacedCountBefore(index);
+    uint32_t slot = slots[rank];
+    slots.erase(slots.begin() + rank);
+    RemoveActiveSlot(slot);
+}
 
-    bool isTargetBlockFound = false;    
-    glm::ivec3 targetBlockPosition = blockPositions[1];
-    for (std::size_t i = 1; i < blockPositions.size(); ++i)
+void World::RemoveActiveSlot(uint32_t slot)
+{
+    // The last block moves into the freed slot, removal stays O(1) and the set stays dense.
+    _activeBlocks[slot] = _activeBlocks.back();
+    _activeBlocks.pop_back();
+    if (slot == _activeBlocks.size())
     {
-        assert(_worldSpace.IsPositionInBounds(blockPositions[i]) && "you went out of the world!");
+        return;
+    }
+
+    glm::ivec3 position = _activeBlocks[slot].position;
+    const Chunk& chunk = *_worldSpace.FindChunk(Chunk::GetChunkCoord(position));
+    (*_chunkSlots.Find(chunk.GetCoord()))[chunk.GetPlacedCountBefore(Chunk::GetIndex(Chunk::GetLocalPosition(position)))] = slot;
+    _dirtySlots.push_back(slot);
+}
+
+void World::MarkChunksDirty(const glm::ivec3& position)
+{
+    glm::ivec3 chunkCoord = Chunk::GetChunkCoord(position);
+    glm::ivec3 localPosition = Chunk::GetLocalPosition(position);
+    MarkChunkDirty(chunkCoord);
 
-        if (_worldSpace[blockPositions[i]].IsPlaced())
+    // A cell on the border also hides or exposes a face of the chunk next to it.
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        glm::ivec3 neighbour = chunkCoord;
+        if (localPosition[axis] == 0)
         {
-            isTargetBlockFound = true;
-            targetBlockPosition = blockPositions[i];
-            break;
-        }   
+            neighbour[axis] -= 1;
+            MarkChunkDirty(neighbour);
+        }
+        else if (localPosition[axis] == Chunk::MASK)
+        {
+            neighbour[axis] += 1;
+            MarkChunkDirty(neighbour);
+        }
     }
+}
 
-    if (!isTargetBlockFound)
+void World::MarkChunkDirty(const glm::ivec3& chunkCoord)
+{
+    Chunk* chunk = _worldSpace.FindChunk(chunkCoord);
+    if (chunk != nullptr && !chunk->IsDirty())
     {
-        return WorldSpace::NULL_POSITION;
+        chunk->SetDirty(true);
+        _dirtyChunks.push_back(chunkCoord);
     }
-
-    return targetBlockPosition;
 }
 
-std::vector<glm::ivec3> World::GetIntersectedBlockPositions(const glm::vec3& rayStart, const glm::vec3& rayEnd)
+std::optional<glm::ivec3> World::BuildBlock(const glm::vec3& playerPosition, const glm::vec3& ray)
 {
-    /*
-     * Check out https://github.com/francisengelmann/fast_voxel_traversal
-     */
-    std::vector<glm::ivec3> visitedVoxels;
-
-    glm::ivec3 currentVoxel(static_cast<int>(std::floor(rayStart.x)),
-                            static_cast<int>(std::floor(rayStart.y)),
-                            static_cast<int>(std::floor(rayStart.z)));
-
-    glm::ivec3 lastVoxel(static_cast<int>(std::floor(rayEnd.x)),
-                         static_cast<int>(std::floor(rayEnd.y)),
-                         static_cast<int>(std::floor(rayEnd.z)));
+    std::optional<RayHit> hit = Raycast(_worldSpace, playerPosition, ray, PLAYER_REACH_LENGTH);
 
-    glm::vec3 ray = rayEnd - rayStart;
-
-    int stepX = (ray.x >= 0) ? 1 : -1;
-    int stepY = (ray.y >= 0) ? 1 : -1;
-    int stepZ = (ray.z >= 0) ? 1 : -1;
-
-    double nextVoxelBoundaryX = currentVoxel.x + (stepX > 0 ? 1 : 0);
-    double nextVoxelBoundaryY = currentVoxel.y + (stepY > 0 ? 1 : 0);
-    double nextVoxelBoundaryZ = currentVoxel.z + (stepZ > 0 ? 1 : 0);
-
-    double tMaxX = (ray.x != 0) ? (nextVoxelBoundaryX - rayStart.x) / ray.x : DBL_MAX;
-    double tMaxY = (ray.y != 0) ? (nextVoxelBoundaryY - rayStart.y) / ray.y : DBL_MAX;
-    double tMaxZ = (ray.z != 0) ? (nextVoxelBoundaryZ - rayStart.z) / ray.z : DBL_MAX;
+    // Standing inside a block there's no face to build on.
+    if (!hit || hit->normal == glm::ivec3(0))
+    {
+        return std::nullopt;
+    }
 
-    double tDeltaX = (ray.x != 0) ? 1.0 / std::abs(ray.x) : DBL_MAX;
-    double tDeltaY = (ray.y != 0) ? 1.0 / std::abs(ray.y) : DBL_MAX;
-    double tDeltaZ = (ray.z != 0) ? 1.0 / std::abs(ray.z) : DBL_MAX;
+    glm::ivec3 position = hit->cell + hit->normal;
+    SetBlock(position, true);
+    return position;
+}
 
-    while (currentVoxel != lastVoxel)
+void World::Fill(const glm::ivec3& min, const glm::ivec3& max, const glm::vec3& color)
+{
+    for (int x = min.x; x < max.x; ++x)
     {
-        if (tMaxX < tMaxY)
-        {
-            if (tMaxX < tMaxZ)
-            {
-                currentVoxel.x += stepX;
-                tMaxX += tDeltaX;
-            }
-            else
-            {
-                currentVoxel.z += stepZ;
-                tMaxZ += tDeltaZ;
-            }
-        }
-        else
+        for (int y = min.y; y < max.y; ++y)
         {
-            if (tMaxY < tMaxZ)
+            for (int z = min.z; z < max.z; ++z)
             {
-                currentVoxel.y += stepY;
-                tMaxY += tDeltaY;
-            }
-            else
-            {
-                currentVoxel.z += stepZ;
-                tMaxZ += tDeltaZ;
+                if (!_worldSpace.IsPlaced({x, y, z}))
+                {
+                    PlaceBlock({x, y, z}, color);
+                }
             }
         }
-        visitedVoxels.push_back(currentVoxel);
+    }
+}
+
+std::optional<glm::ivec3> World::BreakBlock(const glm::vec3& playerPosition, const glm::vec3& ray)
+{
+    std::optional<RayHit> hit = Raycast(_worldSpace, playerPosition, ray, PLAYER_REACH_LENGTH);
+    if (!hit)
+    {
+        return std::nullopt;
     }
 
-    return visitedVoxels;
+    SetBlock(hit->cell, false);
+    return hit->cell;
 }
 
 } // namespace tlr
\ No newline at end of file
@@ -1,33 +1,93 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "world_space.hpp"
+#include "chunk_map.hpp"
 
 namespace tlr
 {
 
+struct BlockChange
+{
+    glm::ivec3 position;
+    bool       isPlaced;
+};
+
+// An entry of the active set, 16 bytes laid out like the instanced pipeline's per-instance input.
+struct ActiveBlock
+{
+    glm::ivec3 position;
+    uint32_t   color; // RGBA8
+
+    static uint32_t PackColor(const glm::vec3& color)
+    {
+        glm::vec3 scaled = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+        return static_cast<uint32_t>(scaled.x) | static_cast<uint32_t>(scaled.y) << 8 | static_cast<uint32_t>(scaled.z) << 16 | 0xFF000000u;
+    }
+
+    glm::vec3 GetColor() const
+    {
+        return glm::vec3(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF) / 255.0f;
+    }
+};
+
 class World
 {
 public:
     static constexpr float PLAYER_REACH_LENGTH = 5;
 
-    World();
+    World() = default;
+
+    // Every placed block exactly once, in no particular order. Kept up to date by the edits, reading it is free.
+    const std::vector<ActiveBlock>& GetActiveBlocks() const;
+    const WorldSpace&               GetWorldSpace() const;
+
+    // What changed since the last ClearChanges. Dirty slots index GetActiveBlocks, they may be past its end when
+    // the set shrank afterwards. Dirty chunks include neighbours whose faces an edit on the border touched.
+    const std::vector<BlockChange>& GetJournal() const;
+    const std::vector<uint32_t>&    GetDirtySlots() const;
+    const std::vector<glm::ivec3>&  GetDirtyChunks() const;
+    // Call once every consumer has seen the changes, e.g. at the end of the frame.
+    void                            ClearChanges();
+
+    // Both pick the first block along the ray within reach and return the position of the block they changed, if any.
+    std::optional<glm::ivec3> BuildBlock(const glm::vec3& playerPosition, const glm::vec3& ray);
+    std::optional<glm::ivec3> BreakBlock(const glm::vec3& playerPosition, const glm::vec3& ray);
+    // Places a block of the given color in every empty cell of [min, max).
+    void                      Fill(const glm::ivec3& min, const glm::ivec3& max, const glm::vec3& color);
 
-    std::vector<Block> GetActiveBlocks() const;
-    void               BuildBlock(const glm::vec3& playerPosition, const glm::vec3& ray);
-    void               BreakBlock(const glm::vec3& playerPosition, const glm::vec3& ray);
+    // Whole chunk moves for streaming, they aren't edits and don't go into the journal. Loading replaces the chunk
+    // at the same coord, unloading hands the chunk back so edited ones can be kept.
+    void                      LoadChunk(std::unique_ptr<Chunk> chunk);
+    std::unique_ptr<Chunk>    UnloadChunk(const glm::ivec3& chunkCoord);
 
 private:
-    WorldSpace _worldSpace;
+    WorldSpace                      _worldSpace;
+    std::vector<ActiveBlock>        _activeBlocks;
+    // Per chunk, the slot in _activeBlocks of each placed cell in index order. Four bytes a block, the chunk's
+    // occupancy bits rank a cell into it.
+    ChunkMap<std::vector<uint32_t>> _chunkSlots;
+    std::vector<BlockChange>        _journal;
+    std::vector<uint32_t>           _dirtySlots;
+    std::vector<glm::ivec3>         _dirtyChunks;
 
-    void                    Initialize();
-    bool                    DoesRayIntersectCube(const glm::vec3& rayStart, const glm::vec3& rayDirection, const glm::vec3& cubeMin, const glm::vec3& cubeMax);
-    glm::ivec3              GetTargetBlockPosition(const glm::vec3& rayStart, const glm::vec3& rayEnd);
-    std::vector<glm::ivec3> GetIntersectedBlockPositions(const glm::vec3& rayStart, const glm::vec3& rayEnd);
+    // Takes the chunk and its active blocks out without queueing the coord.
+    std::unique_ptr<Chunk>  DetachChunk(const glm::ivec3& chunkCoord);
+    void                    SetBlock(const glm::ivec3& position, bool isPlaced);
+    void                    PlaceBlock(const glm::ivec3& position, const glm::vec3& color);
+    // Both expect the cell's occupancy bit to be already set or cleared.
+    void                    AddActiveBlock(const Chunk& chunk, int index, bool wasPlaced);
+    void                    RemoveActiveBlock(const Chunk& chunk, int index);
+    void                    RemoveActiveSlot(uint32_t slot);
+    void                    MarkChunksDirty(const glm::ivec3& position);
+    void                    MarkChunkDirty(const glm::ivec3& chunkCoord);
 };
 
 } // namespace tlr
\ No newline at end of file
@@ -1,41 +1,81 @@
 #include "world_space.hpp"
 
+#include <utility>
+
 namespace tlr
 {
 
-const glm::ivec3 WorldSpace::NULL_POSITION = glm::ivec3{WorldSpace::X_DIMENSION + 1, WorldSpace::Y_DIMENSION + 1, WorldSpace::Z_DIMENSION + 1};
+Block WorldSpace::operator[](const glm::ivec3& position) const
+{
+    const Chunk* chunk = FindChunk(Chunk::GetChunkCoord(position));
+    if (chunk == nullptr)
+    {
+        return Block(position, glm::vec3(0.0f), false);
+    }
+    return chunk->GetBlock(Chunk::GetIndex(Chunk::GetLocalPosition(position)));
+}
+
+BlockRef WorldSpace::operator[](const glm::ivec3& position)
+{
+    return BlockRef(GetOrCreateChunk(Chunk::GetChunkCoord(position)), Chunk::GetIndex(Chunk::GetLocalPosition(position)));
+}
+
+bool WorldSpace::IsPlaced(const glm::ivec3& position) const
+{
+    const Chunk* chunk = FindChunk(Chunk::GetChunkCoord(position));
+    return chunk != nullptr && chunk->IsPlaced(Chunk::GetIndex(Chunk::GetLocalPosition(position)));
+}
+
+Chunk* WorldSpace::FindChunk(const glm::ivec3& chunkCoord)
+{
+    std::unique_ptr<Chunk>* chunk = _chunks.Find(chunkCoord);
+    return chunk ? chunk->get() : nullptr;
+}
 
-WorldSpace::WorldSpace()
+const Chunk* WorldSpace::FindChunk(const glm::ivec3& chunkCoord) const
 {
-    std::size_t xSize = X_DIMENSION * 2 + 1;
-    std::size_t ySize = Y_DIMENSION * 2 + 1;
-    std::size_t zSize = Z_DIMENSION * 2 + 1;
+    const std::unique_ptr<Chunk>* chunk = _chunks.Find(chunkCoord);
+    return chunk ? chunk->get() : nullptr;
+}
 
-    _world.resize(xSize);
-    for (int i = 0; i < xSize; ++i)
+Chunk& WorldSpace::GetOrCreateChunk(const glm::ivec3& chunkCoord)
+{
+    std::unique_ptr<Chunk>& chunk = _chunks[chunkCoord];
+    if (!chunk)
     {
-        _world[i].resize(ySize);
-        for (int j = 0; j < ySize; ++j)
-        {
-            _world[i][j].resize(zSize);
-        }
+        chunk = std::make_unique<Chunk>(chunkCoord);
     }
+    return *chunk;
 }
 
-Block WorldSpace::operator[](const glm::ivec3& position) const
+bool WorldSpace::RemoveChunk(const glm::ivec3& chunkCoord)
 {
-    return _world[position.x + X_DIMENSION][position.y + Y_DIMENSION][position.z + Z_DIMENSION];
+    return _chunks.Erase(chunkCoord);
 }
 
-Block& WorldSpace::operator[](const glm::ivec3& position)
+Chunk& WorldSpace::InsertChunk(std::unique_ptr<Chunk> chunk)
 {
-    return _world[position.x + X_DIMENSION][position.y + Y_DIMENSION][position.z + Z_DIMENSION];
+    std::unique_ptr<Chunk>& slot = _chunks[chunk->GetCoord()];
+    slot = std::move(chunk);
+    return *slot;
+}
+
+std::unique_ptr<Chunk> WorldSpace::ReleaseChunk(const glm::ivec3& chunkCoord)
+{
+    std::unique_ptr<Chunk>* slot = _chunks.Find(chunkCoord);
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<Chunk> chunk = std::move(*slot);
+    _chunks.Erase(chunkCoord);
+    return chunk;
 }
 
-bool WorldSpace::IsPositionInBounds(const glm::ivec3& position) const
+size_t WorldSpace::GetChunkCount() const
 {
-    auto absolutePosition = glm::abs(position);
-    return absolutePosition.x <= X_DIMENSION && absolutePosition.y <= Y_DIMENSION && absolutePosition.z <= Z_DIMENSION;
+    return _chunks.GetSize();
 }
 
 } // namespace tlr
\ No newline at end of file
@@ -1,29 +1,50 @@
 #pragma once
 
-#include <vector>
+#include <memory>
 
 #include <glm/glm.hpp>
 
 #include "block.hpp"
+#include "chunk.hpp"
+#include "chunk_map.hpp"
 
 namespace tlr
 {
-    
+
+// Sparse, unbounded block storage. Chunks are only allocated once something writes into them or they are inserted
+// whole, reading a position whose chunk doesn't exist yields an empty block. A lookup is a chunk map probe plus a bit test.
 class WorldSpace
 {
 public:
-    static constexpr int X_DIMENSION = 10;
-    static constexpr int Y_DIMENSION = 10;
-    static constexpr int Z_DIMENSION = 10;
-    static const glm::ivec3 NULL_POSITION;
+    WorldSpace() = default;
+    Block    operator[](const glm::ivec3& position) const;
+    // Allocates the chunk holding position if it doesn't exist yet.
+    BlockRef operator[](const glm::ivec3& position);
+    // Doesn't allocate, unlike reading through the non-const operator[].
+    bool     IsPlaced(const glm::ivec3& position) const;
+
+    Chunk*       FindChunk(const glm::ivec3& chunkCoord);
+    const Chunk* FindChunk(const glm::ivec3& chunkCoord) const;
+    Chunk&       GetOrCreateChunk(const glm::ivec3& chunkCoord);
+    bool         RemoveChunk(const glm::ivec3& chunkCoord);
+    // Takes over a chunk built elsewhere, e.g. on a generator thread. Replaces the chunk at its coord, if any.
+    Chunk&                 InsertChunk(std::unique_ptr<Chunk> chunk);
+    // Hands the chunk back instead of destroying it, nullptr if there is none.
+    std::unique_ptr<Chunk> ReleaseChunk(const glm::ivec3& chunkCoord);
+    size_t       GetChunkCount() const;
 
-    WorldSpace();
-    Block operator[](const glm::ivec3& position) const;
-    Block& operator[](const glm::ivec3& position);
-    bool IsPositionInBounds(const glm::ivec3& position) const;
+    // f(const Chunk& chunk)
+    template <typename F>
+    void ForEachChunk(F&& f) const
+    {
+        _chunks.ForEach([&f](const glm::ivec3&, const std::unique_ptr<Chunk>& chunk)
+        {
+            f(*chunk);
+        });
+    }
 
 private:
-    std::vector<std::vector<std::vector<Block>>> _world;
+    ChunkMap<std::unique_ptr<Chunk>> _chunks;
 };
 
 } // namespace tlr
\ No newline at end of file
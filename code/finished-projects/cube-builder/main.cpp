@@ -1,13 +1,47 @@
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "app.hpp"
 
-int main()
+static constexpr uint32_t BENCHMARK_FRAME_COUNT = 500;
+
+int main(int argc, char* argv[])
 {
+    // --benchmark-recording and --view-radius are ours, everything else goes to AppBase.
+    bool isRecordingBenchmark = false;
+    const char* viewRadius = nullptr;
+    std::vector<char*> arguments;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--benchmark-recording")
+        {
+            isRecordingBenchmark = true;
+            continue;
+        }
+        if (std::string(argv[i]) == "--view-radius" && i + 1 < argc)
+        {
+            viewRadius = argv[++i];
+            continue;
+        }
+        arguments.push_back(argv[i]);
+    }
+
     try
     {
-        tlr::App app;
-        app.Run();
+        tlr::App app(tlr::ParseCommandLine(static_cast<int>(arguments.size()), arguments.data()));
+        if (viewRadius != nullptr)
+        {
+            app.SetViewRadius(std::stoi(viewRadius));
+        }
+        if (isRecordingBenchmark)
+        {
+            app.BenchmarkRecording(BENCHMARK_FRAME_COUNT);
+        }
+        else
+        {
+            app.Run();
+        }
     }
     catch(const std::exception& e)
     {
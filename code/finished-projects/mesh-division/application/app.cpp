@@ -9,22 +9,21 @@
 #include "initializers.hpp"
 #include "toolset.hpp"
 #include "shader_module.hpp"
+#include "embedded_shaders.hpp"
 
 #define ENQUEUE_OBJ_DEL(lambda) (_deletionQueue).PushFunction(lambda)
 
 namespace tlr
 {
 
-App::App()
+App::App(const AppBaseCreateInfo& createInfo) : AppBase(createInfo)
 {
     camera.SetPosition({0, 0, -20});
     camera.SetLookAtPoint({0, 0, 0});
 
-    InitCommands();
-    InitSyncStructures();
-
     CreateMainMeshVertices();
     CreateMainMeshVertexBuffer();
+    UploadTicket uploadTicket = uploadManager.Flush(); // copies overlap with the setup below
 
     CreateDescriptorPool();
     CreateCameraTransformDescriptorSetLayout();
@@ -35,27 +34,24 @@ App::App()
     CreateMainMeshTransformDescriptorSets();
 
     CreateGraphicsPipeline();
+    uploadManager.Wait(uploadTicket);
 }
 
 App::~App()
 {
     vkDeviceWaitIdle(device);
+    pipelines.WaitIdle();
     _deletionQueue.Flush();
 }
 
 void App::Update()
 {
-    UpdateCameraTransform(_frameNumber);
-    UpdateMainMeshTransform(_frameNumber);
-
-    auto frameData = GetCurrentFrameData();
-    vkWaitForFences(device, 1, &frameData.renderFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(device, 1, &frameData.renderFence);
+    FrameData& frameData = frameContext.BeginFrame();
+    UpdateCameraTransform(frameContext.GetCurrentIndex());
+    UpdateMainMeshTransform(frameContext.GetCurrentIndex());
 
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frameData.swapchainSemaphore, VK_NULL_HANDLE, &imageIndex);
+    uint32_t imageIndex = AcquireNextImage(frameData.swapchainSemaphore);
     
-    vkResetCommandBuffer(frameData.commandBuffer, 0);
     RecordCommandBuffer(frameData.commandBuffer, imageIndex);
     
     VkSemaphore waitSemaphores[] = {frameData.swapchainSemaphore};
@@ -64,50 +60,8 @@ void App::Update()
     VkSubmitInfo submitInfo = init::SubmitInfo(1, waitSemaphores, waitStages, 1, &frameData.commandBuffer, 1, signalSemaphores);
     VK_CHECK_RESULT(vkQueueSubmit(device.queues.graphics, 1, &submitInfo, frameData.renderFence));
 
-    VkPresentInfoKHR presentInfo = init::PresentInfoKHR(1, signalSemaphores, &swapchain.swapchain, &imageIndex);
-    vkQueuePresentKHR(device.queues.present, &presentInfo);
-    _frameNumber = (_frameNumber + 1) % FRAME_OVERLAP;
-}
-
-App::FrameData& App::GetCurrentFrameData()
-{
-    return _frames[_frameNumber];
-}
-
-void App::InitCommands()
-{
-    VkCommandPoolCreateInfo transferCommandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
-    VK_CHECK_RESULT(vkCreateCommandPool(device, &transferCommandPoolCI, nullptr, &_transferPool));
-    ENQUEUE_OBJ_DEL(( [this] { vkDestroyCommandPool(device, _transferPool, nullptr); } ));
-
-    VkCommandPoolCreateInfo commandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-    for (int i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        VK_CHECK_RESULT(vkCreateCommandPool(device, &commandPoolCI, nullptr, &_frames[i].commandPool));
-        ENQUEUE_OBJ_DEL(( [this, i] { vkDestroyCommandPool(device, _frames[i].commandPool, nullptr); } ));
-        
-        VkCommandBufferAllocateInfo commandBufferAI = init::CommandBufferAllocateInfo(_frames[i].commandPool, 1);
-        VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &commandBufferAI, &_frames[i].commandBuffer));
-    }
-}
-
-void App::InitSyncStructures()
-{
-    VkFenceCreateInfo fenceCI = init::FenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-    VkSemaphoreCreateInfo semaphoreCI = init::SemaphoreCreateInfo();
-
-    for (int i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        VK_CHECK_RESULT(vkCreateFence(device, &fenceCI, nullptr, &_frames[i].renderFence));
-        VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCI, nullptr, &_frames[i].swapchainSemaphore));
-        VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCI, nullptr, &_frames[i].renderSemaphore));
-
-        ENQUEUE_OBJ_DEL(( [this, i]() {
-            vkDestroySemaphore(device, _frames[i].renderSemaphore, nullptr);
-            vkDestroySemaphore(device, _frames[i].swapchainSemaphore, nullptr);
-            vkDestroyFence(device, _frames[i].renderFence, nullptr);
-        } ));
-    }
+    PresentImage(frameData.renderSemaphore, imageIndex);
+    frameContext.EndFrame();
 }
 
 
@@ -326,55 +280,24 @@ void App::CreateMainMeshVertices()
     }   
 }
 
-void App::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
-{
-    VkCommandBufferAllocateInfo allocInfo = init::CommandBufferAllocateInfo(_transferPool, 1);
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    VkBufferCopy copyRegion{};
-    copyRegion.srcOffset = 0;
-    copyRegion.dstOffset = 0;
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo = init::SubmitInfo();
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-    vkQueueSubmit(device.queues.graphics, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(device.queues.graphics);
-    
-    vkFreeCommandBuffers(device, _transferPool, 1, &commandBuffer);
-}
-
 void App::CreateMainMeshVertexBuffer()
 {
     VkDeviceSize bufferSize = sizeof(_mainMesh.vertices[0]) * _mainMesh.vertices.size();
-    
-    Buffer stagingBuffer;    
-    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, bufferSize));
-    VK_CHECK_RESULT(stagingBuffer.Map());
-    stagingBuffer.CopyTo(_mainMesh.vertices.data(), bufferSize);
 
     VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &_mainMesh.vertexBuffer, bufferSize));
     ENQUEUE_OBJ_DEL(( [this]() { _mainMesh.vertexBuffer.Destroy(); } ));
 
-    CopyBuffer(stagingBuffer.buffer, _mainMesh.vertexBuffer.buffer, bufferSize);
-
-    stagingBuffer.Destroy();
+    uploadManager.Upload(_mainMesh.vertexBuffer, _mainMesh.vertices.data(), bufferSize);
 }
 
 
 
 void App::CreateDescriptorPool()
 {
-    uint32_t cameraTransformDescriptorCount = static_cast<uint32_t>(FRAME_OVERLAP);
+    uint32_t cameraTransformDescriptorCount = frameContext.GetFramesInFlight();
     VkDescriptorPoolSize cameraTransformSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, cameraTransformDescriptorCount);
 
-    uint32_t mainMeshTransformDescriptorCount = static_cast<uint32_t>(FRAME_OVERLAP);
+    uint32_t mainMeshTransformDescriptorCount = frameContext.GetFramesInFlight();
     VkDescriptorPoolSize mainMeshTransformSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, mainMeshTransformDescriptorCount);
 
     uint32_t maxDescriptorCount = cameraTransformDescriptorCount + mainMeshTransformDescriptorCount;
@@ -395,7 +318,8 @@ void App::CreateCameraTransformDescriptorSetLayout()
 
 void App::CreateCameraTransformUniformBuffers()
 {
-    for (size_t i = 0; i < FRAME_OVERLAP; i++)
+    _cameraTransform.ubos.resize(frameContext.GetFramesInFlight());
+    for (size_t i = 0; i < _cameraTransform.ubos.size(); i++)
     {
         VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &_cameraTransform.ubos[i], sizeof(CameraTransform)));
         ENQUEUE_OBJ_DEL(( [this, i]() { _cameraTransform.ubos[i].Destroy(); } ));
@@ -405,11 +329,12 @@ void App::CreateCameraTransformUniformBuffers()
 
 void App::CreateCameraTransformDescriptorSets()
 {
-    std::vector<VkDescriptorSetLayout> layouts(FRAME_OVERLAP, _cameraTransform.layout);
-    VkDescriptorSetAllocateInfo allocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts.data(), static_cast<uint32_t>(FRAME_OVERLAP));
-    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, _cameraTransform.sets));
+    std::vector<VkDescriptorSetLayout> layouts(frameContext.GetFramesInFlight(), _cameraTransform.layout);
+    VkDescriptorSetAllocateInfo allocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts.data(), frameContext.GetFramesInFlight());
+    _cameraTransform.sets.resize(frameContext.GetFramesInFlight());
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, _cameraTransform.sets.data()));
 
-    for (size_t i = 0; i < FRAME_OVERLAP; i++)
+    for (size_t i = 0; i < _cameraTransform.sets.size(); i++)
     {
         VkWriteDescriptorSet descriptorWrite = init::WriteDescriptorSet(_cameraTransform.sets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &_cameraTransform.ubos[i].descriptor);
         vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
@@ -434,7 +359,8 @@ void App::CreateModelTransformDescriptorSetLayout()
 
 void App::CreateMainMeshTransformUniformBuffers()
 {
-    for (size_t i = 0; i < FRAME_OVERLAP; i++)
+    _mainMesh.transformBuffers.resize(frameContext.GetFramesInFlight());
+    for (size_t i = 0; i < _mainMesh.transformBuffers.size(); i++)
     {
         VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &_mainMesh.transformBuffers[i], sizeof(glm::mat4)));
         ENQUEUE_OBJ_DEL(( [this, i]() { _mainMesh.transformBuffers[i].Destroy(); } ));
@@ -444,12 +370,13 @@ void App::CreateMainMeshTransformUniformBuffers()
 
 void App::CreateMainMeshTransformDescriptorSets()
 {
-    std::vector<VkDescriptorSetLayout> layouts(FRAME_OVERLAP, _modelTransformLayout);
-    VkDescriptorSetAllocateInfo allocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts.data(), static_cast<uint32_t>(FRAME_OVERLAP));
+    std::vector<VkDescriptorSetLayout> layouts(frameContext.GetFramesInFlight(), _modelTransformLayout);
+    VkDescriptorSetAllocateInfo allocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts.data(), frameContext.GetFramesInFlight());
 
-    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, _mainMesh.transformSets));
+    _mainMesh.transformSets.resize(frameContext.GetFramesInFlight());
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, _mainMesh.transformSets.data()));
 
-    for (size_t i = 0; i < FRAME_OVERLAP; i++)
+    for (size_t i = 0; i < _mainMesh.transformSets.size(); i++)
     {
         VkWriteDescriptorSet descriptorWrite = init::WriteDescriptorSet(_mainMesh.transformSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &_mainMesh.transformBuffers[i].descriptor);
         vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
@@ -464,68 +391,11 @@ void App::UpdateMainMeshTransform(uint32_t currentImage)
     memcpy(_mainMesh.transformBuffers[currentImage].mapped, &model, sizeof(model));
 }
 
-std::string GetAbsolutePath(const std::string& relativePath)
-{
-    std::string fullPath(__FILE__);
-    std::string directory = fullPath.substr(0, fullPath.find_last_of("\\/") + 1);
-    std::string absolutePath = directory + relativePath;
-    return absolutePath;
-}
-
 void App::CreateGraphicsPipeline()
 {
-    // Create shaderStages[]
-    std::string fragSpvPath = GetAbsolutePath("../build/spvs/frag.spv");
-    std::string vertSpvPath = GetAbsolutePath("../build/spvs/vert.spv");
-
-    ShaderModule vertModule(device.device, vertSpvPath, VK_SHADER_STAGE_VERTEX_BIT);
-    ShaderModule fragModule(device.device, fragSpvPath, VK_SHADER_STAGE_FRAGMENT_BIT);
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertModule.GetCreateInfo(), fragModule.GetCreateInfo()};
-
-    // Dynamic states
-    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    VkPipelineDynamicStateCreateInfo dynamicStateCI = init::PipelineDynamicStateCreateInfo(dynamicStates, 0);
-
-    // Vertex input
-    auto bindingDescription = Vertex::GetBindingDescription();
-    auto attributeDescriptions = Vertex::GetAttributeDescriptions();
-    VkPipelineVertexInputStateCreateInfo vertexInputCI = init::PipelineVertexInputStateCreateInfo();
-    vertexInputCI.vertexBindingDescriptionCount = 1;
-    vertexInputCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputCI.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputCI.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    // Input assembly
-    VkPipelineInputAssemblyStateCreateInfo inputAssemblyCI = init::PipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
-
-    // Depth stencil
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-    depthStencil.depthBoundsTestEnable = VK_FALSE;
-    depthStencil.minDepthBounds = 0.0f; // Optional
-    depthStencil.maxDepthBounds = 1.0f; // Optional
-    depthStencil.stencilTestEnable = VK_FALSE;
-    depthStencil.front = {}; // Optional
-    depthStencil.back = {}; // Optional
-
-
-    // Viewport state
-    VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
-    VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
-    VkPipelineViewportStateCreateInfo viewportStateCI = init::PipelineViewportStateCreateInfo(1, &viewport, 1, &scissor, 0);
-
-    // Rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterizer = init::PipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_LINE, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_CLOCKWISE, 0);
-
-    // Multisampling
-    VkPipelineMultisampleStateCreateInfo multisampling = init::PipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
-
-    // Color blending
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = init::PipelineColorBlendAttachmentState(VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT, VK_FALSE);
-    VkPipelineColorBlendStateCreateInfo colorBlending = init::PipelineColorBlendStateCreateInfo(1, &colorBlendAttachment);
+    // Shader stages, the modules live in the cache so they outlive the compile
+    ShaderModule vertModule(shaderModuleCache, shaders::SHADER_VERT);
+    ShaderModule fragModule(shaderModuleCache, shaders::SHADER_FRAG);
 
     // Pipeline layout
     VkPipelineLayoutCreateInfo pipelineLayoutCI{};
@@ -539,27 +409,21 @@ void App::CreateGraphicsPipeline()
     VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &_pipelineLayout));
     ENQUEUE_OBJ_DEL(( [this]() { vkDestroyPipelineLayout(device, _pipelineLayout, nullptr); } ));
 
-    // Pipeline
-    VkGraphicsPipelineCreateInfo pipelineCI = init::PipelineCreateInfo();
-    pipelineCI.stageCount = 2;
-    pipelineCI.pStages = shaderStages;
-    pipelineCI.pVertexInputState = &vertexInputCI;
-    pipelineCI.pInputAssemblyState = &inputAssemblyCI;
-    pipelineCI.pViewportState = &viewportStateCI;
-    pipelineCI.pRasterizationState = &rasterizer;
-    pipelineCI.pMultisampleState = &multisampling;
-    pipelineCI.pColorBlendState = &colorBlending;
-    pipelineCI.pDynamicState = &dynamicStateCI;
-    pipelineCI.pDepthStencilState = &depthStencil;
-    pipelineCI.renderPass = renderPass;
-    pipelineCI.layout = _pipelineLayout;
-    pipelineCI.subpass = 0;
-    VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &_graphicsPipeline));
-    ENQUEUE_OBJ_DEL(( [this]() { vkDestroyPipeline(device, _graphicsPipeline, nullptr); } ));
+    // Pipeline, compiled on a worker thread, RecordCommandBuffer skips the draws until it's ready
+    PipelineBuilder builder;
+    builder.AddShaderStage(vertModule.GetCreateInfo())
+           .AddShaderStage(fragModule.GetCreateInfo())
+           .SetVertexInput(Vertex::GetBindingDescription(), Vertex::GetAttributeDescriptions())
+           .SetRasterization(VK_POLYGON_MODE_LINE, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_CLOCKWISE)
+           .SetLayout(_pipelineLayout)
+           .SetRenderPass(renderPass);
+    _graphicsPipeline = pipelines.Request(builder);
 }
 
 void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
 {
+    CPU_PROFILE_SCOPE("RecordCommandBuffer");
+
     VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo();
     VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
 
@@ -575,20 +439,25 @@ void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
     
     
     vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipeline);
+    // Nothing to draw with while the pipeline is still compiling, the pass then only clears.
+    VkPipeline pipeline = pipelines.Get(_graphicsPipeline);
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
-    VkBuffer vertexBuffers[] = {_mainMesh.vertexBuffer.buffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+        VkBuffer vertexBuffers[] = {_mainMesh.vertexBuffer.buffer};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
 
-    VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
-    VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
-    vkCmdSetViewport(cmd, 0, 1, &viewport);
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
+        VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
+        VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_cameraTransform.sets[_frameNumber], 0, nullptr);
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 1, 1, &_mainMesh.transformSets[_frameNumber], 0, nullptr);
-    vkCmdDraw(cmd, static_cast<uint32_t>(_mainMesh.vertices.size()), 1, 0, 0);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_cameraTransform.sets[frameContext.GetCurrentIndex()], 0, nullptr);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 1, 1, &_mainMesh.transformSets[frameContext.GetCurrentIndex()], 0, nullptr);
+        vkCmdDraw(cmd, static_cast<uint32_t>(_mainMesh.vertices.size()), 1, 0, 0);
+    }
 
     vkCmdEndRenderPass(cmd);
     VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
@@ -11,8 +11,6 @@
 #include "deletion_queue.hpp"
 #include "shader_vertex.hpp"
 
-#define FRAME_OVERLAP 2
-
 namespace tlr
 {
 
@@ -25,51 +23,37 @@ struct CameraTransform
 class App : public AppBase
 {
 public:
-    App();
+    App(const AppBaseCreateInfo& createInfo);
     ~App();
 
 protected:
     void Update() override;
 
 private:
-    struct FrameData
-    {
-        VkCommandPool   commandPool;
-        VkCommandBuffer commandBuffer;
-        VkSemaphore     swapchainSemaphore, renderSemaphore;
-        VkFence         renderFence;
-    }                _frames[FRAME_OVERLAP];
-    int              _frameNumber = 0;
-    VkCommandPool    _transferPool;
     VkDescriptorPool _descriptorPool;
 
     struct
     {
-        Buffer                ubos[FRAME_OVERLAP];
-        VkDescriptorSetLayout layout;
-        VkDescriptorSet       sets[FRAME_OVERLAP];
+        std::vector<Buffer>          ubos;
+        VkDescriptorSetLayout        layout;
+        std::vector<VkDescriptorSet> sets;
     } _cameraTransform;
 
     VkDescriptorSetLayout _modelTransformLayout;
 
     struct
     {
-        Buffer              vertexBuffer;
-        std::vector<Vertex> vertices;
-        Buffer              transformBuffers[FRAME_OVERLAP];
-        VkDescriptorSet     transformSets[FRAME_OVERLAP];
+        Buffer                       vertexBuffer;
+        std::vector<Vertex>          vertices;
+        std::vector<Buffer>          transformBuffers;
+        std::vector<VkDescriptorSet> transformSets;
     } _mainMesh;
 
     VkPipelineLayout _pipelineLayout;
-    VkPipeline       _graphicsPipeline;
+    PipelineHandle   _graphicsPipeline;
     DeletionQueue    _deletionQueue;
 
-    void        InitCommands();
-    void        InitSyncStructures();
-    FrameData&  GetCurrentFrameData();
-    
     void        CreateMainMeshVertices();
-    void        CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
     void        CreateMainMeshVertexBuffer();
     
     void        CreateDescriptorPool();
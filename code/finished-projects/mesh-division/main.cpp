@@ -2,11 +2,11 @@
 
 #include "app.hpp"
 
-int main()
+int main(int argc, char* argv[])
 {
     try
     {
-        tlr::App app;
+        tlr::App app(tlr::ParseCommandLine(argc, argv));
         app.Run();
     }
     catch(const std::exception& e)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <array>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -13,7 +14,6 @@
 #include "simulator.hpp"
 #include "utilities.hpp"
 
-#define FRAME_OVERLAP 2
 #define BULLET_COUNT 10
 
 namespace tlr
@@ -28,62 +28,51 @@ struct UniformBufferObject
 class App : public AppBase
 {
 public:
-    App();
+    App(const AppBaseCreateInfo& createInfo);
     ~App();
 
 protected:
+    void FixedUpdate(float fixedTimeStep) override;
     void Update() override;
 
 private:
-    struct FrameData
-    {
-        VkCommandPool   commandPool;
-        VkCommandBuffer commandBuffer;
-        VkSemaphore     swapchainSemaphore, renderSemaphore;
-        VkFence         renderFence;
-    }                _frames[FRAME_OVERLAP];;
-    int              _frameNumber = 0;
-    VkCommandPool    _transferPool;
     VkDescriptorPool _descriptorPool;
 
+    // Both sets are written once against the uniform ring, every draw passes its dynamic offset of this frame.
     struct
     {
-        Buffer                ubos[FRAME_OVERLAP];
         VkDescriptorSetLayout layout;
-        VkDescriptorSet       sets[FRAME_OVERLAP];
+        VkDescriptorSet       set;
+        uint32_t              offset;
     } _cameraTransform;
 
-    VkDescriptorSetLayout _modelTransformLayout;
+    struct
+    {
+        VkDescriptorSetLayout layout;
+        VkDescriptorSet       set;
+    } _modelTransform;
 
     struct
     {
         Buffer              vertexBuffer;
         std::vector<Vertex> vertices;
-        Buffer              transformBuffers[FRAME_OVERLAP];
-        VkDescriptorSet     transformSets[FRAME_OVERLAP];
+        uint32_t            transformOffset;
     } _mainMesh;
     
     Buffer              _bulletVertexBuffer;
     std::vector<Vertex> _bulletVertices;
     struct
     {
-        Buffer          ubos[FRAME_OVERLAP * BULLET_COUNT];
-        VkDescriptorSet sets[FRAME_OVERLAP * BULLET_COUNT];
-        size_t          count = 0;  
+        std::array<uint32_t, BULLET_COUNT> offsets;
+        size_t                             count = 0;
     } _bulletTransforms;
 
     VkPipelineLayout           _pipelineLayout;
-    VkPipeline                 _graphicsPipeline;
+    PipelineHandle             _graphicsPipeline;
     Simulator                  _simulator;
     
     DeletionQueue _deletionQueue;
     
-
-    void        InitCommands();
-    void        InitSyncStructures();
-    FrameData&  GetCurrentFrameData();
-
-    void        CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
     void        CreateMainMeshVertices();
     void        CreateMainMeshVertexBuffer();
     void        CreateBulletVertices();
@@ -91,16 +80,12 @@ private:
 
     void        CreateDescriptorPool();
     void        CreateCameraTransformDescriptorSetLayout();
-    void        CreateCameraTransformUniformBuffers();
-    void        CreateCameraTransformDescriptorSets();
-    void        UpdateCameraTransform(uint32_t currentImage);
+    void        CreateCameraTransformDescriptorSet();
+    void        UpdateCameraTransform();
     void        CreateModelTransformDescriptorSetLayout();
-    void        CreateMainMeshTransformUniformBuffers();
-    void        CreateMainMeshTransformDescriptorSets();
-    void        UpdateMainMeshTransform(uint32_t currentImage);
-    void        CreateBulletTransformsUniformBuffers();
-    void        CreateBulletTransformsDescriptorSets();
-    void        UpdateBulletTransforms(uint32_t currentImage);
+    void        CreateModelTransformDescriptorSet();
+    void        UpdateMainMeshTransform();
+    void        UpdateBulletTransforms();
 
     void        CreateGraphicsPipeline();
     void        RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex);
@@ -12,6 +12,18 @@ Simulator::~Simulator()
 	CleanPhysX();
 }
 
+void Simulator::Update(float timeStep)
+{
+	// Poses from before the step are kept so rendering can blend between the last two states.
+	_previousMainPose = _mainActor->getGlobalPose();
+	for (size_t i = 0; i < _bulletActors.size(); ++i)
+	{
+		_previousBulletPoses[i] = _bulletActors[i]->getGlobalPose();
+	}
+
+	SimulatorBase::Update(timeStep);
+}
+
 
 
 void Simulator::InitPhysX()
@@ -46,6 +58,7 @@ void Simulator::CreateMainMesh(const PxVec3& worldPosition, const PxVec3& dimens
 {
 	_mainMesh = util::CreateRandomConvexMesh(gPhysics, dimensions, vertexCount);
 	_mainActor = CreateDynamic(PxTransform(worldPosition), PxConvexMeshGeometry(_mainMesh), 10.0f);
+	_previousMainPose = _mainActor->getGlobalPose();
 }
 
 std::vector<glm::vec3> Simulator::GetMainMeshTriangles()
@@ -53,9 +66,9 @@ std::vector<glm::vec3> Simulator::GetMainMeshTriangles()
 	return util::GetConvexMeshTriangles(_mainMesh);
 }
 
-glm::mat4 Simulator::GetMainMeshTransform()
+glm::mat4 Simulator::GetMainMeshTransform(float alpha)
 {	
-	PxTransform transform = _mainActor->getGlobalPose();
+	PxTransform transform = util::InterpolateTransform(_previousMainPose, _mainActor->getGlobalPose(), alpha);
 	return util::PxTransformToGlmMat4(transform);	
 }
 
@@ -79,21 +92,24 @@ void Simulator::ShootBullet(const PxVec3& velocity, const PxVec3& position)
 	if (_bulletActors.size() < _MAX_BULLETS)
 	{
 		_bulletActors.push_back(CreateDynamic(PxTransform(position), PxConvexMeshGeometry(_bulletMesh), 500.0f));
+		_previousBulletPoses.push_back(PxTransform(position));
 	}
 
 	auto& currentBullet = _bulletActors[_currentBullet];
 	currentBullet->setGlobalPose(PxTransform(position));
 	currentBullet->setLinearVelocity(velocity);
+	_previousBulletPoses[_currentBullet] = PxTransform(position);
 	_currentBullet = (_currentBullet + 1) % _MAX_BULLETS;
 }
 
-std::vector<glm::mat4> Simulator::GetBulletTransforms()
+std::vector<glm::mat4> Simulator::GetBulletTransforms(float alpha)
 {
 	std::vector<glm::mat4> transforms;
-	for (const auto& actor : _bulletActors)
+	for (size_t i = 0; i < _bulletActors.size(); ++i)
 	{
-		if (!actor) { break; }
-		transforms.push_back(util::PxTransformToGlmMat4(actor->getGlobalPose()));
+		if (!_bulletActors[i]) { break; }
+		PxTransform transform = util::InterpolateTransform(_previousBulletPoses[i], _bulletActors[i]->getGlobalPose(), alpha);
+		transforms.push_back(util::PxTransformToGlmMat4(transform));
 	}
 	return transforms;
 }
\ No newline at end of file
@@ -19,25 +19,29 @@ public:
     Simulator();
     ~Simulator();
 
+    void                   Update(float timeStep) override;
+
     void                   CreateMainMesh(const PxVec3& worldPosition, const PxVec3& dimensions, const PxU32& vertexCount);
     std::vector<glm::vec3> GetMainMeshTriangles();
-    glm::mat4              GetMainMeshTransform();
+    glm::mat4              GetMainMeshTransform(float alpha = 1.0f);
 
     void                   CreateBulletMesh(const PxVec3& dimensions, const PxU32& vertexCount);
     std::vector<glm::vec3> GetBulletMeshTriangles();
 
     size_t                 GetBulletCount();
     void                   ShootBullet(const PxVec3& direction, const PxVec3& position);
-    std::vector<glm::mat4> GetBulletTransforms();    
+    std::vector<glm::mat4> GetBulletTransforms(float alpha = 1.0f);
 
 private:
     PxConvexMesh               *_mainMesh;
     PxRigidDynamic             *_mainActor;
+    PxTransform                _previousMainPose;
 
     const int                    _MAX_BULLETS = 10;
     int                          _currentBullet = 0;
     PxConvexMesh                 *_bulletMesh;
     std::vector<PxRigidDynamic*> _bulletActors;
+    std::vector<PxTransform>     _previousBulletPoses;
 
     void InitPhysX();
     void CleanPhysX();
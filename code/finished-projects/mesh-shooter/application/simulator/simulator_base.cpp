@@ -19,9 +19,9 @@ SimulatorBase::~SimulatorBase()
 	CleanPhysX();
 }
 
-void SimulatorBase::Update(float fps)
+void SimulatorBase::Update(float timeStep)
 {
-	gScene->simulate(fps);
+	gScene->simulate(timeStep);
 	gScene->fetchResults(true);
 }
 
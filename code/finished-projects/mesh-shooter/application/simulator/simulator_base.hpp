@@ -11,9 +11,9 @@ class SimulatorBase
 {
 public:
     SimulatorBase();
-    ~SimulatorBase();
+    virtual ~SimulatorBase();
 
-    void Update(float fps);
+    virtual void Update(float timeStep);
 
 protected:
     static PxDefaultAllocator     gAllocator;
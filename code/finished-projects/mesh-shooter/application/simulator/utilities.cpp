@@ -29,6 +29,13 @@ glm::mat4 PxTransformToGlmMat4(const physx::PxTransform& transform)
     return modelMatrix;
 }
 
+PxTransform InterpolateTransform(const PxTransform& from, const PxTransform& to, float alpha)
+{
+    PxVec3 position = from.p + (to.p - from.p) * alpha;
+    PxQuat rotation = PxSlerp(alpha, from.q, to.q);
+    return PxTransform(position, rotation);
+}
+
 PxConvexMesh* CreateConvexMesh(PxPhysics* physics, PxU32 numVerts, const PxVec3* verts)
 {
     PxTolerancesScale tolerances;
@@ -21,6 +21,8 @@ PxVec3 GlmVec3ToPxVec3(const glm::vec3& vector);
 
 glm::mat4 PxTransformToGlmMat4(const PxTransform& transform);
 
+PxTransform InterpolateTransform(const PxTransform& from, const PxTransform& to, float alpha);
+
 PxConvexMesh* CreateRandomConvexMesh(PxPhysics* physics, const PxVec3& size, const PxU32& vertexCount);
 
 PxConvexMesh* CreateConvexMesh(PxPhysics* physics, PxU32 numVerts, const PxVec3* verts);
@@ -1,6 +1,8 @@
 #include "app.hpp"
 
+#include <cstddef>
 #include <cstring>
+#include <istream>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
@@ -8,12 +10,32 @@
 #include "initializers.hpp"
 #include "toolset.hpp"
 #include "shader_module.hpp"
+#include "embedded_shaders.hpp"
+#include "spirv_reflect.hpp"
 
 #define ENQUEUE_OBJ_DEL(lambda) (_deletionQueue).PushFunction(lambda)
 
 namespace tlr
 {
 
+// The uniform structs are memcpy'd into the ring as they are, so their layout has to match what glslc produced.
+static_assert(spirv::MemberOffset(shaders::SHADER_VERT_CODE, "ModelTransform", "vertexTransform") == offsetof(ModelTransform, vertexTransform), "ModelTransform.vertexTransform doesn't match shader.vert!");
+static_assert(spirv::MemberOffset(shaders::SHADER_VERT_CODE, "ModelTransform", "normalTransform") == offsetof(ModelTransform, normalTransform), "ModelTransform.normalTransform doesn't match shader.vert!");
+static_assert(spirv::MemberOffset(shaders::SHADER_VERT_CODE, "ModelTransform", "view") == offsetof(ModelTransform, view), "ModelTransform.view doesn't match shader.vert!");
+static_assert(spirv::MemberOffset(shaders::SHADER_VERT_CODE, "ModelTransform", "proj") == offsetof(ModelTransform, proj), "ModelTransform.proj doesn't match shader.vert!");
+
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Light", "position") == offsetof(Light, position), "Light.position doesn't match shader.frag!");
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Light", "color") == offsetof(Light, lightColor), "Light.lightColor doesn't match shader.frag!");
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Light", "power") == offsetof(Light, lightPower), "Light.lightPower doesn't match shader.frag!");
+
+static_assert(spirv::MemberCount(shaders::SHADER_FRAG_CODE, "Material") == 6, "Material member count doesn't match shader.frag!");
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Material", "shininess") == offsetof(Material, specularExponent), "Material.specularExponent doesn't match shader.frag!");
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Material", "ambientColor") == offsetof(Material, ambient), "Material.ambient doesn't match shader.frag!");
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Material", "diffuseColor") == offsetof(Material, diffuse), "Material.diffuse doesn't match shader.frag!");
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Material", "specColor") == offsetof(Material, specular), "Material.specular doesn't match shader.frag!");
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Material", "emissive") == offsetof(Material, emissive), "Material.emissive doesn't match shader.frag!");
+static_assert(spirv::MemberOffset(shaders::SHADER_FRAG_CODE, "Material", "alpha") == offsetof(Material, alpha), "Material.alpha doesn't match shader.frag!");
+
 std::string GetAbsolutePath(const std::string& relativePath)
 {
     std::string fullPath(__FILE__);
@@ -22,44 +44,44 @@ std::string GetAbsolutePath(const std::string& relativePath)
     return absolutePath;
 }
 
-App::App() :
+App::App(const AppBaseCreateInfo& createInfo) :
+    AppBase(createInfo),
     MODEL_PATH{GetAbsolutePath("bugatti/bugatti.obj")},
     MTL_PATH{GetAbsolutePath("bugatti")}
 {
     camera.SetPosition({3.82992f, 7.52581f, 23.5453f});
     camera.SetLookAtPoint({0.458236f, 4.42813f, 1.57407f});
-
-    InitCommands();
-    InitSyncStructures();
+    inputManager->AddKeyPressListener(GLFW_KEY_F, [this]() {
+        _isWireframe = !_isWireframe;
+    });
 
     ReadMeshInfo();
     InitMeshVertexBuffer();
+    UploadTicket uploadTicket = uploadManager.Flush(); // copies overlap with the setup below
 
     CreateDescriptorLayouts();
     CreateDescriptorPool();
     CreateDescriptorSets();
 
     CreateGraphicsPipeline();
+    uploadManager.Wait(uploadTicket);
 }
 
 App::~App()
 {
     vkDeviceWaitIdle(device);
+    pipelines.WaitIdle();
     _deletionQueue.Flush();
 }
 
 void App::Update()
 {
+    FrameData& frameData = frameContext.BeginFrame();
+    uniformRing.BeginFrame(frameContext.GetCurrentIndex());
     UpdateDesciptorUbos();
 
-    auto frameData = GetCurrentFrameData();
-    vkWaitForFences(device, 1, &frameData.renderFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(device, 1, &frameData.renderFence);
-
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frameData.swapchainSemaphore, VK_NULL_HANDLE, &imageIndex);
+    uint32_t imageIndex = AcquireNextImage(frameData.swapchainSemaphore);
     
-    vkResetCommandBuffer(frameData.commandBuffer, 0);    
     RecordCommandBuffer(frameData.commandBuffer, imageIndex);
     
     VkSemaphore waitSemaphores[] = {frameData.swapchainSemaphore};
@@ -68,77 +90,41 @@ void App::Update()
     VkSubmitInfo submitInfo = init::SubmitInfo(1, waitSemaphores, waitStages, 1, &frameData.commandBuffer, 1, signalSemaphores);
     VK_CHECK_RESULT(vkQueueSubmit(device.queues.graphics, 1, &submitInfo, frameData.renderFence));
 
-    VkPresentInfoKHR presentInfo = init::PresentInfoKHR(1, signalSemaphores, &swapchain.swapchain, &imageIndex);
-    vkQueuePresentKHR(device.queues.present, &presentInfo);
-    _frameNumber = (_frameNumber + 1) % FRAME_OVERLAP;
-}
-
-
-void App::InitCommands()
-{
-    VkCommandPoolCreateInfo transferCommandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
-    VK_CHECK_RESULT(vkCreateCommandPool(device, &transferCommandPoolCI, nullptr, &_transferPool));
-    ENQUEUE_OBJ_DEL([this] { vkDestroyCommandPool(device, _transferPool, nullptr); });
-
-    VkCommandPoolCreateInfo commandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-    for (int i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        VK_CHECK_RESULT(vkCreateCommandPool(device, &commandPoolCI, nullptr, &_frames[i].commandPool));
-        ENQUEUE_OBJ_DEL(( [this, i] { vkDestroyCommandPool(device, _frames[i].commandPool, nullptr); } ));
-
-        VkCommandBufferAllocateInfo commandBufferAI = init::CommandBufferAllocateInfo(_frames[i].commandPool, 1);
-        VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &commandBufferAI, &_frames[i].commandBuffer));
-    }
-}
-
-void App::InitSyncStructures()
-{
-    VkFenceCreateInfo fenceCI = init::FenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-    VkSemaphoreCreateInfo semaphoreCI = init::SemaphoreCreateInfo();
-
-    for (int i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        VK_CHECK_RESULT(vkCreateFence(device, &fenceCI, nullptr, &_frames[i].renderFence));
-        VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCI, nullptr, &_frames[i].swapchainSemaphore));
-        VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCI, nullptr, &_frames[i].renderSemaphore));
-
-        ENQUEUE_OBJ_DEL(( [this, i] {
-            vkDestroySemaphore(device, _frames[i].renderSemaphore, nullptr);
-            vkDestroySemaphore(device, _frames[i].swapchainSemaphore, nullptr);
-            vkDestroyFence(device, _frames[i].renderFence, nullptr);
-        } ));
-    }
-}
-
-App::FrameData& App::GetCurrentFrameData()
-{
-    return _frames[_frameNumber];
+    PresentImage(frameData.renderSemaphore, imageIndex);
+    frameContext.EndFrame();
 }
 
 
 void App::ReadMeshInfo()
 {
-    tinyobj::ObjReader reader;
-    tinyobj::ObjReaderConfig reader_config;
-    reader_config.mtl_search_path = MTL_PATH;
-
-    if (!reader.ParseFromFile(MODEL_PATH, reader_config))
+    // The OBJ is parsed straight out of the mapping, tinyobj only ever sees a stream over the mapped pages.
+    MappedFile objFile = tools::ReadFile(MODEL_PATH);
+    objFile.Advise(FileAccess::SEQUENTIAL);
+    objFile.ReadaheadAsync();
+
+    FileViewStreamBuf objBuffer(objFile.GetView());
+    std::istream objStream(&objBuffer);
+    tinyobj::MaterialFileReader materialReader(MTL_PATH + "/");
+
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warning;
+    std::string error;
+
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, &objStream, &materialReader))
     {
-        if (!reader.Error().empty())
+        if (!error.empty())
         {
-            std::cerr << "TinyObjReader: " << reader.Error() << std::endl;
+            std::cerr << "TinyObjReader: " << error << std::endl;
         }
         exit(1);
     }
 
-    if (!reader.Warning().empty())
+    if (!warning.empty())
     {
-        std::cout << "TinyObjReader: " << reader.Warning() << std::endl;
+        std::cout << "TinyObjReader: " << warning << std::endl;
     }
-
-    auto& attrib = reader.GetAttrib();
-    auto& shapes = reader.GetShapes();
-    auto& materials = reader.GetMaterials();
     _mesh.materialsCount = materials.size();
     
     for (const auto& m : materials)
@@ -195,30 +181,6 @@ void App::ReadMeshInfo()
     }
 }
 
-void App::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
-{
-    VkCommandBufferAllocateInfo allocInfo = init::CommandBufferAllocateInfo(_transferPool, 1);
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    VkBufferCopy copyRegion{};
-    copyRegion.srcOffset = 0;
-    copyRegion.dstOffset = 0;
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo = init::SubmitInfo();
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-    vkQueueSubmit(device.queues.graphics, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(device.queues.graphics);
-    
-    vkFreeCommandBuffers(device, _transferPool, 1, &commandBuffer);
-}
-
 void App::InitMeshVertexBuffer()
 {
     _mesh.buffers.resize(_mesh.materialsCount);
@@ -230,26 +192,19 @@ void App::InitMeshVertexBuffer()
 
         VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
 
-        Buffer stagingBuffer;
-        VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, bufferSize));
-        VK_CHECK_RESULT(stagingBuffer.Map());
-        stagingBuffer.CopyTo(vertices.data(), bufferSize);
-
         VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &buffer, bufferSize));
         ENQUEUE_OBJ_DEL(([this, i] { _mesh.buffers[i].Destroy(); }));
 
-        CopyBuffer(stagingBuffer.buffer, buffer.buffer, bufferSize);
-
-        stagingBuffer.Destroy();
+        uploadManager.Upload(buffer, vertices.data(), bufferSize);
     }
 }
 
 
 void App::CreateDescriptorLayouts()
 {
-    VkDescriptorSetLayoutBinding modelBindingSet0 = init::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0, 1);
-    VkDescriptorSetLayoutBinding lightBindingSet0 = init::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1, 1);
-    VkDescriptorSetLayoutBinding cameraPositionBindingSet0 = init::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 2, 1);
+    VkDescriptorSetLayoutBinding modelBindingSet0 = init::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 0, 1);
+    VkDescriptorSetLayoutBinding lightBindingSet0 = init::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT, 1, 1);
+    VkDescriptorSetLayoutBinding cameraPositionBindingSet0 = init::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT, 2, 1);
     
     VkDescriptorSetLayoutBinding bindingsSet0[] =
     {
@@ -260,7 +215,7 @@ void App::CreateDescriptorLayouts()
     VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &layoutInfoSet0, nullptr, _layout0));
     ENQUEUE_OBJ_DEL(( [this] { vkDestroyDescriptorSetLayout(device, _layout0, nullptr); } ));
 
-    VkDescriptorSetLayoutBinding materialBindingSet1 = init::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, 1);
+    VkDescriptorSetLayoutBinding materialBindingSet1 = init::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT, 0, 1);
     VkDescriptorSetLayoutBinding bindingsSet1[] =
     {
         materialBindingSet1
@@ -273,21 +228,12 @@ void App::CreateDescriptorLayouts()
 
 void App::CreateDescriptorPool()
 {
-    uint32_t modelTransformCount = static_cast<uint32_t>(FRAME_OVERLAP);
-    VkDescriptorPoolSize modeltransformSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, modelTransformCount);
+    // Model, light and camera position in set 0, the material in set 1.
+    uint32_t uniformCount = 4;
+    VkDescriptorPoolSize uniformSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, uniformCount);
 
-    uint32_t lightCount = static_cast<uint32_t>(FRAME_OVERLAP);
-    VkDescriptorPoolSize lightSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, lightCount);
-    
-    uint32_t cameraPositionCount = static_cast<uint32_t>(FRAME_OVERLAP);
-    VkDescriptorPoolSize cameraPositionSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, cameraPositionCount);
-    
-    uint32_t materialsCount = static_cast<uint32_t>(FRAME_OVERLAP * _mesh.materialsCount);
-    VkDescriptorPoolSize materialsSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, materialsCount);
-    
-    uint32_t maxDescriptorCount = modelTransformCount + lightCount + cameraPositionCount + materialsCount;
-    VkDescriptorPoolSize poolsizes[] = {modeltransformSize, lightSize, cameraPositionSize, materialsSize};
-    VkDescriptorPoolCreateInfo poolInfo = init::DescriptorPoolCreateInfo(4, poolsizes, maxDescriptorCount);
+    VkDescriptorPoolSize poolsizes[] = {uniformSize};
+    VkDescriptorPoolCreateInfo poolInfo = init::DescriptorPoolCreateInfo(1, poolsizes, 2);
 
     VK_CHECK_RESULT(vkCreateDescriptorPool(device, &poolInfo, nullptr, &_descriptorPool));
     ENQUEUE_OBJ_DEL(( [this] { vkDestroyDescriptorPool(device, _descriptorPool, nullptr); } ));
@@ -295,88 +241,43 @@ void App::CreateDescriptorPool()
 
 void App::CreateDescriptorSets()
 {
-    _layout0.sets.resize(FRAME_OVERLAP);
-    _layout1.sets.resize(FRAME_OVERLAP * _mesh.materialsCount);
-    _layout0.ubos.resize(FRAME_OVERLAP);
-    _layout1.ubos.resize(FRAME_OVERLAP * _mesh.materialsCount);
+    VkDescriptorSetAllocateInfo set0AllocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, &_layout0.layout, 1);
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &set0AllocInfo, &_layout0.set));
 
-    for (size_t i = 0; i < FRAME_OVERLAP; ++i)
+    VkDescriptorBufferInfo modelDescriptor = uniformRing.GetDescriptor(sizeof(ModelTransform));
+    VkDescriptorBufferInfo lightDescriptor = uniformRing.GetDescriptor(sizeof(Light));
+    VkDescriptorBufferInfo cameraPositionDescriptor = uniformRing.GetDescriptor(sizeof(glm::vec3));
+    VkWriteDescriptorSet set0Writes[] =
     {
-        auto& ubo = _layout0.ubos[i];
-
-        VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ubo.model, sizeof(ModelTransform)));
-        ENQUEUE_OBJ_DEL(( [&] { ubo.model.Destroy(); } ));
-        VK_CHECK_RESULT(ubo.model.Map());
-
-        VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ubo.light, sizeof(Light)));
-        ENQUEUE_OBJ_DEL(( [&] { ubo.light.Destroy(); } ));
-        VK_CHECK_RESULT(ubo.light.Map());
-        
-        VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ubo.cameraPosition, sizeof(glm::vec3)));
-        ENQUEUE_OBJ_DEL(( [&] { ubo.cameraPosition.Destroy(); } ));
-        VK_CHECK_RESULT(ubo.cameraPosition.Map())
-    }
-
-    for (size_t i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        for (size_t j = 0; j < _mesh.materialsCount; ++j)
-        {
-            auto& ubo = _layout1.ubos[i * _mesh.materialsCount + j];
-
-            VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ubo.material, sizeof(Material)));
-            ENQUEUE_OBJ_DEL(( [&] { ubo.material.Destroy(); } ));
-            VK_CHECK_RESULT(ubo.material.Map());
-        }
-    }
-    
-    uint32_t layout0DescriptorSetsCount = static_cast<uint32_t>(FRAME_OVERLAP);
-    std::vector<VkDescriptorSetLayout> layouts0(layout0DescriptorSetsCount, _layout0);
-    VkDescriptorSetAllocateInfo set0AllocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts0.data(), layout0DescriptorSetsCount);
-    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &set0AllocInfo, _layout0.sets.data()));
-
-    for (size_t i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        auto& set = _layout0.sets[i];
-        auto& ubo = _layout0.ubos[i];
-
-        VkWriteDescriptorSet descriptorWrites[] =
-        {
-            init::WriteDescriptorSet(set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &ubo.model.descriptor),
-            init::WriteDescriptorSet(set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &ubo.light.descriptor),
-            init::WriteDescriptorSet(set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, &ubo.cameraPosition.descriptor)
-        };
-        vkUpdateDescriptorSets(device, 3, descriptorWrites, 0, nullptr);
-    }
+        init::WriteDescriptorSet(_layout0.set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0, &modelDescriptor),
+        init::WriteDescriptorSet(_layout0.set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &lightDescriptor),
+        init::WriteDescriptorSet(_layout0.set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2, &cameraPositionDescriptor)
+    };
+    vkUpdateDescriptorSets(device, 3, set0Writes, 0, nullptr);
 
-    uint32_t layout1DescriptorSetsCount = FRAME_OVERLAP * static_cast<uint32_t>(_mesh.materialsCount);
-    std::vector<VkDescriptorSetLayout> layouts1(layout1DescriptorSetsCount, _layout1);
-    VkDescriptorSetAllocateInfo set1AllocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts1.data(), layout1DescriptorSetsCount);
-    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &set1AllocInfo, _layout1.sets.data()));
+    VkDescriptorSetAllocateInfo set1AllocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, &_layout1.layout, 1);
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &set1AllocInfo, &_layout1.set));
 
-    for (size_t i = 0; i < FRAME_OVERLAP; ++i)
+    VkDescriptorBufferInfo materialDescriptor = uniformRing.GetDescriptor(sizeof(Material));
+    VkWriteDescriptorSet set1Writes[] =
     {
-        for (size_t j = 0; j < _mesh.materialsCount; ++j)
-        {    
-            auto& set = _layout1.sets[i * _mesh.materialsCount + j];
-            auto& ubo = _layout1.ubos[i * _mesh.materialsCount + j];
+        init::WriteDescriptorSet(_layout1.set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0, &materialDescriptor)
+    };
+    vkUpdateDescriptorSets(device, 1, set1Writes, 0, nullptr);
 
-            VkWriteDescriptorSet descriptorWrites[] =
-            {
-                init::WriteDescriptorSet(set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &ubo.material.descriptor)
-            };
-            vkUpdateDescriptorSets(device, 1, descriptorWrites, 0, nullptr);
-        }
-    }
+    _materialOffsets.resize(_mesh.materialsCount);
 }
 
 void App::UpdateDesciptorUbos()
 {
+    CPU_PROFILE_SCOPE("UpdateDesciptorUbos");
+
     ModelTransform modelUbo {};
     modelUbo.vertexTransform = glm::mat4(1.0f);
     modelUbo.normalTransform = glm::mat4(1.0f);
     modelUbo.view = camera.GetViewMatrix();
     modelUbo.proj = camera.GetProjectionMatrix();
-    memcpy(_layout0.ubos[_frameNumber].model.mapped, &modelUbo, sizeof(ModelTransform));
+    _layout0Offsets[0] = uniformRing.Push(modelUbo);
 
     Light lightUbo {};
     glm::vec3 pos{-0.753088, 9.57204,-1.55403};
@@ -384,81 +285,23 @@ void App::UpdateDesciptorUbos()
     lightUbo.position = pos + circle;
     lightUbo.lightColor = {1,1,1};
     lightUbo.lightPower = 20.0f;
-    memcpy(_layout0.ubos[_frameNumber].light.mapped, &lightUbo, sizeof(Light));
+    _layout0Offsets[1] = uniformRing.Push(lightUbo);
 
     glm::vec3 cameraUbo = camera.GetPosition();
-    memcpy(_layout0.ubos[_frameNumber].cameraPosition.mapped, &cameraUbo, sizeof(glm::vec3));
+    _layout0Offsets[2] = uniformRing.Push(cameraUbo);
 
     for (size_t j = 0; j < _mesh.materialsCount; ++j)
     {
-        Material materialUbo = _mesh.materials[j];
-        memcpy(_layout1.ubos[_frameNumber * _mesh.materialsCount + j].material.mapped, &materialUbo, sizeof(Material));
+        _materialOffsets[j] = uniformRing.Push(_mesh.materials[j]);
     }
 }
 
 
 void App::CreateGraphicsPipeline()
 {
-    // Create shaderStages[]
-    std::string fragSpvPath = GetAbsolutePath("../build/spvs/frag.spv");
-    std::string vertSpvPath = GetAbsolutePath("../build/spvs/vert.spv");
-
-    ShaderModule vertModule(device.device, vertSpvPath, VK_SHADER_STAGE_VERTEX_BIT);
-    ShaderModule fragModule(device.device, fragSpvPath, VK_SHADER_STAGE_FRAGMENT_BIT);
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertModule.GetCreateInfo(), fragModule.GetCreateInfo()};
-
-    // Dynamic states
-    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    VkPipelineDynamicStateCreateInfo dynamicStateCI = init::PipelineDynamicStateCreateInfo(dynamicStates, 0);
-
-    // Vertex input
-    auto bindingDescription = Vertex::GetBindingDescription();
-    auto attributeDescriptions = Vertex::GetAttributeDescriptions();
-    VkPipelineVertexInputStateCreateInfo vertexInputCI = init::PipelineVertexInputStateCreateInfo();
-    vertexInputCI.vertexBindingDescriptionCount = 1;
-    vertexInputCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputCI.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputCI.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    // Input assembly
-    VkPipelineInputAssemblyStateCreateInfo inputAssemblyCI = init::PipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
-
-    // Depth stencil
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-    depthStencil.depthBoundsTestEnable = VK_FALSE;
-    depthStencil.minDepthBounds = 0.0f; // Optional
-    depthStencil.maxDepthBounds = 1.0f; // Optional
-    depthStencil.stencilTestEnable = VK_FALSE;
-    depthStencil.front = {}; // Optional
-    depthStencil.back = {}; // Optional
-
-    // Viewport state
-    VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
-    VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
-    VkPipelineViewportStateCreateInfo viewportStateCI = init::PipelineViewportStateCreateInfo(1, &viewport, 1, &scissor, 0);
-
-    // Rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterizer = init::PipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_CLOCKWISE, 0);
-
-    // Multisampling
-    VkPipelineMultisampleStateCreateInfo multisampling = init::PipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
-
-    // Color blending
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending = init::PipelineColorBlendStateCreateInfo(1, &colorBlendAttachment);
+    // Shader stages, the modules live in the cache so they outlive the compile
+    ShaderModule vertModule(shaderModuleCache, shaders::SHADER_VERT);
+    ShaderModule fragModule(shaderModuleCache, shaders::SHADER_FRAG);
 
     // Pipeline layout
     VkPipelineLayoutCreateInfo pipelineLayoutCI{};
@@ -470,29 +313,29 @@ void App::CreateGraphicsPipeline()
     VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &_pipelineLayout));
     ENQUEUE_OBJ_DEL(( [this] { vkDestroyPipelineLayout(device, _pipelineLayout, nullptr); } ));
 
-    // Pipeline
-    VkGraphicsPipelineCreateInfo pipelineCI = init::PipelineCreateInfo();
-    pipelineCI.stageCount = 2;
-    pipelineCI.pStages = shaderStages;
-    pipelineCI.pVertexInputState = &vertexInputCI;
-    pipelineCI.pInputAssemblyState = &inputAssemblyCI;
-    pipelineCI.pViewportState = &viewportStateCI;
-    pipelineCI.pRasterizationState = &rasterizer;
-    pipelineCI.pMultisampleState = &multisampling;
-    pipelineCI.pColorBlendState = &colorBlending;
-    pipelineCI.pDynamicState = &dynamicStateCI;
-    pipelineCI.pDepthStencilState = &depthStencil;
-    pipelineCI.renderPass = renderPass;
-    pipelineCI.layout = _pipelineLayout;
-    pipelineCI.subpass = 0;
-    VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &_graphicsPipeline));
-    ENQUEUE_OBJ_DEL(( [this] { vkDestroyPipeline(device, _graphicsPipeline, nullptr); } ));
+    // Pipeline, compiled on a worker thread, RecordCommandBuffer skips the draws until it's ready
+    PipelineBuilder builder;
+    builder.AddShaderStage(vertModule.GetCreateInfo())
+           .AddShaderStage(fragModule.GetCreateInfo())
+           .SetVertexInput(Vertex::GetBindingDescription(), Vertex::GetAttributeDescriptions())
+           .SetBlendMode(BlendMode::ALPHA)
+           .SetLayout(_pipelineLayout)
+           .SetRenderPass(renderPass);
+    _graphicsPipeline = pipelines.Request(builder);
+
+    // Same state with lines and no culling, F toggles it
+    builder.SetRasterization(VK_POLYGON_MODE_LINE, VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE);
+    _wireframePipeline = pipelines.Request(builder);
 }
 
 void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
 {
+    CPU_PROFILE_SCOPE("RecordCommandBuffer");
+
     VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo();
     VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+    gpuProfiler.BeginFrame(cmd, frameContext.GetCurrentIndex());
+    uint32_t mainPassScope = gpuProfiler.BeginScope(cmd, "MainPass");
 
     std::array<VkClearValue, 2> clearValues{};
     clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
@@ -504,28 +347,41 @@ void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
     renderPassInfo.pClearValues = clearValues.data();    
     vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipeline);
-
-    VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
-    vkCmdSetViewport(cmd, 0, 1, &viewport);
-    
-    VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
-    
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_layout0.sets[_frameNumber], 0, nullptr);
-    for (int i = 0; i < _mesh.materialsCount; ++i)
+    // The wireframe variant compiles in the background, the filled pipeline stands in until it is ready. Before that
+    // one is ready too nothing is drawn and the pass only clears.
+    VkPipeline pipeline = pipelines.Get(_isWireframe ? _wireframePipeline : _graphicsPipeline);
+    if (pipeline == VK_NULL_HANDLE)
     {
-        VkBuffer vertexBuffers[] = {_mesh.buffers[i].buffer};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+        pipeline = pipelines.Get(_graphicsPipeline);
+    }
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+        VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+        VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-        size_t index = _frameNumber * _mesh.materialsCount + i;
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 1, 1, &_layout1.sets[index], 0, nullptr);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_layout0.set, static_cast<uint32_t>(_layout0Offsets.size()), _layout0Offsets.data());
 
-        vkCmdDraw(cmd, static_cast<uint32_t>(_mesh.vertices[i].size()), 1, 0, 0);
+        uint32_t meshDrawsScope = gpuProfiler.BeginScope(cmd, "MeshDraws");
+        for (int i = 0; i < _mesh.materialsCount; ++i)
+        {
+            VkBuffer vertexBuffers[] = {_mesh.buffers[i].buffer};
+            VkDeviceSize offsets[] = {0};
+            vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 1, 1, &_layout1.set, 1, &_materialOffsets[i]);
+
+            vkCmdDraw(cmd, static_cast<uint32_t>(_mesh.vertices[i].size()), 1, 0, 0);
+        }
+        gpuProfiler.EndScope(cmd, meshDrawsScope);
     }
 
     vkCmdEndRenderPass(cmd);
+    gpuProfiler.EndScope(cmd, mainPassScope);
     VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
 }
 
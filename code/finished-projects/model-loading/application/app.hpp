@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <vector>
+#include <array>
 #include <string>
 #include <unordered_map>
 
@@ -11,8 +12,6 @@
 #include "app_base.hpp"
 #include "vertex.hpp"
 
-#define FRAME_OVERLAP 2
-
 namespace tlr
 {
 
@@ -42,21 +41,20 @@ struct Light
     alignas(4)  float     lightPower;
 };
 
-template <typename LayoutUBO>
 struct Layout
 {
     VkDescriptorSetLayout layout;
     operator VkDescriptorSetLayout&() { return layout; }
     operator VkDescriptorSetLayout*() { return &layout; }
 
-    std::vector<LayoutUBO>       ubos;
-    std::vector<VkDescriptorSet> sets;
+    // Written once against the uniform ring, per-frame data is picked with dynamic offsets.
+    VkDescriptorSet set;
 };
 
 class App : public AppBase
 {
 public:
-    App();
+    App(const AppBaseCreateInfo& createInfo);
     ~App();
 
 protected:
@@ -66,20 +64,6 @@ private:
     const std::string MODEL_PATH;
     const std::string MTL_PATH;
 
-    struct FrameData
-    {
-        VkCommandPool   commandPool;
-        VkCommandBuffer commandBuffer;
-        VkSemaphore     swapchainSemaphore, renderSemaphore;
-        VkFence         renderFence;
-    }                _frames[FRAME_OVERLAP];
-    int              _frameNumber = 0;
-    VkCommandPool    _transferPool;
-
-    void       InitCommands();
-    void       InitSyncStructures();
-    FrameData& GetCurrentFrameData();
-
     struct
     {
         size_t                materialsCount;
@@ -89,23 +73,13 @@ private:
     } _mesh;
 
     void ReadMeshInfo();
-    void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
     void InitMeshVertexBuffer();
 
-    struct Layout0UBO
-    {
-        Buffer model;
-        Buffer light;
-        Buffer cameraPosition;
-    };
-    struct Layout1UBO
-    {
-        Buffer material;
-    };
-
-    VkDescriptorPool   _descriptorPool;
-    Layout<Layout0UBO> _layout0;
-    Layout<Layout1UBO> _layout1;
+    VkDescriptorPool        _descriptorPool;
+    Layout                  _layout0;
+    Layout                  _layout1;
+    std::array<uint32_t, 3> _layout0Offsets; // model, light and camera position of this frame
+    std::vector<uint32_t>   _materialOffsets;
 
     void CreateDescriptorLayouts();
     void CreateDescriptorPool();
@@ -113,7 +87,9 @@ private:
     void UpdateDesciptorUbos();
 
     VkPipelineLayout _pipelineLayout;
-    VkPipeline       _graphicsPipeline;
+    PipelineHandle   _graphicsPipeline;
+    PipelineHandle   _wireframePipeline;
+    bool             _isWireframe = false;
     DeletionQueue    _deletionQueue;
 
     void CreateGraphicsPipeline();
@@ -12,22 +12,21 @@
 #include "initializers.hpp"
 #include "toolset.hpp"
 #include "shader_module.hpp"
+#include "embedded_shaders.hpp"
 
 #define ENQUEUE_OBJ_DEL(lambda) (_deletionQueue).PushFunction(lambda)
 
 namespace tlr
 {
 
-App::App()
+App::App(const AppBaseCreateInfo& createInfo) : AppBase(createInfo)
 {
     camera.SetPosition({0, 0, -10});
     camera.SetLookAtPoint({0, 0, 0});
 
-    InitCommands();
-    InitSyncStructures();
-
     CreateVertexBuffer();
     CreateIndexBuffer();
+    UploadTicket uploadTicket = uploadManager.Flush(); // copies overlap with the setup below
     CreateUniformBuffers();
 
     CreateDescriptorSetLayout();
@@ -35,94 +34,40 @@ App::App()
     CreateDescriptorSets();
 
     CreateGraphicsPipeline();
+    uploadManager.Wait(uploadTicket);
 }
 
 App::~App()
 {
     vkDeviceWaitIdle(device);
+    pipelines.WaitIdle();
     _deletionQueue.Flush();
 }
 
-App::FrameData& App::GetCurrentFrameData()
-{
-    return _frames[_frameNumber];
-}
-
-void App::InitCommands()
-{
-    VkCommandPoolCreateInfo transferCommandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
-    VK_CHECK_RESULT(vkCreateCommandPool(device, &transferCommandPoolCI, nullptr, &_transferPool));
-    ENQUEUE_OBJ_DEL(( [this] { vkDestroyCommandPool(device, _transferPool, nullptr); } ));
-
-    VkCommandPoolCreateInfo commandPoolCI = init::CommandPoolCreateInfo(device.queues.graphicsFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-    for (int i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        VK_CHECK_RESULT(vkCreateCommandPool(device, &commandPoolCI, nullptr, &_frames[i].commandPool));
-        ENQUEUE_OBJ_DEL(( [this, i] { vkDestroyCommandPool(device, _frames[i].commandPool, nullptr); } ));
-        
-        VkCommandBufferAllocateInfo commandBufferAI = init::CommandBufferAllocateInfo(_frames[i].commandPool, 1);
-        VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &commandBufferAI, &_frames[i].commandBuffer));
-    }
-}
-
-void App::InitSyncStructures()
-{
-    VkFenceCreateInfo fenceCI = init::FenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-    VkSemaphoreCreateInfo semaphoreCI = init::SemaphoreCreateInfo();
-
-    for (int i = 0; i < FRAME_OVERLAP; ++i)
-    {
-        VK_CHECK_RESULT(vkCreateFence(device, &fenceCI, nullptr, &_frames[i].renderFence));
-        VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCI, nullptr, &_frames[i].swapchainSemaphore));
-        VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCI, nullptr, &_frames[i].renderSemaphore));
-
-        ENQUEUE_OBJ_DEL(( [this, i]() {
-            vkDestroySemaphore(device, _frames[i].renderSemaphore, nullptr);
-            vkDestroySemaphore(device, _frames[i].swapchainSemaphore, nullptr);
-            vkDestroyFence(device, _frames[i].renderFence, nullptr);
-        } ));
-    }
-}
-
 void App::CreateVertexBuffer()
 {
     VkDeviceSize bufferSize = sizeof(_vertices[0]) * _vertices.size();
-    
-    Buffer stagingBuffer;
-    
-    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, bufferSize));
-
-    VK_CHECK_RESULT(stagingBuffer.Map());
-    stagingBuffer.CopyTo(_vertices.data(), bufferSize);
 
     VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &_vertexBuffer, bufferSize));
     ENQUEUE_OBJ_DEL(( [this]() { _vertexBuffer.Destroy(); } ));
 
-    CopyBuffer(stagingBuffer.buffer, _vertexBuffer.buffer, bufferSize);
-
-    stagingBuffer.Destroy();
+    uploadManager.Upload(_vertexBuffer, _vertices.data(), bufferSize);
 }
 
 void App::CreateIndexBuffer()
 {
     VkDeviceSize bufferSize = sizeof(_indices[0]) * _indices.size();
-    
-    Buffer stagingBuffer;
-    VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, bufferSize));
-    VK_CHECK_RESULT(stagingBuffer.Map());
-    stagingBuffer.CopyTo(_indices.data(), bufferSize);
 
     VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &_indexBuffer, bufferSize));
     ENQUEUE_OBJ_DEL(( [this]() { _indexBuffer.Destroy(); } ));
 
-    CopyBuffer(stagingBuffer.buffer, _indexBuffer.buffer, bufferSize);
-
-    stagingBuffer.Destroy();
+    uploadManager.Upload(_indexBuffer, _indices.data(), bufferSize);
 }
 
 void App::CreateUniformBuffers()
 {
-    for (size_t i = 0; i < FRAME_OVERLAP; i++)
+    _uniformBuffers.resize(frameContext.GetFramesInFlight());
+    for (size_t i = 0; i < _uniformBuffers.size(); i++)
     {
         VK_CHECK_RESULT(device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &_uniformBuffers[i], sizeof(UniformBufferObject)));
         ENQUEUE_OBJ_DEL(( [this, i]() { _uniformBuffers[i].Destroy(); } ));
@@ -130,46 +75,25 @@ void App::CreateUniformBuffers()
     }
 }
 
-void App::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
-{
-    VkCommandBufferAllocateInfo allocInfo = init::CommandBufferAllocateInfo(_transferPool, 1);
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    VkBufferCopy copyRegion{};
-    copyRegion.srcOffset = 0;
-    copyRegion.dstOffset = 0;
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo = init::SubmitInfo();
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-    vkQueueSubmit(device.queues.graphics, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(device.queues.graphics);
-
-    vkFreeCommandBuffers(device, _transferPool, 1, &commandBuffer);
-}
-
 void App::CreateDescriptorPool()
 {
-    VkDescriptorPoolSize poolSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, static_cast<uint32_t>(FRAME_OVERLAP));
-    VkDescriptorPoolCreateInfo poolInfo = init::DescriptorPoolCreateInfo(1, &poolSize, static_cast<uint32_t>(FRAME_OVERLAP));
+    uint32_t framesInFlight = frameContext.GetFramesInFlight();
+    VkDescriptorPoolSize poolSize = init::DescriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, framesInFlight);
+    VkDescriptorPoolCreateInfo poolInfo = init::DescriptorPoolCreateInfo(1, &poolSize, framesInFlight);
     VK_CHECK_RESULT(vkCreateDescriptorPool(device, &poolInfo, nullptr, &_descriptorPool));
     ENQUEUE_OBJ_DEL(( [this]() { vkDestroyDescriptorPool(device, _descriptorPool, nullptr); } ));
 }
 
 void App::CreateDescriptorSets()
 {
-    std::vector<VkDescriptorSetLayout> layouts(FRAME_OVERLAP, _descriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts.data(), static_cast<uint32_t>(FRAME_OVERLAP));
+    uint32_t framesInFlight = frameContext.GetFramesInFlight();
+    std::vector<VkDescriptorSetLayout> layouts(framesInFlight, _descriptorSetLayout);
+    VkDescriptorSetAllocateInfo allocInfo = init::DescriptorSetAllocateInfo(_descriptorPool, layouts.data(), framesInFlight);
 
-    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, _descriptorSets));
+    _descriptorSets.resize(framesInFlight);
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, _descriptorSets.data()));
 
-    for (size_t i = 0; i < FRAME_OVERLAP; i++)
+    for (size_t i = 0; i < framesInFlight; i++)
     {
         VkWriteDescriptorSet descriptorWrite = init::WriteDescriptorSet(_descriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &_uniformBuffers[i].descriptor);
         vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
@@ -184,68 +108,11 @@ void App::CreateDescriptorSetLayout()
     ENQUEUE_OBJ_DEL(( [this]() { vkDestroyDescriptorSetLayout(device, _descriptorSetLayout, nullptr); } ));
 }
 
-std::string GetAbsolutePath(const std::string& relativePath)
-{
-    std::string fullPath(__FILE__);
-    std::string directory = fullPath.substr(0, fullPath.find_last_of("\\/") + 1);
-    std::string absolutePath = directory + relativePath;
-    return absolutePath;
-}
-
 void App::CreateGraphicsPipeline()
 {
-    // Create shaderStages[]
-    std::string fragSpvPath = GetAbsolutePath("../build/spvs/frag.spv");
-    std::string vertSpvPath = GetAbsolutePath("../build/spvs/vert.spv");
-
-    ShaderModule vertModule(device.device, vertSpvPath, VK_SHADER_STAGE_VERTEX_BIT);
-    ShaderModule fragModule(device.device, fragSpvPath, VK_SHADER_STAGE_FRAGMENT_BIT);
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertModule.GetCreateInfo(), fragModule.GetCreateInfo()};
-
-    // Dynamic states
-    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    VkPipelineDynamicStateCreateInfo dynamicStateCI = init::PipelineDynamicStateCreateInfo(dynamicStates, 0);
-
-    // Vertex input
-    auto bindingDescription = Vertex::GetBindingDescription();
-    auto attributeDescriptions = Vertex::GetAttributeDescriptions();
-    VkPipelineVertexInputStateCreateInfo vertexInputCI = init::PipelineVertexInputStateCreateInfo();
-    vertexInputCI.vertexBindingDescriptionCount = 1;
-    vertexInputCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputCI.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputCI.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    // Input assembly
-    VkPipelineInputAssemblyStateCreateInfo inputAssemblyCI = init::PipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
-
-    // Depth stencil
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-    depthStencil.depthBoundsTestEnable = VK_FALSE;
-    depthStencil.minDepthBounds = 0.0f; // Optional
-    depthStencil.maxDepthBounds = 1.0f; // Optional
-    depthStencil.stencilTestEnable = VK_FALSE;
-    depthStencil.front = {}; // Optional
-    depthStencil.back = {}; // Optional
-
-
-    // Viewport state
-    VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
-    VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
-    VkPipelineViewportStateCreateInfo viewportStateCI = init::PipelineViewportStateCreateInfo(1, &viewport, 1, &scissor, 0);
-
-    // Rasterizer
-    VkPipelineRasterizationStateCreateInfo rasterizer = init::PipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
-
-    // Multisampling
-    VkPipelineMultisampleStateCreateInfo multisampling = init::PipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
-
-    // Color blending
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = init::PipelineColorBlendAttachmentState(VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT, VK_FALSE);
-    VkPipelineColorBlendStateCreateInfo colorBlending = init::PipelineColorBlendStateCreateInfo(1, &colorBlendAttachment);
+    // Shader stages, the modules live in the cache so they outlive the compile
+    ShaderModule vertModule(shaderModuleCache, shaders::SHADER_VERT);
+    ShaderModule fragModule(shaderModuleCache, shaders::SHADER_FRAG);
 
     // Pipeline layout
     VkPipelineLayoutCreateInfo pipelineLayoutCI{};
@@ -258,27 +125,21 @@ void App::CreateGraphicsPipeline()
     VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &_pipelineLayout));
     ENQUEUE_OBJ_DEL(( [this]() { vkDestroyPipelineLayout(device, _pipelineLayout, nullptr); } ));
 
-    // Pipeline
-    VkGraphicsPipelineCreateInfo pipelineCI = init::PipelineCreateInfo();
-    pipelineCI.stageCount = 2;
-    pipelineCI.pStages = shaderStages;
-    pipelineCI.pVertexInputState = &vertexInputCI;
-    pipelineCI.pInputAssemblyState = &inputAssemblyCI;
-    pipelineCI.pViewportState = &viewportStateCI;
-    pipelineCI.pRasterizationState = &rasterizer;
-    pipelineCI.pMultisampleState = &multisampling;
-    pipelineCI.pColorBlendState = &colorBlending;
-    pipelineCI.pDynamicState = &dynamicStateCI;
-    pipelineCI.pDepthStencilState = &depthStencil;
-    pipelineCI.renderPass = renderPass;
-    pipelineCI.layout = _pipelineLayout;
-    pipelineCI.subpass = 0;
-    VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &_graphicsPipeline));
-    ENQUEUE_OBJ_DEL(( [this]() { vkDestroyPipeline(device, _graphicsPipeline, nullptr); } ));
+    // Pipeline, compiled on a worker thread, RecordCommandBuffer skips the draws until it's ready
+    PipelineBuilder builder;
+    builder.AddShaderStage(vertModule.GetCreateInfo())
+           .AddShaderStage(fragModule.GetCreateInfo())
+           .SetVertexInput(Vertex::GetBindingDescription(), Vertex::GetAttributeDescriptions())
+           .SetRasterization(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
+           .SetLayout(_pipelineLayout)
+           .SetRenderPass(renderPass);
+    _graphicsPipeline = pipelines.Request(builder);
 }
 
 void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
 {
+    CPU_PROFILE_SCOPE("RecordCommandBuffer");
+
     VkCommandBufferBeginInfo beginInfo = init::CommandBufferBeginInfo();
     VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
 
@@ -294,22 +155,27 @@ void App::RecordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
     
     vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipeline);
+    // Nothing to draw with while the pipeline is still compiling, the pass then only clears.
+    VkPipeline pipeline = pipelines.Get(_graphicsPipeline);
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
-    VkBuffer vertexBuffers[] = {_vertexBuffer.buffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+        VkBuffer vertexBuffers[] = {_vertexBuffer.buffer};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
 
-    vkCmdBindIndexBuffer(cmd, _indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
+        vkCmdBindIndexBuffer(cmd, _indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
 
-    VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
-    vkCmdSetViewport(cmd, 0, 1, &viewport);
+        VkViewport viewport = init::Viewport(static_cast<float>(swapchain.extent.width), static_cast<float>(swapchain.extent.height), 0.0f, 1.0f);
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
 
-    VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
+        VkRect2D scissor = init::Rect2D({0, 0}, swapchain.extent);
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_descriptorSets[_frameNumber], 0, nullptr);
-    vkCmdDrawIndexed(cmd, static_cast<uint32_t>(_indices.size()), 1, 0, 0, 0);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_descriptorSets[frameContext.GetCurrentIndex()], 0, nullptr);
+        vkCmdDrawIndexed(cmd, static_cast<uint32_t>(_indices.size()), 1, 0, 0, 0);
+    }
 
     vkCmdEndRenderPass(cmd);
     VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
@@ -332,16 +198,11 @@ void App::UpdateUniformBuffer(uint32_t currentImage)
 
 void App::Update()
 {
-    UpdateUniformBuffer(_frameNumber);
-
-    auto frameData = GetCurrentFrameData();
-    vkWaitForFences(device, 1, &frameData.renderFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(device, 1, &frameData.renderFence);
+    FrameData& frameData = frameContext.BeginFrame();
+    UpdateUniformBuffer(frameContext.GetCurrentIndex());
 
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frameData.swapchainSemaphore, VK_NULL_HANDLE, &imageIndex);
+    uint32_t imageIndex = AcquireNextImage(frameData.swapchainSemaphore);
     
-    vkResetCommandBuffer(frameData.commandBuffer, 0);
     RecordCommandBuffer(frameData.commandBuffer, imageIndex);
     
     VkSemaphore waitSemaphores[] = {frameData.swapchainSemaphore};
@@ -350,9 +211,8 @@ void App::Update()
     VkSubmitInfo submitInfo = init::SubmitInfo(1, waitSemaphores, waitStages, 1, &frameData.commandBuffer, 1, signalSemaphores);
     VK_CHECK_RESULT(vkQueueSubmit(device.queues.graphics, 1, &submitInfo, frameData.renderFence));
 
-    VkPresentInfoKHR presentInfo = init::PresentInfoKHR(1, signalSemaphores, &swapchain.swapchain, &imageIndex);
-    vkQueuePresentKHR(device.queues.present, &presentInfo);
-    _frameNumber = (_frameNumber + 1) % FRAME_OVERLAP;
+    PresentImage(frameData.renderSemaphore, imageIndex);
+    frameContext.EndFrame();
 }
 
 } // namespace tlr
\ No newline at end of file
@@ -10,8 +10,6 @@
 #include "deletion_queue.hpp"
 #include "shader_vertex.hpp"
 
-#define FRAME_OVERLAP 2
-
 namespace tlr
 {
 
@@ -25,23 +23,13 @@ struct UniformBufferObject
 class App : public AppBase
 {
 public:
-    App();
+    App(const AppBaseCreateInfo& createInfo);
     ~App();
 
 protected:
     void Update() override;
 
 private:
-    struct FrameData
-    {
-        VkCommandPool   commandPool;
-        VkCommandBuffer commandBuffer;
-        VkSemaphore     swapchainSemaphore, renderSemaphore;
-        VkFence         renderFence;
-    }             _frames[FRAME_OVERLAP];
-    int           _frameNumber = 0;
-    VkCommandPool _transferPool;
-
     const std::vector<Vertex> _vertices = {
         {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
         {{0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
@@ -71,23 +59,18 @@ private:
     Buffer _vertexBuffer;
     Buffer _indexBuffer;
 
-    Buffer                _uniformBuffers[FRAME_OVERLAP];
-    VkDescriptorSetLayout _descriptorSetLayout;
-    VkDescriptorPool      _descriptorPool;
-    VkDescriptorSet       _descriptorSets[FRAME_OVERLAP];
+    std::vector<Buffer>          _uniformBuffers;
+    VkDescriptorSetLayout        _descriptorSetLayout;
+    VkDescriptorPool             _descriptorPool;
+    std::vector<VkDescriptorSet> _descriptorSets;
 
     VkPipelineLayout _pipelineLayout;
-    VkPipeline       _graphicsPipeline;
+    PipelineHandle   _graphicsPipeline;
     
     DeletionQueue _deletionQueue;
 
-    void        InitCommands();
-    void        InitSyncStructures();
-    FrameData&  GetCurrentFrameData();
-    
     void        CreateVertexBuffer();
     void        CreateIndexBuffer();
-    void        CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
     
     void        CreateDescriptorSetLayout();
     void        CreateUniformBuffers();
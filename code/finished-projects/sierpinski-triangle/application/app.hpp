@@ -10,40 +10,26 @@
 #include "deletion_queue.hpp"
 #include "shader_vertex.hpp"
 
-#define FRAME_OVERLAP 2
-
 namespace tlr
 {
 
 class App : public AppBase
 {
 public:
-    App(int fractalDepth);
+    App(const AppBaseCreateInfo& createInfo, int fractalDepth);
     ~App();
 
 protected:
     void Update() override;
 
 private:
-    struct FrameData
-    {
-        VkCommandPool   commandPool;
-        VkCommandBuffer mainCommandBuffer;
-        VkSemaphore     swapchainSemaphore, renderSemaphore;
-        VkFence         renderFence;
-    }   _frames[FRAME_OVERLAP];
-    int _frameNumber = 0;
-
     VkPipelineLayout _pipelineLayout;
     VkBuffer         _vertexBuffer;
     VkDeviceMemory   _vertexBufferMemory;
-    VkPipeline       _graphicsPipeline;
+    PipelineHandle   _graphicsPipeline;
 
     DeletionQueue _deleteQueue;
 
-    FrameData& GetCurrentFrameData();
-    void       InitCommands();
-    void       InitSyncStructures();
     void       CreateVertexBuffer();
     uint32_t   FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
     void       CreateGraphicsPipeline();
@@ -1,11 +1,11 @@
 #include "app.hpp"
 
-int main()
+int main(int argc, char* argv[])
 {
     try
     {
         int fractalDepth = 5;
-        tlr::App app(fractalDepth);
+        tlr::App app(tlr::ParseCommandLine(argc, argv), fractalDepth);
         app.Run();
     }
     catch(const std::exception& e)
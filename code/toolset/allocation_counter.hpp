@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace tlr
+{
+
+struct AllocationStats
+{
+    uint64_t count;
+    uint64_t bytes;
+};
+
+// Counts every global operator new since startup. Linking the AllocationCounter target replaces the global
+// operators for the whole executable, which costs one relaxed atomic add per allocation.
+AllocationStats GetAllocationStats();
+
+} // namespace tlr
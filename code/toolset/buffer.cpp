@@ -25,6 +25,16 @@ namespace tlr
 */
 VkResult Buffer::Map(VkDeviceSize size, VkDeviceSize offset)
 {
+	if (allocation.allocator)
+	{
+		// Sub-allocated blocks are mapped once by the allocator, a second vkMapMemory on them would fail
+		if (!allocation.mapped)
+		{
+			return VK_ERROR_MEMORY_MAP_FAILED;
+		}
+		mapped = static_cast<char*>(allocation.mapped) + offset;
+		return VK_SUCCESS;
+	}
 	return vkMapMemory(device, memory, offset, size, 0, &mapped);
 }
 
@@ -37,7 +47,10 @@ void Buffer::Unmap()
 {
 	if (mapped)
 	{
-		vkUnmapMemory(device, memory);
+		if (!allocation.allocator)
+		{
+			vkUnmapMemory(device, memory);
+		}
 		mapped = nullptr;
 	}
 }
@@ -51,7 +64,7 @@ void Buffer::Unmap()
 */
 VkResult Buffer::Bind(VkDeviceSize offset)
 {
-	return vkBindBufferMemory(device, buffer, memory, offset);
+	return vkBindBufferMemory(device, buffer, memory, allocation.offset + offset);
 }
 
 /**
@@ -96,8 +109,8 @@ VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset)
 	VkMappedMemoryRange mappedRange = {};
 	mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
 	mappedRange.memory = memory;
-	mappedRange.offset = offset;
-	mappedRange.size = size;
+	mappedRange.offset = allocation.offset + offset;
+	mappedRange.size = (allocation.allocator && size == VK_WHOLE_SIZE) ? allocation.size - offset : size;
 	return vkFlushMappedMemoryRanges(device, 1, &mappedRange);
 }
 
@@ -116,8 +129,8 @@ VkResult Buffer::Invalidate(VkDeviceSize size, VkDeviceSize offset)
 	VkMappedMemoryRange mappedRange = {};
 	mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
 	mappedRange.memory = memory;
-	mappedRange.offset = offset;
-	mappedRange.size = size;
+	mappedRange.offset = allocation.offset + offset;
+	mappedRange.size = (allocation.allocator && size == VK_WHOLE_SIZE) ? allocation.size - offset : size;
 	return vkInvalidateMappedMemoryRanges(device, 1, &mappedRange);
 }
 
@@ -126,16 +139,17 @@ VkResult Buffer::Invalidate(VkDeviceSize size, VkDeviceSize offset)
 */
 void Buffer::Destroy()
 {
-	if (mapped)
-	{
-		vkUnmapMemory(device, memory);
-		mapped = nullptr;
-	}
+	Unmap();
 	if (buffer)
 	{
 		vkDestroyBuffer(device, buffer, nullptr);
 	}
-	if (memory)
+	if (allocation.allocator)
+	{
+		allocation.allocator->Free(allocation);
+		memory = VK_NULL_HANDLE;
+	}
+	else if (memory)
 	{
 		vkFreeMemory(device, memory, nullptr);
 	}
@@ -15,6 +15,7 @@
 #include <vulkan/vulkan.h>
 
 #include "toolset.hpp"
+#include "gpu_allocator.hpp"
 
 namespace tlr
 {
@@ -30,6 +31,7 @@ struct Buffer
 	void* 				   mapped = nullptr;
 	VkBufferUsageFlags 	   usageFlags;
 	VkMemoryPropertyFlags  memoryPropertyFlags;
+	GpuAllocation          allocation;     // set when memory is a sub-allocation, offsets below are relative to it
 	
 	VkResult Map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
 	void 	 Unmap();
@@ -0,0 +1,187 @@
+#include "cpu_profiler.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace tlr
+{
+
+CpuProfiler::CpuProfiler() : _startTime(std::chrono::steady_clock::now()) {}
+
+CpuProfiler* CpuProfiler::GetInstance()
+{
+    static CpuProfiler instance;
+    return &instance;
+}
+
+void CpuProfiler::Enable()
+{
+    _isEnabled.store(true, std::memory_order_relaxed);
+}
+
+void CpuProfiler::Disable()
+{
+    _isEnabled.store(false, std::memory_order_relaxed);
+}
+
+bool CpuProfiler::IsEnabled() const
+{
+    return _isEnabled.load(std::memory_order_relaxed);
+}
+
+int64_t CpuProfiler::Now() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _startTime).count();
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::GetThreadBuffer()
+{
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+
+    if (threadBuffer == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(_registrationMutex);
+        _threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+        threadBuffer = _threadBuffers.back().get();
+        threadBuffer->threadId = static_cast<uint32_t>(_threadBuffers.size() - 1);
+    }
+
+    return *threadBuffer;
+}
+
+void CpuProfiler::SetThreadName(const std::string& name)
+{
+    ThreadBuffer& threadBuffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(_registrationMutex);
+    threadBuffer.threadName = name;
+}
+
+void CpuProfiler::RegisterThread()
+{
+    GetThreadBuffer();
+}
+
+void CpuProfiler::Record(const char* name, int64_t beginNanoseconds, int64_t endNanoseconds)
+{
+    ThreadBuffer& threadBuffer = GetThreadBuffer();
+    EventChunk* chunk = &threadBuffer.chunks[threadBuffer.chunkIndex % CHUNKS_PER_THREAD];
+
+    uint32_t eventCount = chunk->eventCount.load(std::memory_order_relaxed);
+    if (eventCount == EVENTS_PER_CHUNK)
+    {
+        // Reuses the oldest chunk once the ring is full, memory stays bounded however long the run.
+        std::lock_guard<std::mutex> lock(threadBuffer.recycleMutex);
+        ++threadBuffer.chunkIndex;
+        chunk = &threadBuffer.chunks[threadBuffer.chunkIndex % CHUNKS_PER_THREAD];
+        chunk->eventCount.store(0, std::memory_order_relaxed);
+        eventCount = 0;
+    }
+
+    chunk->events[eventCount] = {name, beginNanoseconds, endNanoseconds};
+    chunk->eventCount.store(eventCount + 1, std::memory_order_release);
+}
+
+template <typename F>
+void CpuProfiler::ForEachEvent(ThreadBuffer& threadBuffer, F&& f)
+{
+    std::lock_guard<std::mutex> lock(threadBuffer.recycleMutex);
+    uint64_t last = threadBuffer.chunkIndex;
+    uint64_t first = last >= CHUNKS_PER_THREAD ? last - CHUNKS_PER_THREAD + 1 : 0;
+    for (uint64_t i = first; i <= last; ++i)
+    {
+        const EventChunk& chunk = threadBuffer.chunks[i % CHUNKS_PER_THREAD];
+        uint32_t eventCount = chunk.eventCount.load(std::memory_order_acquire);
+        for (uint32_t j = 0; j < eventCount; ++j)
+        {
+            f(chunk.events[j]);
+        }
+    }
+}
+
+void CpuProfiler::WriteChromeTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open cpu profile file!");
+    }
+
+    std::lock_guard<std::mutex> lock(_registrationMutex);
+
+    // Chrome trace timestamps are in microseconds.
+    file << std::fixed << std::setprecision(3);
+    file << "{\n\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n";
+
+    bool isFirstEvent = true;
+    for (const auto& threadBuffer : _threadBuffers)
+    {
+        std::string threadName = threadBuffer->threadName.empty() ? "Thread " + std::to_string(threadBuffer->threadId) : threadBuffer->threadName;
+        file << (isFirstEvent ? "" : ",\n")
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << threadBuffer->threadId
+             << ", \"args\": {\"name\": \"" << threadName << "\"}}";
+        isFirstEvent = false;
+
+        ForEachEvent(*threadBuffer, [&](const ScopeEvent& event)
+        {
+            file << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << threadBuffer->threadId
+                 << ", \"ts\": " << event.beginNanoseconds / 1000.0 << ", \"dur\": " << (event.endNanoseconds - event.beginNanoseconds) / 1000.0 << "}";
+        });
+    }
+
+    file << "\n]\n}\n";
+}
+
+std::vector<CpuScopeSummary> CpuProfiler::Summarize(int64_t sinceNanoseconds)
+{
+    std::vector<CpuScopeSummary> summaries;
+    std::unordered_map<std::string, size_t> summaryIndices;
+
+    std::lock_guard<std::mutex> lock(_registrationMutex);
+    for (const auto& threadBuffer : _threadBuffers)
+    {
+        ForEachEvent(*threadBuffer, [&](const ScopeEvent& event)
+        {
+            if (event.beginNanoseconds < sinceNanoseconds)
+            {
+                return;
+            }
+
+            auto it = summaryIndices.find(event.name);
+            if (it == summaryIndices.end())
+            {
+                it = summaryIndices.emplace(event.name, summaries.size()).first;
+                summaries.push_back({event.name, 0, 0.0});
+            }
+
+            CpuScopeSummary& summary = summaries[it->second];
+            ++summary.callCount;
+            summary.totalMilliseconds += (event.endNanoseconds - event.beginNanoseconds) / 1e6;
+        });
+    }
+
+    return summaries;
+}
+
+CpuProfileScope::CpuProfileScope(const char* name) : _name(nullptr), _beginNanoseconds(0)
+{
+    CpuProfiler* profiler = CpuProfiler::GetInstance();
+    if (profiler->IsEnabled())
+    {
+        profiler->RegisterThread();
+        _name = name;
+        _beginNanoseconds = profiler->Now();
+    }
+}
+
+CpuProfileScope::~CpuProfileScope()
+{
+    if (_name != nullptr)
+    {
+        CpuProfiler* profiler = CpuProfiler::GetInstance();
+        profiler->Record(_name, _beginNanoseconds, profiler->Now());
+    }
+}
+
+} // namespace tlr
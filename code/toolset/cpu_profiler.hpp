@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define CPU_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_IMPL(a, b)
+#define CPU_PROFILE_SCOPE(name) tlr::CpuProfileScope CPU_PROFILE_CONCAT(cpuProfileScope, __LINE__)(name)
+#define CPU_PROFILE_FUNCTION() CPU_PROFILE_SCOPE(__func__)
+
+namespace tlr
+{
+
+struct CpuScopeSummary
+{
+    std::string name;
+    uint64_t    callCount;
+    double      totalMilliseconds;
+};
+
+class CpuProfiler
+{
+public:
+    CpuProfiler(const CpuProfiler&) = delete;
+    CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+    static CpuProfiler* GetInstance();
+
+    void Enable();
+    void Disable();
+    bool IsEnabled() const;
+
+    // Names the calling thread in the exported trace.
+    void SetThreadName(const std::string& name);
+
+    // Events are only appended by their owner thread, so this is safe while other threads keep recording,
+    // it just won't see events that are published after it started.
+    void WriteChromeTrace(const std::string& path);
+
+    // Totals per scope name over every thread, counting only scopes that began at or after the given time.
+    std::vector<CpuScopeSummary> Summarize(int64_t sinceNanoseconds = 0);
+
+    // Allocates the calling thread's events up front, scopes call it before taking their begin time so the
+    // allocation never shows up inside a measured scope.
+    void RegisterThread();
+    // Names have to outlive the profiler, string literals and __func__ are fine.
+    void Record(const char* name, int64_t beginNanoseconds, int64_t endNanoseconds);
+    int64_t Now() const;
+
+private:
+    // Every thread keeps its last EVENTS_PER_CHUNK * CHUNKS_PER_THREAD events, older ones are overwritten.
+    static constexpr uint32_t EVENTS_PER_CHUNK = 4096;
+    static constexpr uint32_t CHUNKS_PER_THREAD = 16;
+
+    struct ScopeEvent
+    {
+        const char* name;
+        int64_t     beginNanoseconds;
+        int64_t     endNanoseconds;
+    };
+
+    struct EventChunk
+    {
+        ScopeEvent            events[EVENTS_PER_CHUNK];
+        std::atomic<uint32_t> eventCount{0};
+    };
+
+    // Only the owner thread appends, readers walk the chunks up to the published counts. The chunks form a ring,
+    // moving on to the next one takes recycleMutex, so a reader holding it never sees a chunk being reused.
+    struct ThreadBuffer
+    {
+        uint32_t                      threadId;
+        std::string                   threadName;
+        std::unique_ptr<EventChunk[]> chunks{new EventChunk[CHUNKS_PER_THREAD]};
+        uint64_t                      chunkIndex = 0; // chunks filled so far, the current one is chunkIndex % CHUNKS_PER_THREAD
+        std::mutex                    recycleMutex;
+    };
+
+    std::atomic<bool>                          _isEnabled{false};
+    std::chrono::steady_clock::time_point      _startTime;
+    std::mutex                                 _registrationMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> _threadBuffers;
+
+    CpuProfiler();
+
+    ThreadBuffer& GetThreadBuffer();
+
+    // f(const ScopeEvent& event) from the oldest event the ring still holds to the newest.
+    template <typename F>
+    static void ForEachEvent(ThreadBuffer& threadBuffer, F&& f);
+};
+
+class CpuProfileScope
+{
+public:
+    CpuProfileScope(const char* name);
+    ~CpuProfileScope();
+
+    CpuProfileScope(const CpuProfileScope&) = delete;
+    CpuProfileScope& operator=(const CpuProfileScope&) = delete;
+
+private:
+    const char* _name;
+    int64_t     _beginNanoseconds;
+};
+
+} // namespace tlr
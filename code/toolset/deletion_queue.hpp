@@ -10,30 +10,145 @@
 
 #pragma once
 
-#include <functional>
-#include <deque>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace tlr
 {
-    
-struct DeletionQueue
+
+// Deleters are placement constructed into fixed size blocks that are kept across flushes, so a queue that is filled
+// and flushed every frame stops allocating once it reached its peak size. Closures too big for a block go to the heap.
+class DeletionQueue
 {
-	std::deque<std::function<void()>> deletors;
+public:
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    DeletionQueue() = default;
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+    // Blocks are owned through pointers, moving the queue leaves the stored closures where they are.
+    DeletionQueue(DeletionQueue&& other) noexcept :
+        _blocks(std::move(other._blocks)),
+        _entries(std::move(other._entries)),
+        _blockIndex(other._blockIndex),
+        _blockOffset(other._blockOffset)
+    {
+        other._entries.clear();
+        other._blockIndex = 0;
+        other._blockOffset = 0;
+    }
+
+    DeletionQueue& operator=(DeletionQueue&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Clear();
+            _blocks = std::move(other._blocks);
+            _entries = std::move(other._entries);
+            _blockIndex = other._blockIndex;
+            _blockOffset = other._blockOffset;
+            other._entries.clear();
+            other._blockIndex = 0;
+            other._blockOffset = 0;
+        }
+        return *this;
+    }
 
-	void PushFunction(std::function<void()>&& function)
+    // Dropping a queue that still holds deleters leaks the objects they would have destroyed, only the closures go.
+    ~DeletionQueue()
     {
-		deletors.push_back(std::move(function));
-	}
+        Clear();
+    }
 
-	void Flush()
+    template <typename F>
+    void PushFunction(F&& function)
     {
-		for (auto it = deletors.rbegin(); it != deletors.rend(); it++)
-		{
-			(*it)();
-		}
+        using Fn = std::decay_t<F>;
+        static_assert(std::is_invocable_v<Fn&>, "deleters take no arguments!");
 
-		deletors.clear();
-	}
+        if constexpr (sizeof(Fn) <= BLOCK_SIZE && alignof(Fn) <= alignof(std::max_align_t))
+        {
+            void* storage = Allocate(sizeof(Fn), alignof(Fn));
+            Fn* fn = new (storage) Fn(std::forward<F>(function));
+            _entries.push_back({fn, [](void* p) { (*static_cast<Fn*>(p))(); }, [](void* p) { static_cast<Fn*>(p)->~Fn(); }});
+        }
+        else
+        {
+            Fn* fn = new Fn(std::forward<F>(function));
+            _entries.push_back({fn, [](void* p) { (*static_cast<Fn*>(p))(); }, [](void* p) { delete static_cast<Fn*>(p); }});
+        }
+    }
+
+    // Runs the deleters newest first, so objects go in the reverse order of their creation.
+    void Flush()
+    {
+        for (auto it = _entries.rbegin(); it != _entries.rend(); ++it)
+        {
+            it->invoke(it->function);
+            it->destroy(it->function);
+        }
+        Reset();
+    }
+
+    bool   IsEmpty()  const { return _entries.empty(); }
+    size_t GetCount() const { return _entries.size(); }
+
+private:
+    struct Block
+    {
+        alignas(std::max_align_t) unsigned char bytes[BLOCK_SIZE];
+    };
+
+    struct Entry
+    {
+        void* function;
+        void  (*invoke)(void*);
+        void  (*destroy)(void*);
+    };
+
+    std::vector<std::unique_ptr<Block>> _blocks;
+    std::vector<Entry>                  _entries;
+    size_t                              _blockIndex = 0;
+    size_t                              _blockOffset = 0;
+
+    void* Allocate(size_t size, size_t alignment)
+    {
+        size_t offset = (_blockOffset + alignment - 1) & ~(alignment - 1);
+        if (_blockIndex < _blocks.size() && offset + size > BLOCK_SIZE)
+        {
+            ++_blockIndex;
+            offset = 0;
+        }
+        if (_blockIndex == _blocks.size())
+        {
+            _blocks.push_back(std::make_unique<Block>());
+            offset = 0;
+        }
+
+        _blockOffset = offset + size;
+        return _blocks[_blockIndex]->bytes + offset;
+    }
+
+    void Clear()
+    {
+        for (auto it = _entries.rbegin(); it != _entries.rend(); ++it)
+        {
+            it->destroy(it->function);
+        }
+        Reset();
+    }
+
+    void Reset()
+    {
+        _entries.clear();
+        _blockIndex = 0;
+        _blockOffset = 0;
+    }
 };
 
 } // namespace tlr
\ No newline at end of file
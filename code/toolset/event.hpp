@@ -1,89 +1,288 @@
 #pragma once
 
-#include <unordered_set>
-#include <unordered_map>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace tlr
 {
 
-template<typename T>
-class FunctionWrapper;
+// Returned by Event::Add, removing a listener needs it since two lambdas can't be told apart by their type.
+struct EventHandle
+{
+    static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+    uint32_t slot = INVALID_SLOT;
+    uint32_t generation = 0;
+
+    bool IsValid() const
+    {
+        return slot != INVALID_SLOT;
+    }
+};
 
-template<typename R, typename... Args>
-class FunctionWrapper<R(Args...)>
+// Listeners live in one contiguous array, so raising an event is a linear loop over it. Small closures are stored
+// inline, only ones that don't fit INLINE_SIZE allocate. Handles point into a slot table that follows the listeners
+// around, removal swaps the last listener into the hole.
+template <typename... Args>
+class Event
 {
 public:
-    FunctionWrapper() = default;
+    static constexpr size_t INLINE_SIZE = 4 * sizeof(void*);
 
-    FunctionWrapper(std::function<R(Args...)>&& func) : _func(std::move(func)) {}
+    Event() = default;
 
-    bool operator==(const FunctionWrapper<R(Args...)>& other) const
+    template <typename F>
+    EventHandle Add(F&& listener)
     {
-        return _func.target_type() == other._func.target_type();
+        static_assert(std::is_invocable_v<std::decay_t<F>&, Args...>, "listener can't be called with the event's arguments!");
+
+        uint32_t slot = AcquireSlot();
+        if (_raiseDepth == 0)
+        {
+            _slots[slot].index = static_cast<uint32_t>(_delegates.size());
+            _delegates.emplace_back(std::forward<F>(listener), slot);
+        }
+        else
+        {
+            // Growing the array now could move the listener that is running, new ones join after the dispatch.
+            _slots[slot].index = PENDING_BIT | static_cast<uint32_t>(_pending.size());
+            _pending.emplace_back(std::forward<F>(listener), slot);
+            _hasDeferredChanges = true;
+        }
+        return {slot, _slots[slot].generation};
     }
 
-    template<typename... ArgsAlias>
-    R operator()(ArgsAlias&&... args) const
+    // Returns false for handles that were already removed. A listener may remove itself while it's being raised.
+    bool Remove(EventHandle handle)
     {
-        return _func(std::forward<ArgsAlias>(args)...);
+        if (!IsAlive(handle))
+        {
+            return false;
+        }
+
+        uint32_t index = _slots[handle.slot].index;
+        ReleaseSlot(handle.slot);
+
+        if (index & PENDING_BIT)
+        {
+            _pending[index & ~PENDING_BIT].slot = EventHandle::INVALID_SLOT;
+        }
+        else if (_raiseDepth > 0)
+        {
+            _delegates[index].slot = EventHandle::INVALID_SLOT;
+            _hasDeferredChanges = true;
+        }
+        else
+        {
+            EraseDelegate(index);
+        }
+        return true;
     }
 
-    std::size_t hash() const
+    template <typename F>
+    EventHandle operator+=(F&& listener)
     {
-        return _func.target_type().hash_code();
+        return Add(std::forward<F>(listener));
     }
 
-private:
-    std::function<R(Args...)> _func;
-};
+    bool operator-=(EventHandle handle)
+    {
+        return Remove(handle);
+    }
 
-} // namespace tlr
+    template<typename... ArgsAlias>
+    void Raise(ArgsAlias&&... args)
+    {
+        ++_raiseDepth;
+        for (size_t i = 0; i < _delegates.size(); ++i)
+        {
+            if (_delegates[i].slot != EventHandle::INVALID_SLOT)
+            {
+                _delegates[i](args...);
+            }
+        }
+        if (--_raiseDepth == 0 && _hasDeferredChanges)
+        {
+            ApplyDeferredChanges();
+        }
+    }
 
-namespace std
-{
+    bool IsAlive(EventHandle handle) const
+    {
+        return handle.slot < _slots.size() && _slots[handle.slot].generation == handle.generation;
+    }
 
-template<typename R, typename... Args>
-struct hash<tlr::FunctionWrapper<R(Args...)>>
-{
-    std::size_t operator()(const tlr::FunctionWrapper<R(Args...)>& wrapper) const
+    size_t GetListenerCount() const
     {
-        return wrapper.hash();
+        return _delegates.size() + _pending.size();
     }
-};
 
-} // namespace std
+private:
+    static constexpr uint32_t PENDING_BIT = 1u << 31;
 
-namespace tlr
-{
+    class Delegate
+    {
+    public:
+        uint32_t slot; // back-reference into the slot table, invalid once removed
 
-template <typename... Args>
-class Event
-{
-public:
-    Event() = default;
+        template <typename F>
+        Delegate(F&& function, uint32_t slot) : slot(slot)
+        {
+            using Fn = std::decay_t<F>;
+            if constexpr (sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>)
+            {
+                new (_storage) Fn(std::forward<F>(function));
+                _invoke = [](void* storage, Args... args) { (*static_cast<Fn*>(storage))(args...); };
+                _relocate = [](void* storage, void* target)
+                {
+                    Fn* fn = static_cast<Fn*>(storage);
+                    if (target)
+                    {
+                        new (target) Fn(std::move(*fn));
+                    }
+                    fn->~Fn();
+                };
+            }
+            else
+            {
+                new (_storage) Fn*(new Fn(std::forward<F>(function)));
+                _invoke = [](void* storage, Args... args) { (**static_cast<Fn**>(storage))(args...); };
+                _relocate = [](void* storage, void* target)
+                {
+                    Fn* fn = *static_cast<Fn**>(storage);
+                    if (target)
+                    {
+                        new (target) Fn*(fn);
+                    }
+                    else
+                    {
+                        delete fn;
+                    }
+                };
+            }
+        }
+
+        Delegate(Delegate&& other) noexcept : slot(other.slot), _invoke(other._invoke), _relocate(other._relocate)
+        {
+            _relocate(other._storage, _storage);
+            other._relocate = nullptr;
+        }
+
+        Delegate& operator=(Delegate&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                slot = other.slot;
+                _invoke = other._invoke;
+                _relocate = other._relocate;
+                _relocate(other._storage, _storage);
+                other._relocate = nullptr;
+            }
+            return *this;
+        }
+
+        Delegate(const Delegate&) = delete;
+        Delegate& operator=(const Delegate&) = delete;
+
+        ~Delegate()
+        {
+            Reset();
+        }
+
+        void operator()(Args... args)
+        {
+            _invoke(_storage, args...);
+        }
+
+    private:
+        alignas(std::max_align_t) unsigned char _storage[INLINE_SIZE];
+        void (*_invoke)(void*, Args...);
+        void (*_relocate)(void*, void*); // moves into the target and destroys the source, a null target only destroys
+
+        void Reset()
+        {
+            if (_relocate)
+            {
+                _relocate(_storage, nullptr);
+                _relocate = nullptr;
+            }
+        }
+    };
 
-    void operator+=(std::function<void(Args...)>&& listener)
+    struct Slot
     {
-        _listeners.insert(FunctionWrapper<void(Args...)>(std::move(listener)));
+        uint32_t index;      // into the delegates, or into the pending ones with PENDING_BIT set
+        uint32_t generation; // bumped on removal so stale handles stop matching
+    };
+
+    std::vector<Delegate> _delegates;
+    std::vector<Delegate> _pending;
+    std::vector<Slot>     _slots;
+    std::vector<uint32_t> _freeSlots;
+    uint32_t              _raiseDepth = 0;
+    bool                  _hasDeferredChanges = false;
+
+    uint32_t AcquireSlot()
+    {
+        if (!_freeSlots.empty())
+        {
+            uint32_t slot = _freeSlots.back();
+            _freeSlots.pop_back();
+            return slot;
+        }
+        _slots.push_back({0, 0});
+        return static_cast<uint32_t>(_slots.size() - 1);
     }
 
-    void operator-=(std::function<void(Args...)>&& listener)
+    void ReleaseSlot(uint32_t slot)
     {
-        _listeners.erase(FunctionWrapper<void(Args...)>(std::move(listener)));
+        ++_slots[slot].generation;
+        _freeSlots.push_back(slot);
     }
 
-    template<typename... ArgsAlias>
-    void Raise(ArgsAlias&&... args)
+    void EraseDelegate(size_t index)
     {
-        for (auto& listener : _listeners)
+        if (index + 1 != _delegates.size())
         {
-            listener(std::forward<ArgsAlias>(args)...);
+            _delegates[index] = std::move(_delegates.back());
+            if (_delegates[index].slot != EventHandle::INVALID_SLOT)
+            {
+                _slots[_delegates[index].slot].index = static_cast<uint32_t>(index);
+            }
         }
+        _delegates.pop_back();
     }
 
-private:
-    std::unordered_set<FunctionWrapper<void(Args...)>> _listeners;
+    void ApplyDeferredChanges()
+    {
+        for (size_t i = 0; i < _delegates.size();)
+        {
+            if (_delegates[i].slot == EventHandle::INVALID_SLOT)
+            {
+                EraseDelegate(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        for (Delegate& delegate : _pending)
+        {
+            if (delegate.slot != EventHandle::INVALID_SLOT)
+            {
+                _slots[delegate.slot].index = static_cast<uint32_t>(_delegates.size());
+                _delegates.push_back(std::move(delegate));
+            }
+        }
+        _pending.clear();
+        _hasDeferredChanges = false;
+    }
 };
 
-} // namespace tlr
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,437 @@
+#include "gpu_allocator.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include "toolset.hpp"
+
+namespace tlr
+{
+
+namespace
+{
+
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+void GpuAllocator::Init(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize)
+{
+    _device = device;
+    _blockSize = blockSize;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &_memoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    _nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+    _pools.resize(_memoryProperties.memoryTypeCount * 2);
+    for (uint32_t i = 0; i < _pools.size(); ++i)
+    {
+        _pools[i].memoryTypeIndex = i / 2;
+    }
+}
+
+void GpuAllocator::Destroy()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t leakedCount = 0;
+    for (Pool& pool : _pools)
+    {
+        for (Block& block : pool.blocks)
+        {
+            if (block.memory != VK_NULL_HANDLE)
+            {
+                leakedCount += block.allocationCount;
+                FreeBlock(block);
+            }
+        }
+        leakedCount += pool.dedicatedCount;
+    }
+    for (LinearPool& linearPool : _linearPools)
+    {
+        FreeBlock(linearPool.block);
+    }
+    _pools.clear();
+    _linearPools.clear();
+
+    if (leakedCount > 0)
+    {
+        std::cerr << "GPU allocator destroyed with " << leakedCount << " live allocations!" << std::endl;
+    }
+}
+
+GpuAllocation GpuAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, GpuResourceKind kind)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties);
+    VkDeviceSize size = requirements.size;
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+    if (IsNonCoherent(memoryTypeIndex))
+    {
+        // Flushes work on whole atoms, so neighbours must never share one.
+        alignment = AlignUp(alignment, _nonCoherentAtomSize);
+        size = AlignUp(size, _nonCoherentAtomSize);
+    }
+
+    GpuAllocation allocation{};
+    allocation.allocator = this;
+    allocation.size = size;
+    allocation.poolIndex = memoryTypeIndex * 2 + (kind == GpuResourceKind::Image ? 1 : 0);
+    Pool& pool = _pools[allocation.poolIndex];
+
+    VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+    if (size > blockSize / 2)
+    {
+        // Large resources would only leave unusable holes behind, they get their own memory.
+        Block block = AllocateBlock(memoryTypeIndex, size);
+        allocation.memory = block.memory;
+        allocation.mapped = block.mapped;
+        allocation.isDedicated = true;
+        ++pool.dedicatedCount;
+        pool.dedicatedBytes += size;
+        TrackUsage(size, 0);
+        return allocation;
+    }
+
+    uint32_t emptySlot = static_cast<uint32_t>(pool.blocks.size());
+    for (uint32_t i = 0; i < pool.blocks.size(); ++i)
+    {
+        Block& block = pool.blocks[i];
+        if (block.memory == VK_NULL_HANDLE)
+        {
+            emptySlot = std::min(emptySlot, i);
+            continue;
+        }
+        if (TryAllocateFromBlock(block, size, alignment, allocation.offset))
+        {
+            allocation.memory = block.memory;
+            allocation.blockIndex = i;
+            allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + allocation.offset : nullptr;
+            TrackUsage(size, 0);
+            return allocation;
+        }
+    }
+
+    if (emptySlot == pool.blocks.size())
+    {
+        pool.blocks.emplace_back();
+    }
+    Block& block = pool.blocks[emptySlot];
+    block = AllocateBlock(memoryTypeIndex, blockSize);
+    block.freeRanges[0] = blockSize;
+    TryAllocateFromBlock(block, size, alignment, allocation.offset);
+
+    allocation.memory = block.memory;
+    allocation.blockIndex = emptySlot;
+    allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + allocation.offset : nullptr;
+    TrackUsage(size, 0);
+    return allocation;
+}
+
+void GpuAllocator::Free(GpuAllocation& allocation)
+{
+    if (allocation.allocator == nullptr || allocation.isLinear)
+    {
+        allocation = GpuAllocation{};
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Pool& pool = _pools[allocation.poolIndex];
+    TrackUsage(0, allocation.size);
+    if (allocation.isDedicated)
+    {
+        vkFreeMemory(_device, allocation.memory, nullptr);
+        --_deviceMemoryCount;
+        --pool.dedicatedCount;
+        pool.dedicatedBytes -= allocation.size;
+        allocation = GpuAllocation{};
+        return;
+    }
+
+    Block& block = pool.blocks[allocation.blockIndex];
+    FreeToBlock(block, allocation.offset, allocation.size);
+    --block.allocationCount;
+
+    // One empty block per pool is kept around so a single create/destroy pair doesn't thrash vkAllocateMemory.
+    if (block.allocationCount == 0)
+    {
+        bool hasOtherBlock = std::any_of(pool.blocks.begin(), pool.blocks.end(), [&block](const Block& other) {
+            return &other != &block && other.memory != VK_NULL_HANDLE;
+        });
+        if (hasOtherBlock)
+        {
+            FreeBlock(block);
+        }
+    }
+
+    allocation = GpuAllocation{};
+}
+
+uint32_t GpuAllocator::CreateLinearPool(VkDeviceSize size, uint32_t memoryTypeBits, VkMemoryPropertyFlags properties)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    LinearPool linearPool{};
+    linearPool.memoryTypeIndex = FindMemoryType(memoryTypeBits, properties);
+    linearPool.block = AllocateBlock(linearPool.memoryTypeIndex, AlignUp(size, _nonCoherentAtomSize));
+    _linearPools.push_back(linearPool);
+    return static_cast<uint32_t>(_linearPools.size() - 1);
+}
+
+GpuAllocation GpuAllocator::AllocateLinear(uint32_t linearPool, const VkMemoryRequirements& requirements)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    LinearPool& pool = _linearPools[linearPool];
+    if ((requirements.memoryTypeBits & (1u << pool.memoryTypeIndex)) == 0)
+    {
+        throw std::runtime_error("resource can't live in the linear pool's memory type!");
+    }
+
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+    VkDeviceSize size = requirements.size;
+    if (IsNonCoherent(pool.memoryTypeIndex))
+    {
+        alignment = AlignUp(alignment, _nonCoherentAtomSize);
+        size = AlignUp(size, _nonCoherentAtomSize);
+    }
+
+    VkDeviceSize offset = AlignUp(pool.head, alignment);
+    if (offset + size > pool.block.size)
+    {
+        throw std::runtime_error("linear pool is out of memory!");
+    }
+    pool.head = offset + size;
+
+    GpuAllocation allocation{};
+    allocation.allocator = this;
+    allocation.memory = pool.block.memory;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.mapped = pool.block.mapped ? static_cast<char*>(pool.block.mapped) + offset : nullptr;
+    allocation.poolIndex = linearPool;
+    allocation.isLinear = true;
+    return allocation;
+}
+
+void GpuAllocator::ResetLinearPool(uint32_t linearPool)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _linearPools[linearPool].head = 0;
+}
+
+GpuAllocatorStats GpuAllocator::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    GpuAllocatorStats stats{};
+    stats.deviceMemoryCount = _deviceMemoryCount;
+    stats.peakDeviceMemoryCount = _peakDeviceMemoryCount;
+    stats.peakUsedBytes = _peakUsedBytes;
+    stats.memoryTypes.resize(_memoryProperties.memoryTypeCount);
+    for (uint32_t i = 0; i < _memoryProperties.memoryTypeCount; ++i)
+    {
+        stats.memoryTypes[i] = GpuMemoryTypeStats{};
+        stats.memoryTypes[i].memoryTypeIndex = i;
+    }
+
+    std::vector<VkDeviceSize> freeBytes(_memoryProperties.memoryTypeCount, 0);
+    for (const Pool& pool : _pools)
+    {
+        GpuMemoryTypeStats& typeStats = stats.memoryTypes[pool.memoryTypeIndex];
+        typeStats.dedicatedCount += pool.dedicatedCount;
+        typeStats.blockBytes += pool.dedicatedBytes;
+        typeStats.usedBytes += pool.dedicatedBytes;
+        for (const Block& block : pool.blocks)
+        {
+            if (block.memory == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+            VkDeviceSize blockFreeBytes = 0;
+            for (const auto& [offset, size] : block.freeRanges)
+            {
+                blockFreeBytes += size;
+                typeStats.largestFreeRange = std::max(typeStats.largestFreeRange, size);
+            }
+            ++typeStats.blockCount;
+            typeStats.allocationCount += block.allocationCount;
+            typeStats.blockBytes += block.size;
+            typeStats.usedBytes += block.size - blockFreeBytes;
+            typeStats.freeRangeCount += static_cast<uint32_t>(block.freeRanges.size());
+            freeBytes[pool.memoryTypeIndex] += blockFreeBytes;
+        }
+    }
+    for (const LinearPool& linearPool : _linearPools)
+    {
+        GpuMemoryTypeStats& typeStats = stats.memoryTypes[linearPool.memoryTypeIndex];
+        ++typeStats.blockCount;
+        typeStats.blockBytes += linearPool.block.size;
+        typeStats.usedBytes += linearPool.head;
+    }
+
+    for (GpuMemoryTypeStats& typeStats : stats.memoryTypes)
+    {
+        VkDeviceSize typeFreeBytes = freeBytes[typeStats.memoryTypeIndex];
+        typeStats.fragmentation = typeFreeBytes > 0 ? 1.0f - static_cast<float>(typeStats.largestFreeRange) / static_cast<float>(typeFreeBytes) : 0.0f;
+        stats.blockBytes += typeStats.blockBytes;
+        stats.usedBytes += typeStats.usedBytes;
+    }
+    return stats;
+}
+
+void GpuAllocator::PrintStats() const
+{
+    GpuAllocatorStats stats = GetStats();
+    constexpr double MEBIBYTE = 1024.0 * 1024.0;
+
+    std::cout << "GPU memory: " << stats.deviceMemoryCount << " device allocations, " << std::fixed << std::setprecision(2)
+              << stats.usedBytes / MEBIBYTE << " MiB used of " << stats.blockBytes / MEBIBYTE << " MiB, peak " << stats.peakDeviceMemoryCount
+              << " device allocations and " << stats.peakUsedBytes / MEBIBYTE << " MiB used" << std::endl;
+    for (const GpuMemoryTypeStats& typeStats : stats.memoryTypes)
+    {
+        if (typeStats.blockCount == 0 && typeStats.dedicatedCount == 0)
+        {
+            continue;
+        }
+        std::cout << "  type " << typeStats.memoryTypeIndex << ": " << typeStats.blockCount << " blocks, " << typeStats.dedicatedCount << " dedicated, "
+                  << typeStats.allocationCount << " allocations, " << typeStats.usedBytes / MEBIBYTE << "/" << typeStats.blockBytes / MEBIBYTE << " MiB, "
+                  << typeStats.freeRangeCount << " free ranges, fragmentation " << typeStats.fragmentation << std::endl;
+    }
+    std::cout << std::defaultfloat;
+}
+
+uint32_t GpuAllocator::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < _memoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeBits & (1u << i)) && (_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+bool GpuAllocator::IsNonCoherent(uint32_t memoryTypeIndex) const
+{
+    VkMemoryPropertyFlags flags = _memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    return (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+VkDeviceSize GpuAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+{
+    // Small heaps, like the 256 MiB host visible device local one, would be eaten up by a few blocks.
+    uint32_t heapIndex = _memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    VkDeviceSize heapSize = _memoryProperties.memoryHeaps[heapIndex].size;
+    return std::min(_blockSize, AlignUp(heapSize / 8, _nonCoherentAtomSize));
+}
+
+GpuAllocator::Block GpuAllocator::AllocateBlock(uint32_t memoryTypeIndex, VkDeviceSize size)
+{
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    Block block{};
+    block.size = size;
+    VK_CHECK_RESULT(vkAllocateMemory(_device, &allocInfo, nullptr, &block.memory));
+    ++_deviceMemoryCount;
+    _peakDeviceMemoryCount = std::max(_peakDeviceMemoryCount, _deviceMemoryCount);
+
+    if (_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        VK_CHECK_RESULT(vkMapMemory(_device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped));
+    }
+    return block;
+}
+
+void GpuAllocator::FreeBlock(Block& block)
+{
+    vkFreeMemory(_device, block.memory, nullptr);
+    --_deviceMemoryCount;
+    block = Block{};
+}
+
+void GpuAllocator::TrackUsage(VkDeviceSize allocatedBytes, VkDeviceSize freedBytes)
+{
+    _usedBytes = _usedBytes + allocatedBytes - freedBytes;
+    _peakUsedBytes = std::max(_peakUsedBytes, _usedBytes);
+}
+
+bool GpuAllocator::TryAllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+{
+    // Best fit, the range that leaves the least behind wins.
+    auto bestRange = block.freeRanges.end();
+    VkDeviceSize bestLeftover = 0;
+    for (auto range = block.freeRanges.begin(); range != block.freeRanges.end(); ++range)
+    {
+        VkDeviceSize alignedOffset = AlignUp(range->first, alignment);
+        VkDeviceSize rangeEnd = range->first + range->second;
+        if (alignedOffset + size > rangeEnd)
+        {
+            continue;
+        }
+        VkDeviceSize leftover = range->second - size;
+        if (bestRange == block.freeRanges.end() || leftover < bestLeftover)
+        {
+            bestRange = range;
+            bestLeftover = leftover;
+        }
+    }
+    if (bestRange == block.freeRanges.end())
+    {
+        return false;
+    }
+
+    VkDeviceSize rangeOffset = bestRange->first;
+    VkDeviceSize rangeEnd = rangeOffset + bestRange->second;
+    block.freeRanges.erase(bestRange);
+
+    offset = AlignUp(rangeOffset, alignment);
+    if (offset > rangeOffset)
+    {
+        block.freeRanges[rangeOffset] = offset - rangeOffset;
+    }
+    if (offset + size < rangeEnd)
+    {
+        block.freeRanges[offset + size] = rangeEnd - (offset + size);
+    }
+    ++block.allocationCount;
+    return true;
+}
+
+void GpuAllocator::FreeToBlock(Block& block, VkDeviceSize offset, VkDeviceSize size)
+{
+    auto next = block.freeRanges.lower_bound(offset);
+    if (next != block.freeRanges.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            block.freeRanges.erase(previous);
+        }
+    }
+    if (next != block.freeRanges.end() && offset + size == next->first)
+    {
+        size += next->second;
+        block.freeRanges.erase(next);
+    }
+    block.freeRanges[offset] = size;
+}
+
+} // namespace tlr
\ No newline at end of file
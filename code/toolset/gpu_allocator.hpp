@@ -0,0 +1,129 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace tlr
+{
+
+class GpuAllocator;
+
+// Buffers and optimal images live in separate blocks, so bufferImageGranularity never has to be respected.
+enum class GpuResourceKind
+{
+    Buffer,
+    Image
+};
+
+struct GpuAllocation
+{
+    GpuAllocator*  allocator = nullptr;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize   offset = 0;
+    VkDeviceSize   size = 0;
+    void*          mapped = nullptr; // points at offset, only set for host visible memory
+    uint32_t       poolIndex = 0;
+    uint32_t       blockIndex = 0;
+    bool           isDedicated = false;
+    bool           isLinear = false;
+};
+
+struct GpuMemoryTypeStats
+{
+    uint32_t     memoryTypeIndex;
+    uint32_t     blockCount;
+    uint32_t     allocationCount;
+    uint32_t     dedicatedCount;
+    VkDeviceSize blockBytes;
+    VkDeviceSize usedBytes;
+    uint32_t     freeRangeCount;
+    VkDeviceSize largestFreeRange;
+    float        fragmentation;   // 1 - largest free range / free bytes, 0 means the free space is one range
+};
+
+struct GpuAllocatorStats
+{
+    std::vector<GpuMemoryTypeStats> memoryTypes;
+    uint32_t                        deviceMemoryCount; // live vkAllocateMemory calls, capped by maxMemoryAllocationCount
+    uint32_t                        peakDeviceMemoryCount;
+    VkDeviceSize                    blockBytes;
+    VkDeviceSize                    usedBytes;
+    VkDeviceSize                    peakUsedBytes;     // linear pools not included
+};
+
+class GpuAllocator
+{
+public:
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+    GpuAllocator() = default;
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    void Init(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+    void Destroy();
+
+    // Host visible blocks stay mapped for their whole life, the allocation's mapped pointer is ready to use.
+    GpuAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, GpuResourceKind kind);
+    void          Free(GpuAllocation& allocation);
+
+    // Linear pools bump an offset through one block and are only released as a whole, meant for per-frame data.
+    uint32_t      CreateLinearPool(VkDeviceSize size, uint32_t memoryTypeBits, VkMemoryPropertyFlags properties);
+    GpuAllocation AllocateLinear(uint32_t linearPool, const VkMemoryRequirements& requirements);
+    void          ResetLinearPool(uint32_t linearPool);
+
+    GpuAllocatorStats GetStats() const;
+    void              PrintStats() const;
+
+private:
+    struct Block
+    {
+        VkDeviceMemory                         memory = VK_NULL_HANDLE;
+        VkDeviceSize                           size = 0;
+        void*                                  mapped = nullptr;
+        std::map<VkDeviceSize, VkDeviceSize>   freeRanges; // offset to size, neighbours are always merged
+        uint32_t                               allocationCount = 0;
+    };
+
+    struct Pool
+    {
+        uint32_t           memoryTypeIndex;
+        std::vector<Block> blocks; // emptied slots keep a null memory so block indices stay stable
+        uint32_t           dedicatedCount = 0;
+        VkDeviceSize       dedicatedBytes = 0;
+    };
+
+    struct LinearPool
+    {
+        uint32_t     memoryTypeIndex;
+        Block        block;
+        VkDeviceSize head = 0;
+    };
+
+    VkDevice                         _device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties _memoryProperties{};
+    VkDeviceSize                     _nonCoherentAtomSize = 1;
+    VkDeviceSize                     _blockSize = DEFAULT_BLOCK_SIZE;
+    std::vector<Pool>                _pools;       // two per memory type, see GpuResourceKind
+    std::vector<LinearPool>          _linearPools;
+    uint32_t                         _deviceMemoryCount = 0;
+    uint32_t                         _peakDeviceMemoryCount = 0;
+    VkDeviceSize                     _usedBytes = 0;
+    VkDeviceSize                     _peakUsedBytes = 0;
+    mutable std::mutex               _mutex;
+
+    uint32_t     FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+    bool         IsNonCoherent(uint32_t memoryTypeIndex) const;
+    VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+    Block        AllocateBlock(uint32_t memoryTypeIndex, VkDeviceSize size);
+    void         FreeBlock(Block& block);
+    void         TrackUsage(VkDeviceSize allocatedBytes, VkDeviceSize freedBytes);
+
+    static bool  TryAllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    static void  FreeToBlock(Block& block, VkDeviceSize offset, VkDeviceSize size);
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -29,14 +29,14 @@ namespace tlr
         return info;
     }
 
-    inline VkCommandBufferAllocateInfo CommandBufferAllocateInfo(VkCommandPool pool, uint32_t count = 1)
+    inline VkCommandBufferAllocateInfo CommandBufferAllocateInfo(VkCommandPool pool, uint32_t count = 1, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY)
     {
         VkCommandBufferAllocateInfo info{};
         info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         info.pNext = nullptr;
         info.commandPool = pool;
         info.commandBufferCount = count;
-        info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        info.level = level;
         return info;
     }
 
@@ -68,6 +68,17 @@ namespace tlr
         return info;
     }
 
+    inline VkCommandBufferInheritanceInfo CommandBufferInheritanceInfo(VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer)
+    {
+        VkCommandBufferInheritanceInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        info.pNext = nullptr;
+        info.renderPass = renderPass;
+        info.subpass = subpass;
+        info.framebuffer = framebuffer;
+        return info;
+    }
+
     inline VkPipelineShaderStageCreateInfo PipelineShaderStageCreateInfo(VkShaderStageFlagBits stage, VkShaderModule module)
     {
         VkPipelineShaderStageCreateInfo shaderStageInfo{};
@@ -0,0 +1,289 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tlr
+{
+
+namespace
+{
+
+size_t GetPageSize()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwPageSize);
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+} // namespace
+
+MappedFile::MappedFile(const std::string& path)
+{
+    if (!Open(path))
+    {
+        throw std::runtime_error("failed to open file!");
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+    _data(other._data),
+    _size(other._size),
+    _isOpen(other._isOpen),
+    _readahead(std::move(other._readahead))
+{
+#ifdef _WIN32
+    _file = other._file;
+    _mapping = other._mapping;
+    other._file = nullptr;
+    other._mapping = nullptr;
+#endif
+    other._data = nullptr;
+    other._size = 0;
+    other._isOpen = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        _data = other._data;
+        _size = other._size;
+        _isOpen = other._isOpen;
+        _readahead = std::move(other._readahead);
+#ifdef _WIN32
+        _file = other._file;
+        _mapping = other._mapping;
+        other._file = nullptr;
+        other._mapping = nullptr;
+#endif
+        other._data = nullptr;
+        other._size = 0;
+        other._isOpen = false;
+    }
+    return *this;
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // Empty files can't be mapped, they open as an empty view.
+    if (fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (data == nullptr)
+        {
+            if (mapping)
+            {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            return false;
+        }
+        _mapping = mapping;
+        _data = static_cast<const char*>(data);
+    }
+    _file = file;
+    _size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode))
+    {
+        close(fd);
+        return false;
+    }
+
+    // Empty files can't be mapped, they open as an empty view.
+    if (status.st_size > 0)
+    {
+        void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+        _data = static_cast<const char*>(data);
+    }
+    // The mapping keeps the file alive on its own.
+    close(fd);
+    _size = static_cast<size_t>(status.st_size);
+#endif
+
+    _isOpen = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    WaitReadahead();
+
+#ifdef _WIN32
+    if (_data)
+    {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping)
+    {
+        CloseHandle(_mapping);
+    }
+    if (_file)
+    {
+        CloseHandle(_file);
+    }
+    _mapping = nullptr;
+    _file = nullptr;
+#else
+    if (_data)
+    {
+        munmap(const_cast<char*>(_data), _size);
+    }
+#endif
+
+    _data = nullptr;
+    _size = 0;
+    _isOpen = false;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return _isOpen;
+}
+
+size_t MappedFile::GetSize() const
+{
+    return _size;
+}
+
+const char* MappedFile::GetData() const
+{
+    return _data;
+}
+
+FileView MappedFile::GetView() const
+{
+    return {_data, _size};
+}
+
+FileView MappedFile::GetView(size_t offset, size_t size) const
+{
+    if (offset > _size || size > _size - offset)
+    {
+        throw std::runtime_error("file view is out of range!");
+    }
+    return {_data + offset, size};
+}
+
+void MappedFile::Advise(FileAccess access) const
+{
+    Advise(access, GetView());
+}
+
+void MappedFile::Advise(FileAccess access, FileView view) const
+{
+    if (view.IsEmpty())
+    {
+        return;
+    }
+
+    // Both APIs want a page aligned start, widen the range down to the page the view begins in.
+    size_t pageSize = GetPageSize();
+    uintptr_t begin = reinterpret_cast<uintptr_t>(view.data) & ~(pageSize - 1);
+    size_t length = reinterpret_cast<uintptr_t>(view.data) + view.size - begin;
+
+#ifdef _WIN32
+    // Windows only has a prefetch hint, the access pattern ones have no equivalent for mapped views.
+    if (access == FileAccess::WILL_NEED || access == FileAccess::SEQUENTIAL)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = reinterpret_cast<void*>(begin);
+        range.NumberOfBytes = length;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    int advice = MADV_NORMAL;
+    switch (access)
+    {
+    case FileAccess::NORMAL:     advice = MADV_NORMAL;     break;
+    case FileAccess::SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+    case FileAccess::RANDOM:     advice = MADV_RANDOM;     break;
+    case FileAccess::WILL_NEED:  advice = MADV_WILLNEED;   break;
+    }
+    madvise(reinterpret_cast<void*>(begin), length, advice);
+#endif
+}
+
+void MappedFile::ReadaheadAsync()
+{
+    if (_size == 0 || _readahead.valid())
+    {
+        return;
+    }
+
+    const char* data = _data;
+    size_t size = _size;
+    size_t pageSize = GetPageSize();
+    _readahead = std::async(std::launch::async, [data, size, pageSize]()
+    {
+        // One read per page is enough to fault it in, the volatile keeps the loop from being optimized out.
+        volatile char sink = 0;
+        for (size_t offset = 0; offset < size; offset += pageSize)
+        {
+            sink = sink + data[offset];
+        }
+    });
+}
+
+void MappedFile::WaitReadahead()
+{
+    if (_readahead.valid())
+    {
+        _readahead.wait();
+        _readahead = {};
+    }
+}
+
+} // namespace tlr
\ No newline at end of file
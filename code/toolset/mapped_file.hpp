@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace tlr
+{
+
+// Read-only window into a mapped file. It doesn't own anything, so it must not outlive the MappedFile it came from.
+struct FileView
+{
+    const char* data = nullptr;
+    size_t      size = 0;
+
+    bool IsEmpty() const
+    {
+        return size == 0;
+    }
+
+    template <typename T>
+    const T* As() const
+    {
+        return reinterpret_cast<const T*>(data);
+    }
+
+    std::string_view AsString() const
+    {
+        return std::string_view(data, size);
+    }
+
+    // Clamped to the end of the view.
+    FileView Sub(size_t offset, size_t length = SIZE_MAX) const
+    {
+        if (offset >= size)
+        {
+            return {};
+        }
+        return {data + offset, length < size - offset ? length : size - offset};
+    }
+};
+
+// Lets std::istream based parsers read straight out of a view instead of a copy of the file.
+class FileViewStreamBuf : public std::streambuf
+{
+public:
+    explicit FileViewStreamBuf(FileView view)
+    {
+        char* begin = const_cast<char*>(view.data);
+        setg(begin, begin, begin + view.size);
+    }
+};
+
+enum class FileAccess
+{
+    NORMAL,
+    SEQUENTIAL, // read front to back once, e.g. parsing an OBJ
+    RANDOM,     // jumping around, e.g. a cache looked up by offset
+    WILL_NEED   // about to be read, start paging it in now
+};
+
+// Maps a whole file read-only. The mapping is page aligned, so SPIR-V and other word sized data can be used in place.
+// Pages are only read from disk when touched, Advise and ReadaheadAsync get them in ahead of the parser.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false if the file can't be opened or mapped, the constructor throws instead.
+    bool Open(const std::string& path);
+    void Close();
+
+    bool   IsOpen() const;
+    size_t GetSize() const;
+    const char* GetData() const;
+
+    FileView GetView() const;
+    FileView GetView(size_t offset, size_t size) const;
+
+    // Hints only, failures are ignored.
+    void Advise(FileAccess access) const;
+    void Advise(FileAccess access, FileView view) const;
+
+    // Touches every page on a worker thread so the caller's reads don't stall on disk. Waited for on Close.
+    void ReadaheadAsync();
+    void WaitReadahead();
+
+private:
+    const char*       _data = nullptr;
+    size_t            _size = 0;
+    bool              _isOpen = false;
+    std::future<void> _readahead;
+
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,347 @@
+#include "pipeline_builder.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "toolset.hpp"
+#include "initializers.hpp"
+
+namespace tlr
+{
+
+namespace
+{
+
+template <typename T>
+void AppendBytes(std::string& key, const T& value)
+{
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendString(std::string& key, const std::string& value)
+{
+    AppendBytes(key, static_cast<uint32_t>(value.size()));
+    key.append(value);
+}
+
+} // namespace
+
+PipelineBuilder& PipelineBuilder::AddShaderStage(const VkPipelineShaderStageCreateInfo& stage)
+{
+    _stages.push_back({stage.stage, stage.module, stage.pName ? stage.pName : "main"});
+    return Invalidate();
+}
+
+PipelineBuilder& PipelineBuilder::SetVertexInput(const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription* attributes, uint32_t attributeCount)
+{
+    _bindings.clear();
+    _attributes.clear();
+    return AddVertexInput(binding, attributes, attributeCount);
+}
+
+PipelineBuilder& PipelineBuilder::AddVertexInput(const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription* attributes, uint32_t attributeCount)
+{
+    _bindings.push_back(binding);
+    _attributes.insert(_attributes.end(), attributes, attributes + attributeCount);
+    return Invalidate();
+}
+
+PipelineBuilder& PipelineBuilder::SetTopology(VkPrimitiveTopology topology)
+{
+    _topology = topology;
+    return Invalidate();
+}
+
+PipelineBuilder& PipelineBuilder::SetRasterization(VkPolygonMode polygonMode, VkCullModeFlags cullMode, VkFrontFace frontFace)
+{
+    _polygonMode = polygonMode;
+    _cullMode = cullMode;
+    _frontFace = frontFace;
+    return Invalidate();
+}
+
+PipelineBuilder& PipelineBuilder::SetDepth(VkBool32 testEnable, VkBool32 writeEnable, VkCompareOp compareOp)
+{
+    _depthTest = testEnable;
+    _depthWrite = writeEnable;
+    _depthCompareOp = compareOp;
+    return Invalidate();
+}
+
+PipelineBuilder& PipelineBuilder::SetBlendMode(BlendMode mode)
+{
+    _blendMode = mode;
+    return Invalidate();
+}
+
+PipelineBuilder& PipelineBuilder::SetSampleCount(VkSampleCountFlagBits sampleCount)
+{
+    _sampleCount = sampleCount;
+    return Invalidate();
+}
+
+PipelineBuilder& PipelineBuilder::SetLayout(VkPipelineLayout layout)
+{
+    _layout = layout;
+    return Invalidate();
+}
+
+PipelineBuilder& PipelineBuilder::SetRenderPass(VkRenderPass renderPass, uint32_t subpass)
+{
+    _renderPass = renderPass;
+    _subpass = subpass;
+    return Invalidate();
+}
+
+const std::string& PipelineBuilder::GetKey() const
+{
+    if (!_isKeyDirty)
+    {
+        return _key;
+    }
+
+    // Field by field, so struct padding never ends up in the key.
+    _key.clear();
+    AppendBytes(_key, static_cast<uint32_t>(_stages.size()));
+    for (const ShaderStage& stage : _stages)
+    {
+        AppendBytes(_key, stage.stage);
+        AppendBytes(_key, stage.module);
+        AppendString(_key, stage.entryPoint);
+    }
+
+    AppendBytes(_key, static_cast<uint32_t>(_bindings.size()));
+    for (const VkVertexInputBindingDescription& binding : _bindings)
+    {
+        AppendBytes(_key, binding.binding);
+        AppendBytes(_key, binding.stride);
+        AppendBytes(_key, binding.inputRate);
+    }
+    AppendBytes(_key, static_cast<uint32_t>(_attributes.size()));
+    for (const VkVertexInputAttributeDescription& attribute : _attributes)
+    {
+        AppendBytes(_key, attribute.location);
+        AppendBytes(_key, attribute.binding);
+        AppendBytes(_key, attribute.format);
+        AppendBytes(_key, attribute.offset);
+    }
+
+    AppendBytes(_key, _topology);
+    AppendBytes(_key, _polygonMode);
+    AppendBytes(_key, _cullMode);
+    AppendBytes(_key, _frontFace);
+    AppendBytes(_key, _depthTest);
+    AppendBytes(_key, _depthWrite);
+    AppendBytes(_key, _depthCompareOp);
+    AppendBytes(_key, _blendMode);
+    AppendBytes(_key, _sampleCount);
+    AppendBytes(_key, _layout);
+    AppendBytes(_key, _renderPass);
+    AppendBytes(_key, _subpass);
+
+    _isKeyDirty = false;
+    return _key;
+}
+
+uint64_t PipelineBuilder::GetHash() const
+{
+    const std::string& key = GetKey();
+    return tools::HashBytes(key.data(), key.size());
+}
+
+VkPipeline PipelineBuilder::Build(VkDevice device, VkPipelineCache cache) const
+{
+    if (_stages.empty() || _layout == VK_NULL_HANDLE || _renderPass == VK_NULL_HANDLE)
+    {
+        throw std::runtime_error("pipeline builder needs shaders, a layout and a render pass!");
+    }
+
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+    shaderStages.reserve(_stages.size());
+    for (const ShaderStage& stage : _stages)
+    {
+        VkPipelineShaderStageCreateInfo stageCI = init::PipelineShaderStageCreateInfo(stage.stage, stage.module);
+        stageCI.pName = stage.entryPoint.c_str();
+        shaderStages.push_back(stageCI);
+    }
+
+    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicStateCI = init::PipelineDynamicStateCreateInfo(dynamicStates, 0);
+
+    VkPipelineVertexInputStateCreateInfo vertexInputCI = init::PipelineVertexInputStateCreateInfo();
+    vertexInputCI.vertexBindingDescriptionCount = static_cast<uint32_t>(_bindings.size());
+    vertexInputCI.pVertexBindingDescriptions = _bindings.data();
+    vertexInputCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(_attributes.size());
+    vertexInputCI.pVertexAttributeDescriptions = _attributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyCI = init::PipelineInputAssemblyStateCreateInfo(_topology, 0, VK_FALSE);
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = _depthTest;
+    depthStencil.depthWriteEnable = _depthWrite;
+    depthStencil.depthCompareOp = _depthCompareOp;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.minDepthBounds = 0.0f;
+    depthStencil.maxDepthBounds = 1.0f;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
+    // Only the counts matter here, the actual viewport and scissor are set while recording.
+    VkPipelineViewportStateCreateInfo viewportStateCI{};
+    viewportStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportStateCI.viewportCount = 1;
+    viewportStateCI.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer = init::PipelineRasterizationStateCreateInfo(_polygonMode, _cullMode, _frontFace, 0);
+
+    VkPipelineMultisampleStateCreateInfo multisampling = init::PipelineMultisampleStateCreateInfo(_sampleCount, 0);
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment = init::PipelineColorBlendAttachmentState(VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT, _blendMode != BlendMode::DISABLED);
+    if (_blendMode != BlendMode::DISABLED)
+    {
+        colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        colorBlendAttachment.dstColorBlendFactor = _blendMode == BlendMode::ALPHA ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        colorBlendAttachment.dstAlphaBlendFactor = _blendMode == BlendMode::ALPHA ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    }
+    VkPipelineColorBlendStateCreateInfo colorBlending = init::PipelineColorBlendStateCreateInfo(1, &colorBlendAttachment);
+
+    VkGraphicsPipelineCreateInfo pipelineCI = init::PipelineCreateInfo();
+    pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
+    pipelineCI.pStages = shaderStages.data();
+    pipelineCI.pVertexInputState = &vertexInputCI;
+    pipelineCI.pInputAssemblyState = &inputAssemblyCI;
+    pipelineCI.pViewportState = &viewportStateCI;
+    pipelineCI.pRasterizationState = &rasterizer;
+    pipelineCI.pMultisampleState = &multisampling;
+    pipelineCI.pColorBlendState = &colorBlending;
+    pipelineCI.pDynamicState = &dynamicStateCI;
+    pipelineCI.pDepthStencilState = &depthStencil;
+    pipelineCI.renderPass = _renderPass;
+    pipelineCI.layout = _layout;
+    pipelineCI.subpass = _subpass;
+
+    // Thrown instead of asserted, a failed compile has to reach the library's promise in release builds too.
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateGraphicsPipelines(device, cache, 1, &pipelineCI, nullptr, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create graphics pipeline: " + tools::ErrorString(result) + "!");
+    }
+    return pipeline;
+}
+
+PipelineBuilder& PipelineBuilder::Invalidate()
+{
+    _isKeyDirty = true;
+    return *this;
+}
+
+void PipelineLibrary::Init(VkDevice device, VkPipelineCache cache, uint32_t threadCount)
+{
+    _device = device;
+    _cache = cache;
+    _threadPool = std::make_unique<ThreadPool>(threadCount);
+}
+
+void PipelineLibrary::Destroy()
+{
+    WaitIdle();
+    _threadPool.reset();
+
+    for (const auto& entry : _entries)
+    {
+        vkDestroyPipeline(_device, entry->pipeline.load(std::memory_order_acquire), nullptr);
+    }
+    _entries.clear();
+    _lookup.clear();
+}
+
+void PipelineLibrary::WaitIdle()
+{
+    if (_threadPool)
+    {
+        _threadPool->Wait();
+    }
+}
+
+PipelineHandle PipelineLibrary::Request(const PipelineBuilder& builder)
+{
+    const std::string& key = builder.GetKey();
+    auto it = _lookup.find(key);
+    if (it != _lookup.end())
+    {
+        ++_hitCount;
+        return {it->second};
+    }
+
+    uint32_t index = static_cast<uint32_t>(_entries.size());
+    _entries.push_back(std::make_unique<Entry>());
+    Entry* entry = _entries.back().get();
+    entry->builder = builder;
+    entry->future = entry->promise.get_future().share();
+    _lookup.emplace(key, index);
+
+    // The entry stays where it is while the table grows, the worker only ever touches its own.
+    _threadPool->Submit([this, entry]()
+    {
+        try
+        {
+            VkPipeline pipeline = entry->builder.Build(_device, _cache);
+            entry->pipeline.store(pipeline, std::memory_order_release);
+            entry->promise.set_value(pipeline);
+        }
+        catch (...)
+        {
+            // Surfaces on Wait, Get keeps returning VK_NULL_HANDLE.
+            entry->promise.set_exception(std::current_exception());
+        }
+    });
+    return {index};
+}
+
+VkPipeline PipelineLibrary::Get(PipelineHandle handle) const
+{
+    if (!handle.IsValid() || handle.index >= _entries.size())
+    {
+        return VK_NULL_HANDLE;
+    }
+    return _entries[handle.index]->pipeline.load(std::memory_order_acquire);
+}
+
+bool PipelineLibrary::IsReady(PipelineHandle handle) const
+{
+    return Get(handle) != VK_NULL_HANDLE;
+}
+
+VkPipeline PipelineLibrary::Wait(PipelineHandle handle) const
+{
+    if (!handle.IsValid() || handle.index >= _entries.size())
+    {
+        throw std::runtime_error("invalid pipeline handle!");
+    }
+    return _entries[handle.index]->future.get();
+}
+
+std::shared_future<VkPipeline> PipelineLibrary::GetFuture(PipelineHandle handle) const
+{
+    if (!handle.IsValid() || handle.index >= _entries.size())
+    {
+        throw std::runtime_error("invalid pipeline handle!");
+    }
+    return _entries[handle.index]->future;
+}
+
+uint32_t PipelineLibrary::GetPipelineCount() const
+{
+    return static_cast<uint32_t>(_entries.size());
+}
+
+uint32_t PipelineLibrary::GetHitCount() const
+{
+    return _hitCount;
+}
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "thread_pool.hpp"
+
+namespace tlr
+{
+
+enum class BlendMode
+{
+    DISABLED,
+    ALPHA,    // src * srcAlpha + dst * (1 - srcAlpha)
+    ADDITIVE  // src * srcAlpha + dst
+};
+
+// Describes one graphics pipeline. Viewport and scissor are always dynamic, so the state doesn't depend on the
+// swapchain extent and a resize never invalidates it. The defaults match what the finished projects used before:
+// triangle lists, back face culling with clockwise front faces, depth test and write with LESS, no blending.
+class PipelineBuilder
+{
+public:
+    PipelineBuilder() = default;
+
+    PipelineBuilder& AddShaderStage(const VkPipelineShaderStageCreateInfo& stage);
+    PipelineBuilder& SetVertexInput(const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription* attributes, uint32_t attributeCount);
+    // Appends another binding, e.g. per-instance data next to the vertices.
+    PipelineBuilder& AddVertexInput(const VkVertexInputBindingDescription& binding, const VkVertexInputAttributeDescription* attributes, uint32_t attributeCount);
+    PipelineBuilder& SetTopology(VkPrimitiveTopology topology);
+    PipelineBuilder& SetRasterization(VkPolygonMode polygonMode, VkCullModeFlags cullMode, VkFrontFace frontFace);
+    PipelineBuilder& SetDepth(VkBool32 testEnable, VkBool32 writeEnable, VkCompareOp compareOp = VK_COMPARE_OP_LESS);
+    PipelineBuilder& SetBlendMode(BlendMode mode);
+    PipelineBuilder& SetSampleCount(VkSampleCountFlagBits sampleCount);
+    PipelineBuilder& SetLayout(VkPipelineLayout layout);
+    PipelineBuilder& SetRenderPass(VkRenderPass renderPass, uint32_t subpass = 0);
+
+    template <typename Attributes>
+    PipelineBuilder& SetVertexInput(const VkVertexInputBindingDescription& binding, const Attributes& attributes)
+    {
+        return SetVertexInput(binding, attributes.data(), static_cast<uint32_t>(attributes.size()));
+    }
+
+    template <typename Attributes>
+    PipelineBuilder& AddVertexInput(const VkVertexInputBindingDescription& binding, const Attributes& attributes)
+    {
+        return AddVertexInput(binding, attributes.data(), static_cast<uint32_t>(attributes.size()));
+    }
+
+    // Covers every field that ends up in the create info, two builders with the same key build the same pipeline.
+    const std::string& GetKey() const;
+    uint64_t           GetHash() const;
+
+    // Compiles on the calling thread.
+    VkPipeline Build(VkDevice device, VkPipelineCache cache) const;
+
+private:
+    struct ShaderStage
+    {
+        VkShaderStageFlagBits stage;
+        VkShaderModule        module;
+        std::string           entryPoint;
+    };
+
+    std::vector<ShaderStage>                       _stages;
+    std::vector<VkVertexInputBindingDescription>   _bindings;
+    std::vector<VkVertexInputAttributeDescription> _attributes;
+    VkPrimitiveTopology                            _topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPolygonMode                                  _polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags                                _cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace                                    _frontFace = VK_FRONT_FACE_CLOCKWISE;
+    VkBool32                                       _depthTest = VK_TRUE;
+    VkBool32                                       _depthWrite = VK_TRUE;
+    VkCompareOp                                    _depthCompareOp = VK_COMPARE_OP_LESS;
+    BlendMode                                      _blendMode = BlendMode::DISABLED;
+    VkSampleCountFlagBits                          _sampleCount = VK_SAMPLE_COUNT_1_BIT;
+    VkPipelineLayout                               _layout = VK_NULL_HANDLE;
+    VkRenderPass                                   _renderPass = VK_NULL_HANDLE;
+    uint32_t                                       _subpass = 0;
+
+    mutable std::string _key;
+    mutable bool        _isKeyDirty = true;
+
+    PipelineBuilder& Invalidate();
+};
+
+struct PipelineHandle
+{
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    uint32_t index = INVALID_INDEX;
+
+    bool IsValid() const
+    {
+        return index != INVALID_INDEX;
+    }
+};
+
+// Owns the pipelines built from PipelineBuilders. Requesting a state that was seen before returns the existing
+// handle, new states compile on worker threads through the pipeline cache. Until a pipeline is ready Get returns
+// VK_NULL_HANDLE, the renderer either skips the draw or falls back to a pipeline that is.
+// Request and Get are meant for the render thread. Shader modules and layouts a builder refers to must stay alive
+// until its pipeline is ready, modules from the ShaderModuleCache always are.
+class PipelineLibrary
+{
+public:
+    void Init(VkDevice device, VkPipelineCache cache, uint32_t threadCount = 1);
+    // Waits for the compiles in flight, then destroys every pipeline.
+    void Destroy();
+    // Call before destroying layouts or shader modules that a pending compile may still read.
+    void WaitIdle();
+
+    PipelineHandle Request(const PipelineBuilder& builder);
+
+    VkPipeline Get(PipelineHandle handle) const;
+    bool       IsReady(PipelineHandle handle) const;
+    // Blocks until the pipeline is compiled, for the ones a frame can't go without.
+    VkPipeline Wait(PipelineHandle handle) const;
+    std::shared_future<VkPipeline> GetFuture(PipelineHandle handle) const;
+
+    uint32_t GetPipelineCount() const;
+    uint32_t GetHitCount() const;
+
+private:
+    struct Entry
+    {
+        PipelineBuilder                builder;
+        std::atomic<VkPipeline>        pipeline{VK_NULL_HANDLE};
+        std::promise<VkPipeline>       promise;
+        std::shared_future<VkPipeline> future;
+    };
+
+    VkDevice                                  _device = VK_NULL_HANDLE;
+    VkPipelineCache                           _cache = VK_NULL_HANDLE;
+    std::unique_ptr<ThreadPool>               _threadPool;
+    std::vector<std::unique_ptr<Entry>>       _entries;
+    std::unordered_map<std::string, uint32_t> _lookup;
+    uint32_t                                  _hitCount = 0;
+};
+
+} // namespace tlr
\ No newline at end of file
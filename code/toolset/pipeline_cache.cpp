@@ -0,0 +1,140 @@
+#include "pipeline_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "toolset.hpp"
+
+namespace tlr
+{
+
+void PipelineCache::Init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path)
+{
+    _device = device;
+    _path = path;
+
+    VkPhysicalDeviceIDProperties idProperties{};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &idProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    _header.magic = FILE_MAGIC;
+    _header.version = FILE_VERSION;
+    _header.vendorID = properties.properties.vendorID;
+    _header.deviceID = properties.properties.deviceID;
+    _header.driverVersion = properties.properties.driverVersion;
+    memcpy(_header.pipelineCacheUUID, properties.properties.pipelineCacheUUID, VK_UUID_SIZE);
+    memcpy(_header.deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+    memcpy(_header.driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+
+    // The driver copies the initial data, the mapping only has to outlive vkCreatePipelineCache. It must be closed
+    // before Save renames over the file though, Windows refuses to replace a mapped file.
+    MappedFile file;
+    FileView data;
+    _isWarm = !_path.empty() && ReadCacheData(file, data);
+
+    VkPipelineCacheCreateInfo cacheCI{};
+    cacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheCI.initialDataSize = _isWarm ? data.size : 0;
+    cacheCI.pInitialData = _isWarm ? data.data : nullptr;
+    VK_CHECK_RESULT(vkCreatePipelineCache(_device, &cacheCI, nullptr, &_cache));
+}
+
+void PipelineCache::Destroy()
+{
+    vkDestroyPipelineCache(_device, _cache, nullptr);
+    _cache = VK_NULL_HANDLE;
+}
+
+void PipelineCache::Save() const
+{
+    if (_path.empty())
+    {
+        return;
+    }
+
+    size_t dataSize = 0;
+    VK_CHECK_RESULT(vkGetPipelineCacheData(_device, _cache, &dataSize, nullptr));
+    std::vector<char> data(dataSize);
+    VK_CHECK_RESULT(vkGetPipelineCacheData(_device, _cache, &dataSize, data.data()));
+
+    FileHeader header = _header;
+    header.dataSize = dataSize;
+    header.dataHash = tools::HashBytes(data.data(), dataSize);
+
+    // Written next to the target and renamed over it, a crash mid-write can't leave a torn cache behind.
+    std::string tempPath = _path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to write pipeline cache: " << tempPath << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), dataSize);
+    }
+    std::remove(_path.c_str());
+    if (std::rename(tempPath.c_str(), _path.c_str()) != 0)
+    {
+        std::cerr << "Failed to replace pipeline cache: " << _path << std::endl;
+    }
+}
+
+bool PipelineCache::IsWarm() const
+{
+    return _isWarm;
+}
+
+bool PipelineCache::ReadCacheData(MappedFile& file, FileView& data) const
+{
+    if (!file.Open(_path))
+    {
+        return false;
+    }
+    uint64_t fileSize = file.GetSize();
+
+    FileHeader header{};
+    if (fileSize < sizeof(header))
+    {
+        std::cerr << "Pipeline cache " << _path << " is truncated, starting cold." << std::endl;
+        return false;
+    }
+    memcpy(&header, file.GetData(), sizeof(header));
+
+    if (header.magic != _header.magic || header.version != _header.version)
+    {
+        std::cerr << "Pipeline cache " << _path << " has an unknown format, starting cold." << std::endl;
+        return false;
+    }
+
+    if (header.vendorID != _header.vendorID || header.deviceID != _header.deviceID || header.driverVersion != _header.driverVersion ||
+        memcmp(header.pipelineCacheUUID, _header.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+        memcmp(header.deviceUUID, _header.deviceUUID, VK_UUID_SIZE) != 0 ||
+        memcmp(header.driverUUID, _header.driverUUID, VK_UUID_SIZE) != 0)
+    {
+        std::cout << "Pipeline cache " << _path << " belongs to another device or driver, starting cold." << std::endl;
+        return false;
+    }
+
+    if (header.dataSize != fileSize - sizeof(header))
+    {
+        std::cerr << "Pipeline cache " << _path << " is truncated, starting cold." << std::endl;
+        return false;
+    }
+
+    data = file.GetView(sizeof(header), header.dataSize);
+    if (tools::HashBytes(data.data, data.size) != header.dataHash)
+    {
+        std::cerr << "Pipeline cache " << _path << " is corrupt, starting cold." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace tlr
\ No newline at end of file
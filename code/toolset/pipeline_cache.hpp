@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+#include "mapped_file.hpp"
+
+namespace tlr
+{
+
+// Wraps a VkPipelineCache that is loaded from and saved to disk. The file carries the identity of the device and
+// driver that produced it, data from any other GPU or driver update is dropped and the cache starts out empty.
+class PipelineCache
+{
+public:
+    void Init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path);
+    void Destroy();
+
+    // Writes the current cache contents, does nothing without a path.
+    void Save() const;
+
+    // True when the cache was filled from disk, pipelines created through it should skip compilation.
+    bool IsWarm() const;
+
+    operator VkPipelineCache() const
+    {
+        return _cache;
+    }
+
+private:
+    static constexpr uint32_t FILE_MAGIC = 0x43505654; // "TVPC"
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+        uint8_t  deviceUUID[VK_UUID_SIZE];
+        uint8_t  driverUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+
+    VkDevice        _device = VK_NULL_HANDLE;
+    VkPipelineCache _cache = VK_NULL_HANDLE;
+    FileHeader      _header{};
+    std::string     _path;
+    bool            _isWarm = false;
+
+    bool ReadCacheData(MappedFile& file, FileView& data) const;
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -8,13 +8,26 @@ namespace tlr
 
 ShaderModule::ShaderModule(VkDevice& device, const std::string& spvPath, VkShaderStageFlagBits stage) : _device(device), _stage(stage)
 {
-    std::vector<char> shaderCode = tools::ReadFile(spvPath);
-    _shaderModule = CreateShaderModule(shaderCode);
+    MappedFile shaderCode = tools::ReadFile(spvPath);
+    _shaderModule = CreateShaderModule(shaderCode.GetView());
+}
+
+ShaderModule::ShaderModule(ShaderModuleCache& cache, const std::string& spvPath, VkShaderStageFlagBits stage) : _stage(stage)
+{
+    _shaderModule = cache.Load(spvPath);
+}
+
+ShaderModule::ShaderModule(ShaderModuleCache& cache, const EmbeddedShader& shader) : _stage(shader.stage)
+{
+    _shaderModule = cache.Create(shader.code, shader.wordCount * sizeof(uint32_t));
 }
 
 ShaderModule::~ShaderModule()
 {
-    vkDestroyShaderModule(_device, _shaderModule, nullptr);
+    if (_device != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(_device, _shaderModule, nullptr);
+    }
 }
 
 VkPipelineShaderStageCreateInfo ShaderModule::GetCreateInfo()
@@ -22,12 +35,12 @@ VkPipelineShaderStageCreateInfo ShaderModule::GetCreateInfo()
     return init::PipelineShaderStageCreateInfo(_stage, _shaderModule);
 }
 
-VkShaderModule ShaderModule::CreateShaderModule(const std::vector<char>& code)
+VkShaderModule ShaderModule::CreateShaderModule(FileView code)
 {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    createInfo.codeSize = code.size;
+    createInfo.pCode = code.As<uint32_t>();
 
     VkShaderModule shaderModule;
     VK_CHECK_RESULT(vkCreateShaderModule(_device, &createInfo, nullptr, &shaderModule));
@@ -1,27 +1,45 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <string>
 
 #include <vulkan/vulkan.h>
 
+#include "mapped_file.hpp"
+#include "shader_module_cache.hpp"
+
 namespace tlr
 {
 
+// SPIR-V compiled into the binary by add_embedded_shaders(), see cmake/shaders.cmake.
+struct EmbeddedShader
+{
+    const char*           name;
+    VkShaderStageFlagBits stage;
+    const uint32_t*       code;
+    size_t                wordCount;
+};
+
 class ShaderModule
 {
 public:
     ShaderModule(VkDevice& device, const std::string& spvPath, VkShaderStageFlagBits stage);
+
+    // Borrows the module from the cache, it outlives this object.
+    ShaderModule(ShaderModuleCache& cache, const std::string& spvPath, VkShaderStageFlagBits stage);
+    ShaderModule(ShaderModuleCache& cache, const EmbeddedShader& shader);
     ~ShaderModule();
 
     VkPipelineShaderStageCreateInfo GetCreateInfo();
 
 private:
-    VkDevice& _device;
+    VkDevice _device = VK_NULL_HANDLE; // only set when the module is owned
     VkShaderStageFlagBits _stage;
     VkShaderModule _shaderModule;
 
-    VkShaderModule CreateShaderModule(const std::vector<char>& code);
+    VkShaderModule CreateShaderModule(FileView code);
 };
 
 } // namespace tlr
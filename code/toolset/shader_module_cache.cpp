@@ -0,0 +1,86 @@
+#include "shader_module_cache.hpp"
+
+#include <cstring>
+
+#include "toolset.hpp"
+
+namespace tlr
+{
+
+void ShaderModuleCache::Init(VkDevice device)
+{
+    _device = device;
+}
+
+void ShaderModuleCache::Destroy()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& [hash, entry] : _modules)
+    {
+        vkDestroyShaderModule(_device, entry.module, nullptr);
+    }
+    _modules.clear();
+    _pathModules.clear();
+}
+
+VkShaderModule ShaderModuleCache::Load(const std::string& spvPath)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _pathModules.find(spvPath);
+    if (it != _pathModules.end())
+    {
+        ++_hitCount;
+        return it->second;
+    }
+
+    MappedFile code = tools::ReadFile(spvPath);
+    VkShaderModule module = CreateLocked(code.GetView().As<uint32_t>(), code.GetSize());
+    _pathModules.emplace(spvPath, module);
+    return module;
+}
+
+VkShaderModule ShaderModuleCache::Create(const uint32_t* code, size_t codeSize)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return CreateLocked(code, codeSize);
+}
+
+uint32_t ShaderModuleCache::GetModuleCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return static_cast<uint32_t>(_modules.size());
+}
+
+uint32_t ShaderModuleCache::GetHitCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hitCount;
+}
+
+VkShaderModule ShaderModuleCache::CreateLocked(const uint32_t* code, size_t codeSize)
+{
+    uint64_t hash = tools::HashBytes(code, codeSize);
+    auto [first, last] = _modules.equal_range(hash);
+    for (auto it = first; it != last; ++it)
+    {
+        const std::vector<uint32_t>& entryCode = it->second.code;
+        if (entryCode.size() * sizeof(uint32_t) == codeSize && std::memcmp(entryCode.data(), code, codeSize) == 0)
+        {
+            ++_hitCount;
+            return it->second.module;
+        }
+    }
+
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = codeSize;
+    createInfo.pCode = code;
+
+    VkShaderModule module;
+    VK_CHECK_RESULT(vkCreateShaderModule(_device, &createInfo, nullptr, &module));
+    _modules.emplace(hash, Entry{std::vector<uint32_t>(code, code + codeSize / sizeof(uint32_t)), module});
+    return module;
+}
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace tlr
+{
+
+// Keeps every VkShaderModule alive until Destroy and hands out the same module for identical SPIR-V. Paths are
+// remembered too, so recreating a pipeline doesn't touch the file system again.
+class ShaderModuleCache
+{
+public:
+    void Init(VkDevice device);
+    void Destroy();
+
+    VkShaderModule Load(const std::string& spvPath);
+    VkShaderModule Create(const uint32_t* code, size_t codeSize);
+
+    uint32_t GetModuleCount() const;
+    uint32_t GetHitCount() const;
+
+private:
+    // The words are kept so a hash hit can be confirmed, SPIR-V modules are a few kilobytes at most.
+    struct Entry
+    {
+        std::vector<uint32_t> code;
+        VkShaderModule        module;
+    };
+
+    VkDevice                                        _device = VK_NULL_HANDLE;
+    std::unordered_multimap<uint64_t, Entry>        _modules;     // keyed by the hash of the SPIR-V, colliding modules share a key
+    std::unordered_map<std::string, VkShaderModule> _pathModules;
+    uint32_t                                        _hitCount = 0;
+    mutable std::mutex                              _mutex;
+
+    VkShaderModule CreateLocked(const uint32_t* code, size_t codeSize);
+};
+
+} // namespace tlr
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tlr
+{
+
+// Compile-time queries on embedded SPIR-V, meant for static_asserts that keep C++ structs in sync with the shader
+// blocks they are copied into. Blocks and members are looked up by the names glslc keeps in OpName/OpMemberName.
+namespace spirv
+{
+
+constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+constexpr uint32_t HEADER_WORD_COUNT = 5;
+constexpr uint32_t OP_NAME = 5;
+constexpr uint32_t OP_MEMBER_NAME = 6;
+constexpr uint32_t OP_MEMBER_DECORATE = 72;
+constexpr uint32_t DECORATION_OFFSET = 35;
+
+// Literal strings are packed four chars per word, little endian and null terminated.
+constexpr bool LiteralEquals(const uint32_t* words, size_t wordCount, const char* string)
+{
+    for (size_t i = 0; i < wordCount * 4; ++i)
+    {
+        char c = static_cast<char>((words[i / 4] >> (8 * (i % 4))) & 0xff);
+        if (c != string[i])
+        {
+            return false;
+        }
+        if (c == '\0')
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <size_t N>
+constexpr uint32_t FindNamedId(const uint32_t (&code)[N], const char* name)
+{
+    for (size_t i = HEADER_WORD_COUNT; i < N;)
+    {
+        uint32_t wordCount = code[i] >> 16;
+        uint32_t opcode = code[i] & 0xffff;
+        if (opcode == OP_NAME && LiteralEquals(&code[i + 2], wordCount - 2, name))
+        {
+            return code[i + 1];
+        }
+        i += wordCount == 0 ? 1 : wordCount;
+    }
+    return NOT_FOUND;
+}
+
+template <size_t N>
+constexpr uint32_t FindMemberIndex(const uint32_t (&code)[N], uint32_t structId, const char* memberName)
+{
+    for (size_t i = HEADER_WORD_COUNT; i < N;)
+    {
+        uint32_t wordCount = code[i] >> 16;
+        uint32_t opcode = code[i] & 0xffff;
+        if (opcode == OP_MEMBER_NAME && code[i + 1] == structId && LiteralEquals(&code[i + 3], wordCount - 3, memberName))
+        {
+            return code[i + 2];
+        }
+        i += wordCount == 0 ? 1 : wordCount;
+    }
+    return NOT_FOUND;
+}
+
+// Byte offset of a block member as laid out by the shader, NOT_FOUND if the block or member doesn't exist.
+template <size_t N>
+constexpr uint32_t MemberOffset(const uint32_t (&code)[N], const char* blockName, const char* memberName)
+{
+    uint32_t structId = FindNamedId(code, blockName);
+    uint32_t memberIndex = structId == NOT_FOUND ? NOT_FOUND : FindMemberIndex(code, structId, memberName);
+    if (memberIndex == NOT_FOUND)
+    {
+        return NOT_FOUND;
+    }
+
+    for (size_t i = HEADER_WORD_COUNT; i < N;)
+    {
+        uint32_t wordCount = code[i] >> 16;
+        uint32_t opcode = code[i] & 0xffff;
+        if (opcode == OP_MEMBER_DECORATE && code[i + 1] == structId && code[i + 2] == memberIndex && code[i + 3] == DECORATION_OFFSET)
+        {
+            return code[i + 4];
+        }
+        i += wordCount == 0 ? 1 : wordCount;
+    }
+    return NOT_FOUND;
+}
+
+template <size_t N>
+constexpr uint32_t MemberCount(const uint32_t (&code)[N], const char* blockName)
+{
+    uint32_t structId = FindNamedId(code, blockName);
+    uint32_t count = 0;
+    for (size_t i = HEADER_WORD_COUNT; i < N && structId != NOT_FOUND;)
+    {
+        uint32_t wordCount = code[i] >> 16;
+        uint32_t opcode = code[i] & 0xffff;
+        if (opcode == OP_MEMBER_NAME && code[i + 1] == structId)
+        {
+            ++count;
+        }
+        i += wordCount == 0 ? 1 : wordCount;
+    }
+    return count;
+}
+
+} // namespace spirv
+
+} // namespace tlr
\ No newline at end of file
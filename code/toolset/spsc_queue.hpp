@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace tlr
+{
+
+// Bounded single producer single consumer queue. One thread may push and one other thread may pop at the same time
+// without locks, neither side ever blocks. Head and tail sit on separate cache lines so the two sides don't bounce
+// one line between their cores.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two!");
+
+public:
+    // Producer side, returns false if the queue is full.
+    bool TryPush(const T& value)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cachedHead == Capacity)
+        {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if (tail - _cachedHead == Capacity)
+            {
+                return false;
+            }
+        }
+        _items[tail & (Capacity - 1)] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false if the queue is empty.
+    bool TryPop(T& value)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _cachedTail)
+        {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            if (head == _cachedTail)
+            {
+                return false;
+            }
+        }
+        value = _items[head & (Capacity - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // Both counters only grow, the slot is the counter modulo the capacity.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _head{0};
+    size_t                                       _cachedTail = 0; // consumer's last look at the tail
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _tail{0};
+    size_t                                       _cachedHead = 0; // producer's last look at the head
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> _items{};
+};
+
+} // namespace tlr
\ No newline at end of file
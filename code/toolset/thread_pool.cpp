@@ -0,0 +1,90 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tlr
+{
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        throw std::runtime_error("thread pool needs at least one thread!");
+    }
+
+    _workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        _workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+    }
+    _taskAvailable.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()>&& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push(std::move(task));
+        ++_unfinishedTaskCount;
+    }
+    _taskAvailable.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _tasksFinished.wait(lock, [this]() { return _unfinishedTaskCount == 0; });
+}
+
+uint32_t ThreadPool::GetThreadCount() const
+{
+    return static_cast<uint32_t>(_workers.size());
+}
+
+uint32_t ThreadPool::GetHardwareThreadCount()
+{
+    // hardware_concurrency() is allowed to report 0 when it cannot tell.
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _taskAvailable.wait(lock, [this]() { return _isStopping || !_tasks.empty(); });
+            if (_isStopping && _tasks.empty())
+            {
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop();
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --_unfinishedTaskCount;
+        }
+        _tasksFinished.notify_all();
+    }
+}
+
+} // namespace tlr
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace tlr
+{
+
+class ThreadPool
+{
+public:
+    ThreadPool(uint32_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void     Submit(std::function<void()>&& task);
+    void     Wait();
+    uint32_t GetThreadCount() const;
+
+    static uint32_t GetHardwareThreadCount();
+
+private:
+    std::vector<std::thread>          _workers;
+    std::queue<std::function<void()>> _tasks;
+    std::mutex                        _mutex;
+    std::condition_variable           _taskAvailable;
+    std::condition_variable           _tasksFinished;
+    uint32_t                          _unfinishedTaskCount = 0;
+    bool                              _isStopping = false;
+
+    void WorkerLoop();
+};
+
+} // namespace tlr
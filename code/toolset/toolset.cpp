@@ -50,19 +50,21 @@ namespace tlr
         }
     }
 
-    std::vector<char> ReadFile(const std::string& filename)
+    MappedFile ReadFile(const std::string& filename)
     {
-        std::ifstream file(filename, std::ios::ate | std::ios::binary);
-        if (!file.is_open())
+        return MappedFile(filename);
+    }
+
+    uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; ++i)
         {
-            throw std::runtime_error("failed to open file!");
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
         }
-        size_t fileSize = static_cast<size_t>(file.tellg());
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
-        return buffer;
+        return hash;
     }
 
     } // namespace tools
@@ -18,6 +18,8 @@
 
 #include <vulkan/vulkan.h>
 
+#include "mapped_file.hpp"
+
 #define VK_CHECK_RESULT(f)																									   	   \
 {																															   	   \
 	VkResult res = (f);																										   	   \
@@ -36,7 +38,11 @@ namespace tlr
 		
 	std::string ErrorString(VkResult errorCode);
 
-	std::vector<char> ReadFile(const std::string& filename);
+	// Maps the file instead of copying it, the returned object keeps the data alive. Throws if it can't be opened.
+	MappedFile ReadFile(const std::string& filename);
+
+	// 64-bit FNV-1a, stable across runs so it can key on-disk data.
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
 
 	} // namespace tools
 